@@ -0,0 +1,147 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "globals/mvimResources.h"
+#include "documentStates.hpp"
+#include "textBuffer.hpp"
+
+struct Language;
+
+/**
+ * @class BackgroundHighlighter
+ * @brief Styles the whole document on a worker thread, ahead of and behind the window.
+ *
+ * The result of every styled row is kept as a few color spans, so a row
+ * scrolled into the window is copied from the cache instead of being lexed
+ * in the frame. The render thread hands the worker copies of the rows to
+ * style (a consistent snapshot of each chunk) tagged with the buffer
+ * version; results for an older version are thrown away when they come
+ * back. The cache itself is only touched by the render thread and follows
+ * the buffer's edit journal, so an edit only drops the rows it changed.
+ * Each document keeps its own cache, so switching back to a buffer finds
+ * its rows already styled.
+ */
+class BackgroundHighlighter {
+public:
+    static BackgroundHighlighter& instance() {
+        static BackgroundHighlighter instance;
+        return instance;
+    }
+
+    ~BackgroundHighlighter();
+
+    /**
+     * @brief Colors a row from the cache, if it was styled from the same start state.
+     * @param in_comment Whether the row starts inside a multi-line comment.
+     * @param colors Set to the colors of the row when found.
+     * @param end_state Set to the state at the end of the row when found.
+     * @return False when the row must be styled by the caller.
+     */
+    bool lookup(const textBuffer& text, size_t row, bool in_comment, std::vector<color>& colors, bool& end_state);
+
+    /**
+     * @brief Keeps a row styled by the caller, so the worker does not style it again.
+     */
+    void store(const textBuffer& text, size_t row, bool in_comment, const std::vector<color>& colors, bool end_state);
+
+    /**
+     * @brief Called once per frame: takes in the worker's results and gives it
+     * the next rows, nearest to the window first.
+     * @param top The first row of the window.
+     */
+    void schedule(const textBuffer& text, size_t top);
+
+    /**
+     * @brief Waits until the worker has nothing left to do (for tests and benchmarks).
+     */
+    void wait_idle();
+
+    /**
+     * @brief Rows of the last document seen not in the cache yet.
+     */
+    size_t missing_rows();
+
+private:
+    BackgroundHighlighter() = default;
+    BackgroundHighlighter(const BackgroundHighlighter&) = delete;
+    BackgroundHighlighter& operator=(const BackgroundHighlighter&) = delete;
+
+    static constexpr size_t CHUNK_ROWS = 512;    // rows per job
+    static constexpr size_t BATCH_CHUNKS = 32;   // jobs handed over per frame
+
+    struct Span {
+        uint32_t from;
+        uint16_t length;
+        color c;
+    };
+
+    struct Entry {
+        bool valid = false;
+        bool start = false;      // state at the start of the row when styled
+        bool end = false;
+        std::vector<Span> spans; // every run not in textColor
+    };
+
+    struct Job {
+        unsigned long document;
+        unsigned long version;
+        const Language* lang;
+        size_t first;
+        bool start;
+        size_t limit;                    // longer rows are left plain, as on screen
+        std::vector<std::string> rows;
+    };
+
+    struct Result {
+        unsigned long document;
+        unsigned long version;
+        const Language* lang;
+        size_t first;
+        std::vector<Entry> entries;
+    };
+
+    // --- Render thread ---
+
+    // The cache of one document, kept while its buffer is in the background
+    struct Document {
+        std::vector<Entry> entries;
+        size_t missing = 0;
+        unsigned long version = 0;
+        const Language* language = nullptr;
+        bool built = false;
+        std::vector<std::pair<size_t, size_t>> inflight;  // (first, count) of the jobs of this version
+
+        void reset(size_t rows);
+        void invalidate(size_t row);
+        bool next_gap(size_t from, bool forward, size_t& row) const;
+    };
+
+    DocumentStates<Document> documents;
+    unsigned long active = 0;            // the document the queued jobs belong to
+    std::vector<BufferEdit> edits;
+
+    Document& sync(const textBuffer& text);
+    void drop_jobs();
+    void merge();
+    void post(const textBuffer& text, Document& document, size_t first, size_t count, std::vector<Job>& batch);
+
+    static void encode(const std::vector<color>& colors, Entry& entry);
+
+    // --- Shared with the worker, under lock ---
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Job> jobs;
+    std::vector<Result> results;
+    bool busy = false;
+    bool stopping = false;
+    std::thread worker;
+
+    void run();
+};
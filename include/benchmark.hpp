@@ -0,0 +1,128 @@
+#pragma once
+#include <functional>
+#include <string>
+#include "surface.hpp"
+
+/**
+ * @namespace benchmark
+ * @brief Measurements run by `mvim <file> -b`, without a terminal.
+ *
+ * The loaded file is drawn on an in-memory CellGrid, so the numbers cover
+ * the editor's own work (styling, building and placing cells) and not the
+ * terminal's.
+ */
+namespace benchmark
+{
+  /**
+   * @brief Runs fn the given number of times and prints the average time per call.
+   * @return The average time per call in microseconds.
+   */
+  double measure(const std::string& label, int iterations, const std::function<void()>& fn);
+
+  /**
+   * @brief Render and highlight cost per frame of the loaded buffer.
+   * @param grid The surface the frames are drawn on; the Screen must already target it.
+   */
+  void render(CellGrid& grid);
+
+  /**
+   * @brief Cost of the soft-wrap index: full build, one edit, and the
+   * lookups behind scrolling and mouse hit-testing.
+   */
+  void soft_wrap(CellGrid& grid);
+
+  /**
+   * @brief Keyword highlighting of the loaded rows with a 500-keyword language:
+   * one search per keyword against one pass of the keyword automaton.
+   */
+  void keywords();
+
+  /**
+   * @brief Page-sized jumps through a 500k-row document, with every row
+   * styled in the frame, then with the rows styled ahead by the background thread.
+   */
+  void background_highlight(CellGrid& grid);
+
+  /**
+   * @brief Startup cost of 200 installed language files (indexing only),
+   * against parsing and compiling all of them.
+   */
+  void language_loading();
+
+  /**
+   * @brief Bracket matching in a 100k-row document nested 50k deep: building
+   * the index, then matching the outermost pair after edits.
+   */
+  void brackets();
+
+  /**
+   * @brief Pathological rows: a 2 MB minified row, rows far wider than the
+   * window scrolled sideways, and a screen of rows styled within a small budget.
+   */
+  void long_lines(CellGrid& grid);
+
+  /**
+   * @brief Find over a 100 MB document with std::regex and with the
+   * linear-time matcher, then a pattern that makes backtracking blow up.
+   */
+  void regex_search();
+
+  /**
+   * @brief Search as you type on a 1M-row document: the first slice and the
+   * rest of each keystroke, and how many rows narrowing leaves to check.
+   */
+  void incremental_search();
+
+  /**
+   * @brief Find over 200 MB of log rows on 1, 2, 4 and 8 threads, and one per core.
+   */
+  void parallel_search();
+
+  /**
+   * @brief Plain-text search over 256 MB in GB/s: std::string::find against the
+   * vectorized finder, with and without case, then through find.
+   */
+  void literal_search();
+
+  /**
+   * @brief Keeping 2M search results in step with edits to a 1M-row document,
+   * against searching it all again.
+   */
+  void search_edits();
+
+  /**
+   * @brief The matches drawn in a frame out of 10M in the document: walking
+   * all of them, as before, against looking up the rows of the window.
+   */
+  void search_highlight();
+
+  /**
+   * @brief The time before the cursor moves to the match after it: searching the
+   * whole buffer first, as before, against stopping at the nearest match.
+   */
+  void search_from_cursor();
+
+  /**
+   * @brief Replacing 1M matches: one at a time with an undo record each, as
+   * before, against rebuilding each row once, and undoing it.
+   */
+  void replace_all();
+
+  /**
+   * @brief The search index of 100 MB of logs: how long it takes to build and
+   * how much memory it holds, and searches with it against searching every row.
+   */
+  void search_index();
+
+  /**
+   * @brief A search for a term that spans rows: the rows read in place against
+   * the rows joined into one string first, then a replacement joining them.
+   */
+  void multiline_search();
+
+  /**
+   * @brief A project search through 50k generated files: on one thread and on
+   * every core, against `grep -r` on the same tree.
+   */
+  void project_search();
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+#include "documentStates.hpp"
+#include "textBuffer.hpp"
+
+struct Language;
+
+/**
+ * @brief The two ends of a bracket pair, as buffer positions.
+ */
+struct BracketPair {
+    size_t open_row;
+    size_t open_col;
+    size_t close_row;
+    size_t close_col;
+};
+
+/**
+ * @class BracketIndex
+ * @brief Knows the nesting of the brackets of a document, for matching and block queries.
+ *
+ * Every row keeps the brackets it has outside comments and strings (the
+ * language's `brackets`, taken as open/close pairs) and a summary of them:
+ * how much the row changes the nesting depth and the lowest depth it goes to.
+ * The summaries sit in a segment tree over the rows, so the bracket closing
+ * a given one is found by walking down the tree to the first row that drops
+ * below its depth, instead of scanning the rows in between. Rows follow the
+ * buffer's edit journal: an edited row is scanned again, and the rows below
+ * it only when its comment state at the end changed.
+ * Brackets pair by depth; a pair of different kinds (`(]`) is not a match.
+ */
+class BracketIndex {
+public:
+    static BracketIndex& instance() {
+        static BracketIndex instance;
+        return instance;
+    }
+
+    /**
+     * @brief Finds the bracket matching the one at a position.
+     * @return False if there is no bracket there (or it is in a comment or
+     * a string), or it is not closed by the same kind.
+     */
+    bool match(const textBuffer& text, size_t row, size_t col, BracketPair& pair);
+
+    /**
+     * @brief Finds the innermost pair around a position, the position's own
+     * bracket excluded when it is an opening one.
+     * @return False at the top level, or when the block is not well formed.
+     */
+    bool enclosing(const textBuffer& text, size_t row, size_t col, BracketPair& pair);
+
+    /**
+     * @brief Finds the first bracket on a row at or after a column.
+     * @return False if there is none.
+     */
+    bool next_on_row(const textBuffer& text, size_t row, size_t col, size_t& found);
+
+private:
+    BracketIndex() = default;
+
+    struct Bracket {
+        uint32_t col;
+        uint8_t kind;   // index of the pair in the language's brackets
+        bool open;
+    };
+
+    // Depths are relative to the start of the range a summary covers
+    struct Summary {
+        int delta = 0;         // depth at the end
+        int low_after = 0;     // lowest depth right after one of its brackets (INT_MAX: none)
+        int low_before = 0;    // lowest depth right before one of its brackets
+    };
+
+    struct Row {
+        std::vector<Bracket> brackets;
+        Summary summary{0, INT_MAX, INT_MAX};
+        bool start = false;    // inside a block comment at the start of the row
+        bool end = false;
+    };
+
+    struct Document {
+        std::vector<Row> rows;
+        std::vector<Summary> tree;   // tree[1] is the root; leaves from `leaves` on
+        size_t leaves = 0;
+        std::set<size_t> stale;      // rows to scan again
+        size_t reshaped = SIZE_MAX;  // rows were added or removed from here on: the tree is rebuilt from there
+        size_t tree_rows = 0;        // rows the leaves were last filled for
+        unsigned long version = 0;
+        const Language* language = nullptr;
+        bool built = false;
+
+        void sync(const textBuffer& text, std::vector<BufferEdit>& edits);
+        void reset(const textBuffer& text);
+        void rescan(const textBuffer& text);
+        void build_tree(size_t from = 0);
+        void update_leaf(size_t row);
+
+        int depth_before(size_t row) const;
+
+        // Walk down the tree to the first row from `from` whose depth goes down
+        // to `target` after one of its brackets; `depth` is the depth at `from`,
+        // and ends as the depth at the start of the row found
+        bool find_after(size_t node, size_t lo, size_t hi, size_t from, int& depth, int target, size_t& row) const;
+
+        // Same, backwards: the last row before `to` whose depth is down to
+        // `target` before one of its brackets; `depth` is the depth at `to`
+        bool find_before(size_t node, size_t lo, size_t hi, size_t to, int& depth, int target, size_t& row) const;
+    };
+
+    DocumentStates<Document> documents;
+    std::vector<BufferEdit> edits;   ///< Scratch space for the journal.
+
+    Document* sync(const textBuffer& text);
+
+    static Summary summarize(const std::vector<Bracket>& brackets);
+    static Summary combine(const Summary& left, const Summary& right);
+    static void scan(const Language& lang, const std::string& text, Row& row);
+
+    // The first bracket of a row at or after a column
+    static size_t bracket_at(const std::vector<Bracket>& brackets, size_t col);
+
+    // The partner of the opening bracket `index` of `row`
+    bool close_of(const Document& document, size_t row, size_t index, BracketPair& pair) const;
+    // The opening bracket enclosing the point before bracket `index` of `row`
+    // (index == size: after the last one)
+    bool open_before(const Document& document, size_t row, size_t index, size_t& open_row, size_t& open_index) const;
+};
@@ -32,11 +32,33 @@ public:
         int visual_start_col;
         
         std::string pointed_file;
+        const Language* language = nullptr;
         std::string command_buffer;
         std::string copy_paste_buffer;
 
         WINDOW* window;
         std::string name;
+        bool read_only = false;   // keys that would change the text are refused
+
+        // What the window showed the last time it was drawn as an inactive buffer
+        struct RenderStamp {
+            bool valid = false;
+            unsigned long document_id = 0;
+            unsigned long document_version = 0;
+            unsigned long layout = 0;
+            size_t starting_row = 0;
+            size_t starting_col = 0;
+            size_t max_row = 0;
+            size_t max_col = 0;
+
+            bool operator==(const RenderStamp& other) const {
+                return valid && other.valid &&
+                       document_id == other.document_id && document_version == other.document_version &&
+                       layout == other.layout &&
+                       starting_row == other.starting_row && starting_col == other.starting_col &&
+                       max_row == other.max_row && max_col == other.max_col;
+            }
+        } last_render;
     };
 
     static BufferManager& instance() {
@@ -73,8 +95,11 @@ public:
         buffer.starting_row = 0;
         buffer.pointed_col = 0;
         buffer.starting_col = 0;
+        buffer.language = nullptr;
         buffer.command_buffer.clear();
         buffer.copy_paste_buffer.clear();
+        buffer.read_only = false;
+        buffer.last_render = {};
 
         buffer_count++;
 
@@ -198,6 +223,7 @@ public:
         visual_start_col = activeBuffer.visual_start_col;
 
         pointed_file = activeBuffer.pointed_file;
+        pointed_language = activeBuffer.language;
         command_buffer = activeBuffer.command_buffer;
         copy_paste_buffer = activeBuffer.copy_paste_buffer;
 
@@ -225,6 +251,7 @@ public:
         activeBuffer.visual_start_col = visual_start_col;
 
         activeBuffer.pointed_file = pointed_file;
+        activeBuffer.language = pointed_language;
         activeBuffer.command_buffer = command_buffer;
         activeBuffer.copy_paste_buffer = copy_paste_buffer;
 
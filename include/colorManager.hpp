@@ -19,6 +19,9 @@ public:
     color background;
     color text;
     color cursor;
+    color strings = COLOR_GREEN;
+    color numbers = COLOR_RED;
+    color types = COLOR_CYAN;
   };
 
   // Constructor that uses the base class constructor
@@ -78,6 +81,21 @@ public:
     cursorColor = pColor;
   }
 
+  void setStringColor(color pColor)
+  {
+    stringColor = pColor;
+  }
+
+  void setNumberColor(color pColor)
+  {
+    numberColor = pColor;
+  }
+
+  void setTypeColor(color pColor)
+  {
+    typeColor = pColor;
+  }
+
   // Sets the color schema using the provided colorSchema structure
   void setColorSchema(struct colorSchema pColorSchema)
   {
@@ -92,6 +110,9 @@ public:
     setPreprocessorColor(get_pair_default(pColorSchema.preprocessor));
     setTextColor(get_pair_default(pColorSchema.text));
     setCursorColor(pColorSchema.cursor);
+    setStringColor(get_pair_default(pColorSchema.strings));
+    setNumberColor(get_pair_default(pColorSchema.numbers));
+    setTypeColor(get_pair_default(pColorSchema.types));
   }
 
   // Sets the color schema based on the provided name
@@ -1,9 +1,11 @@
 #pragma once
 #include "editor.hpp"
+#include "bufferManager.hpp"
 #include "configParser.hpp" 
 #include "globals/consts.h" 
 #include <ncurses.h>
 #include <cctype> 
+#include <set>
 
 #define ctrl(x) ((x) & 0x1f)
 #define isOpenBracket(c) (c == '{' || c == '[' || c == '(')
@@ -60,6 +62,7 @@ public:
     normalMap['g'] = editor::movement::move_to_end_of_file;
     normalMap['G'] = editor::movement::move_to_beginning_of_file;
     normalMap['w'] = editor::movement::move_to_next_word;
+    normalMap['%'] = editor::movement::jump_to_matching_bracket;
     normalMap['e'] = editor::file::file_selection_menu;
     normalMap['q'] = editor::system::exit_ide;
     normalMap['s'] = editor::file::save;
@@ -74,6 +77,8 @@ public:
     normalMap['i'] = editor::system::change2insert;
     normalMap['v'] = editor::system::change2visual;
     normalMap['f'] = editor::find::find;
+    normalMap['F'] = editor::find::project_search;
+    normalMap[KEY_ENTER_] = editor::find::open_project_result;
 
     // Copy operations
     normalMap[ctrl('c')] = editor::visual::copy_line; 
@@ -104,6 +109,7 @@ public:
     visualMap['k'] = editor::movement::move_up;
     visualMap['l'] = editor::movement::move_right;
     visualMap['w'] = editor::movement::move_to_next_word;
+    visualMap['%'] = editor::movement::jump_to_matching_bracket;
 
     visualMap['a'] = editor::movement::move_to_end_of_line;       
     visualMap['A'] = editor::movement::move_to_beginning_of_line; 
@@ -144,6 +150,12 @@ public:
       editor::system::resize();
     }
 
+    if (BufferManager::instance().get_active_buffer().read_only && edits(key))
+    {
+      ErrorHandler::instance().report(ErrorLevel::INFO, "This buffer is read-only");
+      return;
+    }
+
     if (specialKeys.find(key) != specialKeys.end())
     {
       specialKeys[key]();
@@ -224,6 +236,48 @@ public:
       }
   }
 
+  // Tells whether a key would change the text (or lead to typing) in the current mode
+  bool edits(int key)
+  {
+    static const std::set<void (*)()> editing = {
+      editor::modify::new_line, editor::modify::delete_letter, editor::modify::normal_delete_letter, editor::modify::tab,
+      editor::modify::delete_row, editor::modify::paste, editor::modify::paste_in_visual, editor::modify::replace,
+      editor::modify::delete_word, editor::modify::delete_word_backyard, editor::modify::undo,
+      editor::movement::go_down_creating_newline, editor::movement::go_up_creating_newline,
+      editor::visual::delete_highlighted, editor::system::change2insert,
+    };
+
+    keymap* map = nullptr;
+    switch (mode)
+    {
+    case insert: map = &insertMap; break;
+    case normal: map = &normalMap; break;
+    case visual: map = &visualMap; break;
+    case find: map = &findMap; break;
+    default: break;
+    }
+    if (specialKeys.count(key))
+    {
+      map = &specialKeys;
+    }
+    else if (mode == insert && (key == ctrl('w') || (key < 256 && isprint(key))))
+    {
+      return true;
+    }
+    else if (mode == visual && isOpenBracket(key))
+    {
+      return true;
+    }
+
+    auto action = map ? map->find(key) : keymap::iterator();
+    if (!map || action == map->end())
+    {
+      return false;
+    }
+    void (* const* function)() = action->second.target<void (*)()>();
+    return function && editing.count(*function);
+  }
+
   static int getClosingBracketOf(int bracket){
     if (bracket == '{') return '}';
     if(bracket == '[') return ']';
@@ -29,6 +29,11 @@ private:
      * @brief Returns a map linking string action names to actual editor functions.
      */
     static std::map<std::string, std::function<void()>> getActionMap();
+
+    /**
+     * @brief Sets an editor option from the [OPTIONS] section (e.g. 'max_highlight_length = 20000').
+     */
+    static void setOption(const std::string& name, const std::string& value, int lineNumber);
     
     // Helper to trim whitespace
     static std::string trim(const std::string& str);
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <utility>
+
+/**
+ * @class DocumentStates
+ * @brief Keeps a state per document, for the few documents used last.
+ *
+ * The highlight caches are filled for one document at a time; keeping
+ * them per document id means switching back to a buffer finds its cache
+ * still warm. The least recently used document is dropped past the capacity.
+ * Other keys work the same way (compiled searches are kept by their term).
+ */
+template<typename State, typename Key = unsigned long>
+class DocumentStates {
+public:
+    explicit DocumentStates(size_t capacity = 8) : capacity(capacity) {}
+
+    /**
+     * @brief Returns the state of a document, created empty on first use.
+     * References stay valid until the document is dropped.
+     */
+    State& get(const Key& id)
+    {
+        for (auto it = states.begin(); it != states.end(); ++it) {
+            if (it->first == id) {
+                states.splice(states.begin(), states, it);
+                return states.front().second;
+            }
+        }
+        states.emplace_front(id, State());
+        if (states.size() > capacity) {
+            states.pop_back();
+        }
+        return states.front().second;
+    }
+
+    /**
+     * @brief Returns the state of a document if it is kept, without creating it.
+     */
+    State* find(const Key& id)
+    {
+        for (auto& entry : states) {
+            if (entry.first == id) return &entry.second;
+        }
+        return nullptr;
+    }
+
+private:
+    size_t capacity;
+    std::list<std::pair<Key, State>> states;  // most recently used first
+};
@@ -1,13 +1,27 @@
 #pragma once
 #include "globals/mvimResources.h"
-// Standard libraries required for std::stack, std::vector, std::string
+#include "searchMatches.hpp"
+// Standard libraries required for std::function, std::shared_ptr, std::stack, std::vector, std::string
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <stack>
 
+struct Language;
+
 namespace editor
 {
-  enum ActionType { INSERT_CHAR, DELETE_CHAR, INSERT_NEWLINE, DELETE_NEWLINE, DELETE_ROW, PASTE, DELETE_SELECTION };
+  enum ActionType { INSERT_CHAR, DELETE_CHAR, INSERT_NEWLINE, DELETE_NEWLINE, DELETE_ROW, PASTE, DELETE_SELECTION, REPLACE_ALL };
+
+  // What a replace-all changed, enough to undo it in one step
+  struct Replacement
+  {
+    std::vector<SearchMatch> matches; // where each replacement now is, with the length of the text it replaced
+    std::string replaced;             // the replaced texts, one after the other
+    int length;                       // the length of each replacement
+    bool across_rows = false;         // some replaced texts held line breaks: the rows they joined are split again
+  };
 
   struct Action
   {
@@ -17,18 +31,12 @@ namespace editor
     char letter;              
     std::string text;         
     bool is_chained = false; // if true, undo will continue to the next item
+    std::shared_ptr<Replacement> replacement; // REPLACE_ALL only
   };
 
   inline std::stack<Action> action_history;
 
-  // Structure to hold variable-length match data for Regex
-  struct SearchMatch {
-      int row;
-      int col;
-      int length;
-  };
-
-  inline std::vector<SearchMatch> found_occurrences;  
+  inline SearchMatches found_occurrences;
   inline int current_occurrence_index;
 
   namespace movement
@@ -106,6 +114,12 @@ namespace editor
      * positioning it at the first character.
      */
     void move_to_beginning_of_file();
+
+    /**
+     * @brief Jump to the bracket matching the first one at or after the cursor
+     * on the current line, as vim's %. Brackets in comments and strings are skipped.
+     */
+    void jump_to_matching_bracket();
   };
 
   namespace modify
@@ -167,6 +181,14 @@ namespace editor
      */
     void replace();
 
+    /**
+     * @brief Replaces every match of the last search with a string.
+     * Each row with matches is rebuilt once, the rows split among the cores,
+     * and the whole replacement is undone in a single step.
+     * @param replace_term The text put in place of each match.
+     */
+    void replace_all(const std::string& replace_term);
+
     void delete_selection(int start_row, int end_row, int start_col, int end_col);
 
     void delete_word();
@@ -241,6 +263,20 @@ namespace editor
      */
     std::string text_form(const std::string& label);
 
+    /**
+     * @brief Same, calling on_edit after every change of the input, and on_idle
+     * while no key is waiting, until it returns false. ESC returns an empty string.
+     * @param on_edit Called with the input after a change.
+     * @param on_idle Does some of the work left; returns true if there is more.
+     */
+    std::string text_form(const std::string& label, const std::function<void(const std::string&)>& on_edit,
+                          const std::function<bool()>& on_idle);
+
+    /**
+     * @brief Tells whether a key is waiting to be read, without reading it.
+     */
+    bool input_pending();
+
     /**
      * @brief Switches the editor mode to "normal" mode.
      */
@@ -277,6 +313,17 @@ namespace editor
 
     void resize();
 
+    /**
+     * @brief Shows the performance counters (frames, coalesced input...) in the status bar.
+     */
+    void show_stats();
+
+    /**
+     * @brief Switches between wrapping long rows on several screen lines and
+     * scrolling them sideways.
+     */
+    void toggle_wrap();
+
   };
 
   namespace visual
@@ -315,9 +362,58 @@ namespace editor
     void copy_highlighted();
 
     /**
-     * @brief Highlights all occurrences of the keywords in the buffer.
+     * @brief Colors the keywords, brackets and comments of a row.
+     * @param buffer_row The text of the row.
+     * @param colors One color pair per character of the row, updated in place.
+     * @param in_comment Whether the row starts inside a multi-line comment;
+     * on return it tells whether the next row does.
+     * @param from, to Only the columns [from, to) need colors: keywords,
+     * brackets and tokens are only looked for there. Comments are always
+     * followed over the whole row, so the state at its end stays right.
+     */
+    void style_keywords(const std::string& buffer_row, std::vector<color>& colors, bool& in_comment,
+                        size_t from = 0, size_t to = std::string::npos);
+
+    /**
+     * @brief Same as style_keywords with the given language. It only reads the
+     * language and the colors, so it can run outside the main thread.
+     */
+    void style_row(const Language& lang, const std::string& buffer_row, std::vector<color>& colors, bool& in_comment,
+                   size_t from = 0, size_t to = std::string::npos);
+
+    /**
+     * @brief Colors the keywords of every syntax group of a row, in one pass
+     * of the language's keyword automaton. Where groups overlap, the later one wins.
+     */
+    void style_keyword_groups(const Language& lang, const std::string& buffer_row, std::vector<color>& colors);
+
+    /**
+     * @brief Same result as style_keyword_groups, searching the row once per keyword.
+     * Kept as the reference for the tests and the benchmark.
      */
-    void highlight_keywords();
+    void style_keyword_groups_by_search(const Language& lang, const std::string& buffer_row, std::vector<color>& colors);
+
+    /**
+     * @brief Colors the comments, strings, numbers and types of a row in one
+     * pass of the language's lexer. Comments and strings cover the keywords
+     * and brackets inside them, and a quote in a comment opens no string.
+     * Only the tokens within [from, to) are colored.
+     * @param in_comment As for style_keywords.
+     */
+    void style_tokens(const Language& lang, const std::string& buffer_row, std::vector<color>& colors, bool& in_comment,
+                      size_t from = 0, size_t to = std::string::npos);
+
+    /**
+     * @brief Follows the multi-line comments of a row, the only lexer state
+     * carried from one row to the next. With a lexer, delimiters inside
+     * strings and line comments are left out.
+     * @param lang The language giving the comment delimiters.
+     * @param buffer_row The text of the row.
+     * @param colors If not null, the comments are painted in it.
+     * @param in_comment Whether the row starts inside a multi-line comment;
+     * on return it tells whether the next row does.
+     */
+    void style_block_comments(const Language& lang, const std::string& buffer_row, std::vector<color>* colors, bool& in_comment);
 
     /**
      * @brief Deletes and copies the highlighted text based on the visual selection.
@@ -331,6 +427,12 @@ namespace editor
      */
     void highlight_block(int from, int to);
 
+    /**
+     * @brief Highlights the bracket under the cursor and the one matching it
+     * (in insert mode, the one just before the cursor too).
+     */
+    void highlight_matching_bracket();
+
     void insert_brackets(char opening_bracket, char closing_bracket);
 
     void select_all();
@@ -341,35 +443,93 @@ namespace editor
   namespace find
   {
     /**
-     * @brief Highlights all occurrences of the word within the visible rows.
-     * The function iterates through the found occurrences and highlights the word in the visible rows.
+     * @brief Groups the found occurrences by visible row. A match over several
+     * rows is split into its part of each row.
+     * @param first_row The first buffer row shown in the window.
+     * @param rows The number of rows shown in the window.
+     * @return One list of matches per visible row.
      */
-    void highlight_searched_word();
+    std::vector<std::vector<SearchMatch>> visible_occurrences(size_t first_row, size_t rows);
 
     /**
-     * @brief Moves the cursor to the next occurrence of the word in the buffer.
-     * The function cycles through the found occurrences and updates the cursor position to the next occurrence.
+     * @brief Colors the searched word on a row.
+     * @param matches The occurrences found on the row.
+     * @param colors One color pair per character of the row, updated in place.
+     */
+    void style_searched_word(const std::vector<SearchMatch>& matches, std::vector<color>& colors);
+
+    /**
+     * @brief Moves the cursor to the first occurrence after it, wrapping around the end of the buffer.
+     * While the matches are still being counted, the rows after the cursor are searched directly.
      */
     void go_to_next_occurrence();
 
     /**
-     * @brief Moves the cursor to the previous occurrence of the word in the buffer.
-     * The function cycles through the found occurrences and updates the cursor position to the previous occurrence.
+     * @brief Moves the cursor to the last occurrence before it, wrapping around the start of the buffer.
+     * While the matches are still being counted, the rows before the cursor are searched directly.
      */
     void go_to_previous_occurrence();
 
     /**
      * @brief Initiates the find action by prompting the user to input a search term.
-     * The function displays a form to input the search term and initiates the search process.
+     * The matches are searched and shown while the term is typed, with the cursor
+     * on the nearest one after its position; ESC puts it back where it was.
+     * Enter only waits for that nearest match: the rest of the buffer is counted
+     * afterwards by search_in_background().
      */
     void find();
 
+    /**
+     * @brief Counts the matches of the last search for a few milliseconds, or until a key is waiting.
+     * Called by the main loop while it is idle.
+     * @return True while part of the buffer is left to search.
+     */
+    bool search_in_background();
+
+    /**
+     * @brief Searches what is left of the buffer at once, for the commands that need every match.
+     */
+    void complete_search();
+
+    /**
+     * @brief The search part of the status bar: "match k of N" when the cursor is on a match,
+     * the number of matches otherwise, or how many were found so far while counting.
+     */
+    std::string search_status();
+
     /**
      * @brief Find all occurrences of a word in the buffer.
      * The function searches for the word in each row of the buffer and stores the row and column
-     * positions of each occurrence in the `found_occurrences` vector.
+     * positions of each occurrence in `found_occurrences`.
      * @param word The word to search for in the buffer.
      */
     void find_all_occurrence(const std::string& word);
+
+    /**
+     * @brief Brings `found_occurrences` up to date with the edits made since the search,
+     * searching only the rows that changed. The current occurrence becomes the last one
+     * at or before the cursor.
+     */
+    void follow_edits();
+
+    /**
+     * @brief Prompts for a term and searches every file below the current directory for it,
+     * on all cores (see ProjectSearch). The lines that match stream into a read-only buffer
+     * as "path:line:col: text", and Enter on one of them opens its file at the match.
+     */
+    void project_search();
+
+    /**
+     * @brief Moves the lines the project search found since the last call to its buffer.
+     * Called by the main loop while it is idle.
+     * @return True while files are left to search.
+     */
+    bool project_search_in_background();
+
+    /**
+     * @brief Opens the file of the project search result under the cursor, at its match,
+     * in another buffer. Does nothing outside the results of a project search.
+     */
+    void open_project_result();
   };
 };
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+
+/**
+ * @class EditorStats
+ * @brief Collects the performance counters shown by the stats view.
+ */
+class EditorStats {
+public:
+    static EditorStats& instance() {
+        static EditorStats instance;
+        return instance;
+    }
+
+    // --- Frame scheduling ---
+    unsigned long frames_rendered = 0;   ///< Frames sent to the terminal after input.
+    unsigned long inputs_coalesced = 0;  ///< Inputs applied without a frame of their own.
+    unsigned long frames_dropped = 0;    ///< Frame intervals that elapsed before pending input was shown.
+
+    // --- Rendering ---
+    unsigned long rows_built = 0;        ///< Screen rows styled from scratch (render cache misses).
+    unsigned long rows_scrolled = 0;     ///< Screen rows moved by a scroll instead of being rebuilt.
+    unsigned long rows_lexed = 0;        ///< Rows re-tokenized to find the comment state at their end.
+    unsigned long rows_highlighted = 0;  ///< Rows styled on the background thread and kept for later frames.
+    unsigned long rows_deferred = 0;     ///< Rows drawn plain for a frame because its highlighting budget was spent.
+
+    // --- Search ---
+    unsigned long rows_searched = 0;     ///< Rows checked against a search term.
+    unsigned long index_bytes = 0;       ///< Memory held by the search index of the document.
+    unsigned long index_build_ms = 0;    ///< Time the search index took to build (0 while building).
+
+    /**
+     * @brief Formats every counter on a single line for the status bar.
+     */
+    std::string summary() const {
+        return "frames " + std::to_string(frames_rendered) +
+               " | coalesced " + std::to_string(inputs_coalesced) +
+               " | dropped " + std::to_string(frames_dropped) +
+               " | rows built " + std::to_string(rows_built) +
+               " | scrolled " + std::to_string(rows_scrolled) +
+               " | lexed " + std::to_string(rows_lexed) +
+               " | background " + std::to_string(rows_highlighted) +
+               " | deferred " + std::to_string(rows_deferred) +
+               " | searched " + std::to_string(rows_searched) +
+               " | index " + std::to_string(index_bytes >> 20) + " MB in " + std::to_string(index_build_ms) + " ms";
+    }
+
+private:
+    EditorStats() = default;
+    EditorStats(const EditorStats&) = delete;
+    EditorStats& operator=(const EditorStats&) = delete;
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <ncurses.h>
+#include "editorStats.hpp"
+
+/**
+ * @class FrameScheduler
+ * @brief Decides when the main loop renders, so a burst of input produces one frame.
+ *
+ * Key-repeat and fast typing deliver many keys between two frames the user can
+ * actually see. The main loop drains every pending key with poll() (a zero
+ * timeout read), applies the whole burst and renders once, never more often
+ * than the target frame rate.
+ */
+class FrameScheduler {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @param target_fps Maximum number of frames per second.
+     * @param max_burst Maximum number of keys applied before a frame is forced,
+     * so a flood of input cannot starve the screen.
+     */
+    explicit FrameScheduler(int target_fps = 60, int max_burst = 512)
+        : frame_interval(std::chrono::microseconds(1000000 / target_fps)),
+          max_burst(max_burst), pending(0), last_frame(clock::now()), first_pending(last_frame) {}
+
+    /**
+     * @brief Reads the next key of the current burst without waiting.
+     * @return The key, or ERR when no more input is queued or the burst is full.
+     */
+    int poll(WINDOW* window) {
+        if (pending >= max_burst) {
+            return ERR;
+        }
+        wtimeout(window, 0);
+        return wgetch(window);
+    }
+
+    /**
+     * @brief Records that an input was applied and is waiting to be shown.
+     */
+    void input_applied() {
+        if (pending == 0) {
+            first_pending = clock::now();
+        }
+        pending++;
+    }
+
+    /**
+     * @brief Tells whether some applied input has not been rendered yet.
+     */
+    bool has_pending() const {
+        return pending > 0;
+    }
+
+    /**
+     * @brief Tells whether enough time passed since the last frame to render again.
+     */
+    bool frame_due() const {
+        return pending >= max_burst || clock::now() - last_frame >= frame_interval;
+    }
+
+    /**
+     * @brief Milliseconds the main loop may keep waiting for input before
+     * the next frame is due (at least 1, so the wait never busy-loops).
+     * @param idle_timeout Timeout to use when nothing is pending.
+     */
+    int wait_timeout(int idle_timeout) const {
+        if (!has_pending()) {
+            return idle_timeout;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            frame_interval - (clock::now() - last_frame)).count();
+        return std::max<int>(1, remaining);
+    }
+
+    /**
+     * @brief Records a rendered frame and updates the frame counters.
+     */
+    void frame_rendered() {
+        auto now = clock::now();
+        EditorStats& stats = EditorStats::instance();
+
+        if (pending > 0) {
+            stats.frames_rendered++;
+            stats.inputs_coalesced += pending - 1;
+
+            // Whole frame intervals the user waited beyond the first one
+            long late = (now - first_pending) / frame_interval;
+            if (late > 1) {
+                stats.frames_dropped += late - 1;
+            }
+        }
+
+        pending = 0;
+        last_frame = now;
+    }
+
+private:
+    clock::duration frame_interval;
+    int max_burst;
+    int pending;                   ///< Inputs applied since the last frame.
+    clock::time_point last_frame;
+    clock::time_point first_pending;
+};
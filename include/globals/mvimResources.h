@@ -22,6 +22,8 @@
 #include "../textBuffer.hpp"
 #include "../errorHandler.hpp"
 
+struct Language;
+
 
 /*
 
@@ -44,6 +46,7 @@ inline size_t pointed_col;
 inline size_t starting_col;
 
 inline std::string pointed_file;
+inline const Language* pointed_language = nullptr;   // detected from pointed_file, kept per buffer
 inline std::string command_buffer;
 inline std::string copy_paste_buffer;
 
@@ -54,6 +57,12 @@ inline WINDOW* pointed_window;
 
 inline bool is_undoing;
 
+/*display options*/
+inline bool soft_wrap = false;   // wrap long rows on several screen lines instead of scrolling sideways
+inline size_t max_highlight_length = 20000;   // longer rows are drawn without highlighting
+inline size_t search_index_rows = 1000000;    // documents with this many rows get a search index; 0 turns it off
+inline size_t highlight_budget_ms = 8;        // styling time per frame; rows past it are drawn plain until the next frame
+
 /*mvim colors*/
 typedef short color;
 inline color keyWordColor;
@@ -66,6 +75,9 @@ inline color bgColor;
 inline color highlightedBgColor;
 inline color textColor;
 inline color cursorColor;
+inline color stringColor;
+inline color numberColor;
+inline color typeColor;
 
 /*
    need to map keys for the specific mode
@@ -0,0 +1,204 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+#include "documentStates.hpp"
+#include "editor.hpp"
+#include "literalFinder.hpp"
+#include "regexMatcher.hpp"
+#include "searchPool.hpp"
+
+/**
+ * @brief A search term, compiled once: the linear-time matcher, std::regex
+ * for what it cannot do (backreferences, lookarounds), or plain text when
+ * the term is not a valid expression (such as "[").
+ */
+struct SearchPattern {
+    enum class Kind { REGEX, BACKTRACKING, LITERAL } kind = Kind::LITERAL;
+    std::string text;
+    RegexMatcher matcher;
+    std::regex backtracking;
+    LiteralFinder finder;   // LITERAL only
+
+    void compile(const std::string& pattern);
+
+    /**
+     * @brief Appends the matches of a row, left to right, to `out`.
+     */
+    void matches(const std::string& row, int row_index, std::vector<editor::SearchMatch>& out);
+
+    /**
+     * @brief Tells whether the term names the line break (`\n`), so that its
+     * matches can span rows: it is searched through the rows as one text.
+     */
+    bool multiline() const { return kind == Kind::REGEX && matcher.is_multiline(); }
+
+    /**
+     * @brief Appends the matches found through the rows as one text, from
+     * `from` on, that start before row `until` (see RegexMatcher::search_rows).
+     * @param from Moved on to where the next call goes on.
+     */
+    void matches_across(const std::deque<std::string>& lines, RegexMatcher::Position& from, size_t until, std::vector<editor::SearchMatch>& out);
+
+    /**
+     * @brief Tells whether the term matches exactly the rows containing `required()`.
+     */
+    bool is_literal() const;
+
+    /**
+     * @brief Text every match starts with (empty if none is known).
+     */
+    std::string required() const;
+
+    /**
+     * @brief Texts every match contains, in lower case (none if they are not known).
+     */
+    std::vector<std::string> literals() const;
+
+    /**
+     * @brief Tells whether every row this term matches was matched by `previous` too,
+     * as when typing on after a plain-text term.
+     */
+    bool narrows(const SearchPattern& previous) const;
+};
+
+/**
+ * @class IncrementalSearch
+ * @brief Searches the buffer while the term is being typed.
+ *
+ * A search starts from the cursor row and wraps around, so the first match
+ * found is the nearest one, and runs in slices that stop at a deadline or as
+ * soon as a key is waiting: the next keystroke cancels what is left. When
+ * the new term only narrows the previous one (`foo` to `foo_b`), only the
+ * rows that matched it are checked again, followed by the rows it had not
+ * reached yet. Each slice is searched on all cores (see SearchPool), and
+ * the chunks nearest to the cursor come first, so the first page of
+ * matches is shown before the rest of the buffer is done. Compiled terms are kept for the last few terms typed, so
+ * going back with backspace does not compile them again.
+ * Terms that name the line break are searched through the rows as one text
+ * instead, on one thread: from the start of the cursor row down, then from
+ * the top. A match above the cursor row may run into it, and the matches
+ * from there on are then found again from its end.
+ * Results go to editor::found_occurrences as they are found, in scan order:
+ * by row from the cursor down, then the rows above it. Once the search is
+ * complete they are sorted by position, and follow() keeps them so through
+ * later edits, at the cost of the rows edited (see SearchMatches); either
+ * way the matches of a row are found by binary search.
+ */
+class IncrementalSearch {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static IncrementalSearch& instance() {
+        static IncrementalSearch instance;
+        return instance;
+    }
+
+    /**
+     * @brief The compiled form of a term, from the cache.
+     */
+    std::shared_ptr<SearchPattern> compiled(const std::string& term);
+
+    /**
+     * @brief Starts searching for a term; the first match after (row, col) is the nearest, as for `n`.
+     * Nothing is scanned until run().
+     */
+    void start(const textBuffer& text, const std::string& term, size_t row, size_t col);
+
+    /**
+     * @brief Drops the results and the search in progress.
+     */
+    void clear();
+
+    /**
+     * @brief Goes on scanning until every row is checked, the deadline passes
+     * or interrupted() says a key is waiting (both checked after every batch of chunks).
+     * @return True once the search is complete.
+     */
+    bool run(const textBuffer& text, clock::time_point deadline, const std::function<bool()>& interrupted = nullptr);
+
+    /**
+     * @brief Completes the search and sorts the results by position.
+     * @return The index of the nearest match in editor::found_occurrences, or -1 if there is none.
+     */
+    int finish(const textBuffer& text);
+
+    /**
+     * @brief Brings the results of a complete search up to date with the edits
+     * made to the text since: matches move with their rows, and only the rows
+     * that were changed or inserted are searched again. The matches of terms
+     * that name the line break are kept up to the first edited row, and the
+     * rest is searched again by run(), as when there is nothing to go by.
+     * Results of another document are dropped.
+     * @return True if the results changed.
+     */
+    bool follow(const textBuffer& text);
+
+    /**
+     * @brief The matches of a row, found by binary search.
+     * @return Their indexes in editor::found_occurrences, [first, last).
+     */
+    std::pair<size_t, size_t> in_row(int row) const;
+
+    /**
+     * @brief Looks for the match after (or before) a position row by row, from
+     * the text itself: for moving while the search is still counting. Wraps
+     * around the end of the text.
+     * @return False if the term matches nowhere.
+     */
+    bool scan_from(const textBuffer& text, size_t row, size_t col, bool forward, editor::SearchMatch& match);
+
+    /**
+     * @brief The nearest match found so far.
+     * @return False if there is none yet.
+     */
+    bool nearest(editor::SearchMatch& match) const;
+
+    bool complete() const { return done; }
+
+private:
+    IncrementalSearch() = default;
+
+    static constexpr size_t CHUNK_ROWS = 1024;          // rows handed to a thread at a time
+    static constexpr size_t CHUNK_BYTES = 64 * 1024;    // same, for long rows
+    static constexpr size_t BATCH_CHUNKS = 2;           // chunks per thread between two looks at the clock and the keyboard
+
+    DocumentStates<std::shared_ptr<SearchPattern>, std::string> patterns{16};
+    std::shared_ptr<SearchPattern> pattern;
+
+    // The scan: the rows left in `candidates`, then the rows from step
+    // `next_step` on, where step k is row (origin_row + k) % rows
+    unsigned long text_id = 0;
+    unsigned long version = 0;        // the results are those of this version
+    unsigned long scan_version = 0;   // the one `matched_rows` and the candidates were scanned in
+    size_t origin_row = 0;
+    size_t origin_col = 0;
+    size_t rows = 0;
+    std::vector<int> candidates;
+    size_t next_candidate = 0;
+    size_t next_step = 0;
+    bool done = true;
+
+    std::vector<int> matched_rows;   // rows with a match, in scan order
+    long nearest_index = -1;         // in found_occurrences
+    size_t wrap_index = SIZE_MAX;    // found_occurrences from here on are above the origin
+
+    std::vector<SearchPool::Chunk> batch;
+    RegexMatcher::Position resume{0, 0};   // multi-line terms: where the scan goes on
+    bool wrapped = false;                  // multi-line terms: the scan is above the origin
+
+    std::vector<BufferEdit> edits;
+    std::vector<int> changed;   // follow(): the rows to search again, where they are after the edits
+
+    bool next_batch(const textBuffer& text);
+    bool stream(const textBuffer& text, clock::time_point deadline, const std::function<bool()>& interrupted);
+    void stitch(const textBuffer& text);
+    void search_on(const textBuffer& text);
+    bool scan_across(const textBuffer& text, size_t row, size_t col, bool forward, editor::SearchMatch& match);
+    size_t scan_key(int row) const;
+    void merge(const SearchPool::Chunk& chunk);
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class KeywordMatcher
+ * @brief Finds every keyword of a language in one pass over a row (Aho–Corasick).
+ *
+ * The keywords are compiled into an automaton whose transitions are a dense
+ * table over the bytes that occur in the keywords; every other byte leads
+ * back to the start. Scanning a row costs one table lookup per byte plus
+ * one callback per occurrence, whatever the number of keywords.
+ */
+class KeywordMatcher {
+public:
+    /**
+     * @brief Adds a keyword. build() must be called before the next scan.
+     * @param group The syntax group the keyword belongs to, handed back on every match.
+     */
+    void add(const std::string& word, int group);
+
+    /**
+     * @brief Compiles the keywords added so far into the automaton.
+     */
+    void build();
+
+    bool empty() const { return patterns.empty(); }
+    size_t keyword_count() const { return patterns.size(); }
+
+    /**
+     * @brief Reports every occurrence of every keyword in text, overlapping ones included.
+     * @param on_match Called as on_match(start, length, group), in order of the occurrences' ends.
+     */
+    template<typename OnMatch>
+    void scan(const std::string& text, OnMatch&& on_match) const
+    {
+        if (patterns.empty()) {
+            return;
+        }
+        uint32_t state = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            state = next[state * classes + byte_class[(unsigned char)text[i]]];
+            // The state itself, then every shorter suffix that ends a keyword
+            for (uint32_t s = state; s != NONE; s = dictionary[s]) {
+                for (uint32_t k = output_begin[s]; k < output_begin[s + 1]; ++k) {
+                    const Pattern& p = patterns[outputs[k]];
+                    on_match(i + 1 - p.length, (size_t)p.length, p.group);
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Pattern {
+        std::string word;
+        uint32_t length;
+        int group;
+    };
+
+    std::vector<Pattern> patterns;
+    uint8_t byte_class[256] = {};       ///< 0 for bytes that appear in no keyword.
+    uint32_t classes = 1;
+    std::vector<uint32_t> next;         ///< next[state * classes + class], complete after build().
+    std::vector<uint32_t> dictionary;   ///< Longest proper suffix state that ends a keyword.
+    std::vector<uint32_t> output_begin; ///< outputs[output_begin[s], output_begin[s + 1]) end at s.
+    std::vector<uint32_t> outputs;
+};
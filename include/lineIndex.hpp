@@ -0,0 +1,240 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class LineIndex
+ * @brief A sequence of per-row weights with prefix sums, kept in a treap.
+ *
+ * Rows can be inserted, erased and reweighted, and the sum of the weights
+ * before a row (or the row containing a given sum) can be queried, all in
+ * O(log n) expected time. It backs the indexes that follow the rows of a
+ * buffer through its edits, e.g. how many screen lines each row wraps to.
+ *
+ * @tparam Weight An unsigned integer type.
+ */
+template <typename Weight>
+class LineIndex {
+public:
+    LineIndex() = default;
+
+    /**
+     * @brief Replaces the content with the given weights, in O(n).
+     */
+    void assign(const std::vector<Weight>& weights) {
+        nodes.clear();
+        free_nodes.clear();
+        nodes.reserve(weights.size() + 1);
+        nodes.push_back(Node{}); // slot 0 is the empty tree
+        seed = 0x9E3779B97F4A7C15ULL;
+        root = build(weights, 0, weights.size(), depth_of(weights.size()));
+    }
+
+    size_t size() const { return count(root); }
+    uint64_t total() const { return sum(root); }
+
+    /**
+     * @brief Returns the weight of a row.
+     */
+    Weight at(size_t row) const {
+        int t = root;
+        while (t) {
+            size_t left = count(nodes[t].left);
+            if (row < left) {
+                t = nodes[t].left;
+            } else if (row == left) {
+                return nodes[t].weight;
+            } else {
+                row -= left + 1;
+                t = nodes[t].right;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @brief Returns the sum of the weights of the rows before `row`.
+     */
+    uint64_t prefix(size_t row) const {
+        uint64_t acc = 0;
+        int t = root;
+        while (t) {
+            size_t left = count(nodes[t].left);
+            if (row <= left) {
+                t = nodes[t].left;
+            } else {
+                acc += sum(nodes[t].left) + nodes[t].weight;
+                row -= left + 1;
+                t = nodes[t].right;
+            }
+        }
+        return acc;
+    }
+
+    /**
+     * @brief Finds the row whose weight covers the given offset, that is the
+     * row r with prefix(r) <= offset < prefix(r + 1).
+     * @return The row, or size() when the offset is past the total.
+     */
+    size_t find(uint64_t offset) const {
+        size_t row = 0;
+        int t = root;
+        while (t) {
+            uint64_t left = sum(nodes[t].left);
+            if (offset < left) {
+                t = nodes[t].left;
+            } else if (offset < left + nodes[t].weight) {
+                return row + count(nodes[t].left);
+            } else {
+                offset -= left + nodes[t].weight;
+                row += count(nodes[t].left) + 1;
+                t = nodes[t].right;
+            }
+        }
+        return row;
+    }
+
+    /**
+     * @brief Changes the weight of a row.
+     */
+    void set(size_t row, Weight weight) {
+        set(root, row, weight);
+    }
+
+    /**
+     * @brief Inserts `n` rows of the given weight before `row`.
+     */
+    void insert(size_t row, size_t n, Weight weight) {
+        int left, right;
+        split(root, row, left, right);
+        for (size_t i = 0; i < n; ++i) {
+            left = merge(left, make(weight));
+        }
+        root = merge(left, right);
+    }
+
+    /**
+     * @brief Removes `n` rows starting at `row`.
+     */
+    void erase(size_t row, size_t n) {
+        int left, middle, right;
+        split(root, row, left, middle);
+        split(middle, n, middle, right);
+        release(middle);
+        root = merge(left, right);
+    }
+
+private:
+    struct Node {
+        int left = 0;
+        int right = 0;
+        uint32_t priority = 0;
+        uint32_t count = 0;   ///< Rows in the subtree.
+        Weight weight = 0;
+        uint64_t sum = 0;     ///< Weights in the subtree.
+    };
+
+    std::vector<Node> nodes{1};  // nodes[0] stands for the empty tree
+    std::vector<int> free_nodes;
+    int root = 0;
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+
+    size_t count(int t) const { return nodes[t].count; }
+    uint64_t sum(int t) const { return nodes[t].sum; }
+
+    uint32_t random() {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        return (uint32_t)seed;
+    }
+
+    void update(int t) {
+        Node& n = nodes[t];
+        n.count = 1 + nodes[n.left].count + nodes[n.right].count;
+        n.sum = n.weight + nodes[n.left].sum + nodes[n.right].sum;
+    }
+
+    int make(Weight weight, uint32_t priority) {
+        int t;
+        if (!free_nodes.empty()) {
+            t = free_nodes.back();
+            free_nodes.pop_back();
+        } else {
+            t = nodes.size();
+            nodes.emplace_back();
+        }
+        nodes[t] = Node{};
+        nodes[t].priority = priority;
+        nodes[t].weight = weight;
+        update(t);
+        return t;
+    }
+
+    int make(Weight weight) { return make(weight, random()); }
+
+    void release(int t) {
+        if (!t) return;
+        release(nodes[t].left);
+        release(nodes[t].right);
+        free_nodes.push_back(t);
+    }
+
+    static uint32_t depth_of(size_t n) {
+        uint32_t depth = 0;
+        while (n) { depth++; n >>= 1; }
+        return depth;
+    }
+
+    // Balanced build; priorities shrink with depth so the heap order holds
+    int build(const std::vector<Weight>& weights, size_t from, size_t to, uint32_t level) {
+        if (from >= to) return 0;
+        size_t mid = from + (to - from) / 2;
+        int t = make(weights[mid], (level << 26) | (random() >> 6));
+        nodes[t].left = build(weights, from, mid, level - 1);
+        nodes[t].right = build(weights, mid + 1, to, level - 1);
+        update(t);
+        return t;
+    }
+
+    // Splits t into its first k rows and the rest
+    void split(int t, size_t k, int& left, int& right) {
+        if (!t) {
+            left = right = 0;
+            return;
+        }
+        if (count(nodes[t].left) < k) {
+            split(nodes[t].right, k - count(nodes[t].left) - 1, nodes[t].right, right);
+            left = t;
+        } else {
+            split(nodes[t].left, k, left, nodes[t].left);
+            right = t;
+        }
+        update(t);
+    }
+
+    int merge(int left, int right) {
+        if (!left || !right) return left ? left : right;
+        if (nodes[left].priority > nodes[right].priority) {
+            nodes[left].right = merge(nodes[left].right, right);
+            update(left);
+            return left;
+        }
+        nodes[right].left = merge(left, nodes[right].left);
+        update(right);
+        return right;
+    }
+
+    void set(int t, size_t row, Weight weight) {
+        if (!t) return;
+        size_t left = count(nodes[t].left);
+        if (row < left) {
+            set(nodes[t].left, row, weight);
+        } else if (row == left) {
+            nodes[t].weight = weight;
+        } else {
+            set(nodes[t].right, row - left - 1, weight);
+        }
+        update(t);
+    }
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+
+/**
+ * @class LiteralFinder
+ * @brief Finds a plain string in a row, many bytes at a time.
+ *
+ * Blocks of the text are compared at once against the first byte of the
+ * needle and, shifted by its length, against its last byte; only the
+ * positions where both agree are compared in full, so a needle that is
+ * rare in the text costs about one vector compare per block. Uses AVX2 or
+ * SSE2 when the build targets them (CMake builds with -march=native), and
+ * plain bytes otherwise. Letters can be matched in either case.
+ */
+class LiteralFinder {
+public:
+    /**
+     * @brief Sets the string to look for.
+     * @param ignore_case Whether ASCII letters match in both cases.
+     */
+    void assign(const std::string& needle, bool ignore_case = false);
+
+    /**
+     * @brief The first position at or after `from` where the needle starts,
+     * or std::string::npos.
+     */
+    size_t find(const std::string& text, size_t from = 0) const { return find(text.data(), text.size(), from); }
+    size_t find(const char* text, size_t size, size_t from) const;
+
+    /**
+     * @brief The needle, in lower case when case is ignored.
+     */
+    const std::string& needle() const { return folded; }
+
+    bool ignores_case() const { return ignore_case; }
+
+    /**
+     * @brief The instructions the search was built with: "AVX2", "SSE2" or "scalar".
+     */
+    static const char* instruction_set();
+
+private:
+    std::string folded;   // the needle, with its letters lowered when case is ignored
+    std::string masks;    // 0x20 for each letter compared without case, else 0
+    bool ignore_case = false;
+
+    bool same(const char* text) const;
+};
@@ -6,6 +6,7 @@
 #include "screen.hpp"
 #include "command.hpp"
 #include "bufferManager.hpp"
+#include "frameScheduler.hpp"
 
 // mvimStarter class definition
 class mvimStarter {
@@ -18,17 +19,17 @@ private:
     Command _command;     // Command processor
     service mvimService;
     ColorManager mvimColorManager;
+    FrameScheduler scheduler; // Coalesces bursts of input into one frame
     bool benchmark;       // Flag to indicate if benchmarking is enabled
 
     void homeScreen();
     void initialize_ncurses();  // Helper function to initialize ncurses and colors
     void setDefaults();
     void updateVar();
+    void render_frame();  // Draw every window and flush them to the terminal
 
     void startBenchmark(std::string filename);
 
-    void print_bufferStructure(BufferManager::BufferStructure* buffer);
-
 public:
     // Constructors
     mvimStarter();
@@ -0,0 +1,171 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SearchPattern;
+
+/**
+ * @class GitIgnore
+ * @brief The patterns of the `.gitignore` files met on the way down a directory tree.
+ *
+ * Each directory holding a `.gitignore` gets its own rules, chained to those
+ * of the directory above: as in git, the last pattern of the deepest file
+ * that matches a path decides, and `!` patterns take a path back. Patterns
+ * with a slash before their end are anchored to the directory of their file,
+ * the others match a name at any depth; `*` and `?` stop at slashes, `**`
+ * does not, and a trailing slash only matches directories.
+ */
+class GitIgnore {
+public:
+    /**
+     * @brief The rules of a `.gitignore` read in `directory`, on top of `parent`.
+     * @param directory The directory of the file, relative to the root of the search ("" for the root).
+     */
+    GitIgnore(const std::string& text, const std::string& directory, std::shared_ptr<const GitIgnore> parent);
+
+    /**
+     * @brief Tells whether a path is ignored.
+     * @param path Relative to the root of the search, without a leading or trailing slash.
+     */
+    bool ignores(const std::string& path, bool directory) const;
+
+private:
+    struct Rule {
+        std::string glob;
+        bool negated = false;
+        bool directory_only = false;
+        bool anchored = false;   // matched against the whole path below `directory`, not only the name
+    };
+
+    std::string directory;   // with a trailing slash, or empty for the root
+    std::vector<Rule> rules;
+    std::shared_ptr<const GitIgnore> parent;
+};
+
+/**
+ * @class ProjectSearch
+ * @brief Searches every file below a directory with the find engine, on all cores.
+ *
+ * The worker threads share a stack of directories and files: a thread that
+ * lists a directory pushes what it holds, minus what `.gitignore` files and
+ * `.git` leave out, and any thread takes the next entry. Files are mapped in
+ * memory (small ones are read, which costs less than a mapping), files with a
+ * NUL byte in their first 8 KB are taken for binary and skipped, and each
+ * thread searches with its own copy of the pattern. When the term holds
+ * plain text, only the lines around the places that text appears are handed
+ * to the matcher. The lines that match are collected as they are found, one
+ * file at a time and already written out as rows, for the editor to take
+ * them between keystrokes.
+ */
+class ProjectSearch {
+public:
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief A line that matches: where it is, and the row that shows it.
+     */
+    struct Result {
+        std::shared_ptr<const std::string> path;   // relative to the root, shared by the lines of a file
+        size_t line;        // from 0
+        size_t col;         // of the first match on the line
+        std::string text;   // "path:line:col: " and the line, cut at MAX_TEXT bytes
+    };
+
+    static constexpr size_t MAX_TEXT = 500;
+
+    static ProjectSearch& instance() {
+        static ProjectSearch instance;
+        return instance;
+    }
+
+    ~ProjectSearch();
+
+    /**
+     * @brief Stops the search in progress and starts searching the files below `root`.
+     */
+    void start(const std::string& term, const std::string& root);
+
+    /**
+     * @brief Stops the search in progress; what it found so far is dropped.
+     */
+    void cancel();
+
+    /**
+     * @brief Moves the results found since the last call to the end of `out`.
+     * @return True once every file is searched and every result taken.
+     */
+    bool take(std::vector<Result>& out);
+
+    /**
+     * @brief Waits until every file is searched (for tests and benchmarks).
+     */
+    void wait();
+
+    /**
+     * @brief Files searched, files with a match, and binary files skipped so far.
+     */
+    size_t files() const { return searched; }
+    size_t matched_files() const { return matched; }
+    size_t binary_files() const { return binary; }
+
+    /**
+     * @brief Milliseconds the last search took (0 while it is running).
+     */
+    double elapsed_ms() const { return duration_ms; }
+
+    /**
+     * @brief Changes the number of threads (one per core by default).
+     */
+    void resize(size_t threads) { count = threads ? threads : 1; }
+
+    /**
+     * @brief Appends the lines of a text that match, one result per line, as for each file.
+     */
+    static void search_text(const char* text, size_t size, SearchPattern& pattern, const std::shared_ptr<const std::string>& path,
+                            std::vector<Result>& out);
+
+private:
+    ProjectSearch();
+    ProjectSearch(const ProjectSearch&) = delete;
+    ProjectSearch& operator=(const ProjectSearch&) = delete;
+
+    static constexpr size_t BINARY_PROBE = 8192;      // bytes looked at for a NUL
+    static constexpr size_t MAP_BYTES = 64 * 1024;    // files this large are mapped, smaller ones read
+
+    struct Entry {
+        std::string path;   // relative to the root
+        bool directory;
+        std::shared_ptr<const GitIgnore> ignore;   // the rules of the directory it is in
+    };
+
+    size_t count;
+    std::vector<std::thread> workers;
+    std::string root;
+    std::shared_ptr<const SearchPattern> prototype;   // never searched with: the workers copy it
+    clock::time_point started;
+
+    // --- Shared with the workers, under lock ---
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    std::vector<Entry> entries;   // taken from the back: depth first, so it stays short
+    size_t busy = 0;              // workers holding an entry
+    size_t running = 0;           // workers not done yet
+    bool stopping = false;
+    std::vector<Result> found;
+    std::atomic<size_t> searched{0};
+    std::atomic<size_t> matched{0};
+    std::atomic<size_t> binary{0};
+    std::atomic<double> duration_ms{0};
+
+    void stop();
+    void run();
+    void list(const Entry& directory, std::vector<Entry>& out);
+    void search_file(std::string& path, SearchPattern& pattern, std::vector<char>& scratch, std::vector<Result>& out);
+};
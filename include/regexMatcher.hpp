@@ -0,0 +1,214 @@
+#pragma once
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "literalFinder.hpp"
+
+/**
+ * @class RegexMatcher
+ * @brief Finds the matches of a regular expression in time linear in the text.
+ *
+ * The pattern (std::regex's ECMAScript syntax, without backreferences and
+ * lookarounds) is compiled into an NFA, and DFA states are built from it
+ * lazily, only for the state/byte pairs the text asks for, so a search is one
+ * table lookup per byte whatever the pattern. The forward DFA keeps the NFA
+ * threads in priority order and drops the ones behind a match, so a match
+ * ends where a backtracking engine would end it (`x|xy`, `a*?`); its start
+ * comes from a scan of the reversed pattern back from that end.
+ * Patterns that start with a literal skip ahead with a LiteralFinder, and
+ * plain literals do not use the automaton at all; a class of the two cases
+ * of a letter (`[Ii][Dd]`) counts as a literal letter matched without case.
+ * Unlike std::regex, a loop whose body matched empty may go on (`(a*?)+`
+ * can match "a" where std::regex stops at ""); the start is the same.
+ * Rows can also be searched as one text, a '\n' between two of them, for
+ * the patterns that name the line break; `^` and `$` then hold at the start
+ * and end of every row, as they do when each row is searched on its own.
+ */
+class RegexMatcher {
+public:
+    enum class Status { COMPILED, SYNTAX_ERROR, UNSUPPORTED };
+
+    /**
+     * @brief A place in rows read as one text: a row, and a byte of it (its size is the line break).
+     */
+    struct Position {
+        size_t row;
+        size_t col;
+    };
+
+    /**
+     * @brief Compiles a pattern; the matcher only searches once it is COMPILED.
+     * @return UNSUPPORTED for valid patterns that need backtracking (backreferences, lookarounds).
+     */
+    Status compile(const std::string& pattern);
+
+    /**
+     * @brief Why the last compile failed.
+     */
+    const std::string& error() const { return message; }
+
+    /**
+     * @brief Finds the leftmost match that starts at or after `from`.
+     * @param start, end The match found, [start, end); it may be empty.
+     */
+    bool search(const std::string& text, size_t from, size_t& start, size_t& end);
+
+    /**
+     * @brief Finds the leftmost match at or after `from` in rows read as one
+     * text, a '\n' between two rows, without joining them.
+     * @param from Where to search from. Moved past the match found; when there
+     * is none, moved on to the first row where no match has started yet
+     * (`rows.size()` at the end of the text).
+     * @param until Matches are only looked for until this row: the search stops
+     * there unless one may have started before it, and the match it then finds
+     * can start past `until`.
+     */
+    bool search_rows(const std::deque<std::string>& rows, Position& from, size_t until, Position& start, Position& end);
+
+    /**
+     * @brief Calls on_match(start, end) for each match of a row, left to right,
+     * moving one byte on after an empty match.
+     */
+    template<typename OnMatch>
+    void for_each(const std::string& text, OnMatch&& on_match)
+    {
+        size_t from = 0;
+        size_t start, end;
+        while (from <= text.size() && search(text, from, start, end)) {
+            on_match(start, end);
+            from = end > start ? end : end + 1;
+        }
+    }
+
+    /**
+     * @brief Tells whether the pattern is plain text, `required_prefix()` itself.
+     */
+    bool is_literal() const { return literal && !folded; }
+
+    /**
+     * @brief Text every match starts with (empty if none is known, or if its case can vary).
+     */
+    const std::string& required_prefix() const { return prefix; }
+
+    /**
+     * @brief Texts every match contains, in lower case: each run of single bytes
+     * (or letters in both cases) the pattern cannot do without.
+     */
+    const std::vector<std::string>& required_literals() const { return literals; }
+
+    /**
+     * @brief Tells whether the pattern names the line break (`\n`): only a search
+     * of the rows as one text can find its matches.
+     */
+    bool is_multiline() const { return multiline; }
+
+    /**
+     * @brief Tells whether the pattern is plain text with some letters in either case.
+     */
+    bool is_folded_literal() const { return literal && folded; }
+
+    /**
+     * @brief DFA states built so far, in both directions.
+     */
+    size_t dfa_states() const { return forward.states.size() + backward.states.size(); }
+
+private:
+    enum Assertion : uint8_t { BEGIN_TEXT, END_TEXT, WORD_BOUNDARY, NOT_WORD_BOUNDARY };
+
+    struct Node {
+        enum Kind : uint8_t { EMPTY, SET, CONCAT, ALTERNATE, REPEAT, ASSERT } kind;
+        int set = -1;
+        Assertion assertion = BEGIN_TEXT;
+        int min = 0;
+        int max = 0;   // -1: no bound
+        bool greedy = true;
+        std::vector<int> children;
+    };
+
+    struct Inst {
+        enum Op : uint8_t { SET, SPLIT, EMPTY, ASSERT, MATCH } op;
+        Assertion assertion = BEGIN_TEXT;
+        int set = -1;
+        int out = -1;
+        int out1 = -1;   // SPLIT: the lower priority branch
+    };
+
+    // The automaton of one direction, built as the scans need it
+    struct Dfa {
+        static constexpr int32_t UNKNOWN = -1;
+        static constexpr int32_t MATCH_BIT = 1 << 30;   // a match ends right before the byte
+        static constexpr size_t MAX_STATES = 4096;      // the cache starts over past this
+        static constexpr uint8_t AT_BEGIN = 1;
+        static constexpr uint8_t AFTER_WORD = 2;
+
+        std::vector<Inst> insts;
+        int start_pc = 0;
+        bool longest = false;   // keep going after a match for a longer one
+
+        uint16_t byte_class[256] = {};
+        std::vector<uint8_t> representative;   // a byte of each class
+        size_t stride = 0;                     // classes, plus one for the end of the text
+
+        struct State {
+            std::vector<int> pcs;   // NFA threads, by priority, before their empty moves
+            uint8_t flags;
+        };
+        std::vector<State> states;
+        std::vector<int32_t> next;   // next[state * stride + class], with MATCH_BIT
+        std::unordered_map<std::string, int32_t> index;
+        int32_t starts[4] = {-1, -1, -1, -1};
+        int32_t dead = 0;
+
+        size_t resets = 0;
+        std::vector<uint32_t> seen;
+        uint32_t generation = 0;
+        std::vector<int> stack, list, moved;
+
+        // The transition of a state on a byte class (stride - 1: the end of the text)
+        int32_t move(int32_t state, size_t cls, const std::vector<std::bitset<256>>& sets)
+        {
+            int32_t value = next[state * stride + cls];
+            return value != UNKNOWN ? value : step(state, cls, sets);
+        }
+
+        void clear();
+        int32_t start(uint8_t flags);
+        bool is_start(int32_t state) const;
+        int32_t step(int32_t state, size_t cls, const std::vector<std::bitset<256>>& sets);
+        int32_t add(const std::vector<int>& pcs, uint8_t flags);
+        void follow(int pc, uint8_t flags, int byte);
+    };
+
+    std::vector<Node> nodes;
+    std::vector<std::bitset<256>> sets;
+    Dfa forward;
+    Dfa backward;
+    std::string prefix;    // every match starts with it
+    std::vector<std::string> literals;   // every match contains them, in lower case
+    LiteralFinder finder;  // finds what every match starts with, `prefix` or the same ignoring case
+    bool folded = false;   // the letters of the finder's needle match in either case
+    bool literal = false;  // the whole pattern is the finder's needle
+    bool multiline = false;   // the pattern has a \n
+    bool ready = false;
+    std::string message;
+
+    // Parsing
+    struct Parser;
+    int add_node(Node node);
+    int add_set(const std::bitset<256>& set);
+
+    // Compiling, one direction at a time
+    struct Fragment {
+        int start;
+        std::vector<int> holes;   // pc * 2 + (0: out, 1: out1), still to point somewhere
+    };
+    bool emit(Dfa& dfa, int node, bool reversed, Fragment& fragment);
+    bool build(Dfa& dfa, int root, bool reversed);
+    void find_prefix(int root);
+    void find_literals(int id, std::string& run);
+
+    static bool is_word(int byte);
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <ncurses.h>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class RenderCache
+ * @brief Remembers the cells last drawn on every screen row of a window.
+ *
+ * Each visible row is built once into a `chtype` array that already carries
+ * the syntax and search colors, so it can be printed with a single
+ * `mvwaddchnstr`. A cached line is rebuilt only when something it depends on
+ * changes: the buffer row it shows, the text of that row, the horizontal
+ * scroll, the width of the window or the colors layered on top of it.
+ */
+class RenderCache {
+public:
+    struct Line {
+        bool valid = false;
+        size_t row = 0;             ///< Buffer row shown on this screen row.
+        size_t starting_col = 0;    ///< First visible column when built.
+        size_t width = 0;           ///< Number of text columns when built.
+        uint64_t style = 0;         ///< Language and lexer state at the start of the row.
+        uint64_t overlay = 0;       ///< Signature of the search matches drawn on the row.
+        int end_state = 0;          ///< Lexer state at the end of the row, fed to the next one.
+        bool continuation = false;  ///< Wrapped part of a row: the gutter is left blank.
+        std::string text;           ///< Text the cells were built from.
+        std::vector<chtype> cells;  ///< Line number gutter followed by the visible text.
+    };
+
+    /**
+     * @brief Returns the cache slot of a screen row, growing the cache if needed.
+     * @param screen_row The row inside the window.
+     */
+    Line& slot(size_t screen_row) {
+        if (screen_row >= lines.size()) {
+            lines.resize(screen_row + 1);
+        }
+        return lines[screen_row];
+    }
+
+    /**
+     * @brief Checks whether a slot still holds the cells for the given inputs.
+     */
+    static bool matches(const Line& line, size_t row, const std::string& text,
+                        size_t starting_col, size_t width, uint64_t style, uint64_t overlay,
+                        bool continuation = false) {
+        return line.valid && line.row == row && line.starting_col == starting_col &&
+               line.width == width && line.style == style && line.overlay == overlay &&
+               line.continuation == continuation && line.text == text;
+    }
+
+    /**
+     * @brief Drops every cached line, e.g. after a resize or a color change.
+     */
+    void invalidate() {
+        for (auto& line : lines) {
+            line.valid = false;
+        }
+    }
+
+    /**
+     * @brief Moves the cached lines after the window was scrolled, so every
+     * slot keeps describing its screen row. Slots exposed by the scroll are
+     * invalidated.
+     * @param delta Rows scrolled: positive when the text moved up.
+     * @param rows Height of the scrolled region.
+     */
+    void shift_rows(long delta, size_t rows) {
+        if (lines.size() < rows) {
+            lines.resize(rows);
+        }
+        size_t shift = std::min<size_t>(delta > 0 ? delta : -delta, rows);
+        if (delta > 0) {
+            std::rotate(lines.begin(), lines.begin() + shift, lines.begin() + rows);
+            for (size_t i = rows - shift; i < rows; ++i) lines[i].valid = false;
+        } else {
+            std::rotate(lines.begin(), lines.begin() + (rows - shift), lines.begin() + rows);
+            for (size_t i = 0; i < shift; ++i) lines[i].valid = false;
+        }
+    }
+
+    bool drawn = false;          ///< Whether top_row/left_col describe a frame on screen.
+    bool wrapped = false;        ///< Whether the last frame wrapped long rows.
+    size_t top_row = 0;          ///< First screen line of the last frame (its first row without wrapping).
+    size_t left_col = 0;         ///< First visible column of the last frame.
+
+private:
+    std::vector<Line> lines;
+};
@@ -4,7 +4,10 @@
 #include <ncurses.h>
 #include <string>
 #include <chrono>
+#include <map>
 #include <vector>
+#include "renderCache.hpp"
+#include "surface.hpp"
 
 /**
  * @class Screen
@@ -42,6 +45,12 @@ private:
     std::string status_message;
     std::chrono::steady_clock::time_point message_timestamp;
     int message_color_pair;
+
+    std::map<const void*, RenderCache> render_caches; ///< Cells last drawn in every window or surface.
+
+    NcursesSurface window_surface;  ///< Wraps pointed_window when drawing on the terminal.
+    Surface* headless = nullptr;    ///< Surface replacing the terminal, if any.
+    unsigned long long_row_notice = 0;  ///< Document last told that its long rows are not highlighted.
 public:
     /**
      * @brief Gets the singleton instance of the Screen class.
@@ -108,9 +117,35 @@ public:
 
     void print_buffer(WINDOW* window);
 
-    void print_buffer(const std::deque<std::string> &buffer, WINDOW* window, size_t starting_row, size_t starting_col, size_t max_col);
+    void print_buffer(const std::deque<std::string> &buffer, WINDOW* window, size_t starting_row, size_t starting_col, size_t max_col, size_t max_row);
 
+    /**
+     * @brief Redraws the windows of the inactive buffers whose document,
+     * size or scroll position changed since they were last drawn.
+     * Windows are only queued with wnoutrefresh; the caller flushes them
+     * together with a single doupdate.
+     */
     void refresh_all_buffers(); 
 
     void set_status_message(const std::string& msg, int color_pair = 1);
+
+    /**
+     * @brief Draws the active buffer and the status bar on the given surface
+     * instead of the terminal; nullptr goes back to the terminal.
+     * While a surface is set nothing is sent to ncurses, so the editor can
+     * render without a terminal (tests and benchmarks).
+     */
+    void set_surface(Surface* surface);
+
+    /**
+     * @brief Returns the surface the active buffer is drawn on.
+     */
+    Surface& surface();
+
+    /**
+     * @brief Forgets the rows cached for a window (or for all windows),
+     * forcing them to be rebuilt on the next print.
+     * @param window The window to invalidate, nullptr for every window.
+     */
+    void invalidate_render_cache(WINDOW* window = nullptr);
 };
\ No newline at end of file
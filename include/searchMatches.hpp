@@ -0,0 +1,198 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace editor {
+
+// Structure to hold variable-length match data for Regex: it runs from (row, col) to
+// (end_row, end_col), end excluded, and `length` counts its bytes with a '\n' between rows
+struct SearchMatch {
+    int row;
+    int col;
+    int length;
+    int end_row;
+    int end_col;
+};
+
+/**
+ * @class SearchMatches
+ * @brief The matches of a search, kept in blocks of consecutive matches.
+ *
+ * Each block holds up to a few thousand matches and a row shift added to the
+ * rows of its matches when they are read, so rows inserted or erased above
+ * a match move it without touching it: an edit costs the matches of the
+ * rows it touches and one step per block, not one per match. The blocks
+ * know where they start in the list, so a match is found by its index or,
+ * while the list is sorted, by its position, with a binary search.
+ * Matches are read by value, with their shift applied.
+ */
+class SearchMatches {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = SearchMatch;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const SearchMatch*;
+        using reference = SearchMatch;
+
+        const_iterator(const SearchMatches* list, size_t block, size_t offset) : list(list), block(block), offset(offset) { load(); }
+
+        SearchMatch operator*() const
+        {
+            SearchMatch match = matches[offset];
+            match.row += shift;
+            match.end_row += shift;
+            return match;
+        }
+
+        const_iterator& operator++()
+        {
+            if (++offset == size) {
+                ++block;
+                offset = 0;
+                load();
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const { return block == other.block && offset == other.offset; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        const SearchMatches* list;
+        size_t block;
+        size_t offset;
+        const SearchMatch* matches = nullptr;   // those of the block, read without going through the list
+        size_t size = 0;
+        int shift = 0;
+
+        void load()
+        {
+            if (block < list->blocks.size()) {
+                matches = list->blocks[block].matches.data();
+                size = list->blocks[block].matches.size();
+                shift = list->blocks[block].shift;
+            }
+        }
+    };
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    void clear();
+
+    SearchMatch operator[](size_t index) const;
+    SearchMatch front() const { return blocks.front().at(0); }
+    SearchMatch back() const { return blocks.back().at(blocks.back().matches.size() - 1); }
+
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, blocks.size(), 0); }
+
+    /**
+     * @brief An iterator on the match at `index`, to read the matches from there on in turn.
+     */
+    const_iterator iterator_at(size_t index) const
+    {
+        if (index >= count) return end();
+        std::pair<size_t, size_t> at = locate(index);
+        return const_iterator(this, at.first, at.second);
+    }
+
+    /**
+     * @brief Appends matches, in any order (a search appends them in scan order).
+     */
+    void append(const std::vector<SearchMatch>& matches);
+
+    /**
+     * @brief Puts matches before the one at `index`.
+     */
+    void insert(size_t index, const std::vector<SearchMatch>& matches);
+
+    /**
+     * @brief Removes the matches [first, last).
+     */
+    void erase(size_t first, size_t last);
+
+    /**
+     * @brief Moves the matches from `middle` on to the front, as std::rotate does.
+     * Only the block `middle` falls in is split: the others move as a whole.
+     */
+    void rotate(size_t middle);
+
+    /**
+     * @brief The index of the first match for which `pred` is false, where
+     * `pred` is true for the matches before some point and false after it.
+     */
+    template<typename Pred>
+    size_t partition_point(Pred&& pred) const
+    {
+        size_t lo = 0, hi = blocks.size();
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (pred(blocks[mid].at(blocks[mid].matches.size() - 1))) lo = mid + 1;
+            else hi = mid;
+        }
+        if (lo == blocks.size()) {
+            return count;
+        }
+        const Block& block = blocks[lo];
+        size_t first = 0, last = block.matches.size();
+        while (first < last) {
+            size_t mid = (first + last) / 2;
+            if (pred(block.at(mid))) first = mid + 1;
+            else last = mid;
+        }
+        return starts[lo] + first;
+    }
+
+    // --- While the matches are sorted by position ---
+
+    /**
+     * @brief The matches of a row, [first, last).
+     */
+    std::pair<size_t, size_t> in_row(int row) const;
+
+    /**
+     * @brief Replaces the matches of a row with those found in it again.
+     */
+    void replace_row(int row, const std::vector<SearchMatch>& matches);
+
+    /**
+     * @brief Moves the matches of the rows from `row` on down by `rows`, as
+     * when that many rows are inserted before it.
+     */
+    void insert_rows(int row, int rows);
+
+    /**
+     * @brief Drops the matches of rows [row, row + rows) and moves those below up.
+     */
+    void erase_rows(int row, int rows);
+
+private:
+    static constexpr size_t BLOCK = 2048;   // blocks are split past twice this
+
+    struct Block {
+        int shift = 0;   // added to the rows of the matches
+        std::vector<SearchMatch> matches;
+
+        SearchMatch at(size_t i) const
+        {
+            SearchMatch match = matches[i];
+            match.row += shift;
+            match.end_row += shift;
+            return match;
+        }
+    };
+
+    std::vector<Block> blocks;    // none of them empty
+    std::vector<size_t> starts;   // the index of the first match of each block
+    size_t count = 0;
+
+    std::pair<size_t, size_t> locate(size_t index) const;
+    void recount(size_t from);
+    void shift_rows(int row, int delta);
+};
+
+} // namespace editor
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "editor.hpp"
+
+struct SearchPattern;
+
+/**
+ * @class SearchPool
+ * @brief Searches rows of the buffer on every core.
+ *
+ * A search is cut into chunks of rows. The worker threads and the calling
+ * thread take the chunks one after another until none is left, and the
+ * caller only returns once the last one is done: the rows are read in place,
+ * and they cannot change while the thread that edits them is waiting.
+ * Each thread searches with its own copy of the pattern (the matcher builds
+ * its automaton as it goes, so it cannot be shared), and each chunk keeps
+ * its own matches, for the caller to merge them in row order.
+ */
+class SearchPool {
+public:
+    /**
+     * @brief Rows to search, and the matches found in them.
+     */
+    struct Chunk {
+        std::vector<int> rows;                      // in the order they are searched
+        std::vector<editor::SearchMatch> matches;   // row after row, in the same order
+    };
+
+    static SearchPool& instance() {
+        static SearchPool instance;
+        return instance;
+    }
+
+    ~SearchPool();
+
+    /**
+     * @brief Fills the matches of every chunk, searching them on all the threads.
+     * @param lines The rows of the buffer, left untouched until the call returns.
+     * @param pattern The compiled term, only used by the calling thread.
+     */
+    void search(const std::deque<std::string>& lines, const std::shared_ptr<SearchPattern>& pattern, std::vector<Chunk>& chunks);
+
+    /**
+     * @brief Threads a search runs on, the caller included.
+     */
+    size_t threads() const { return count; }
+
+    /**
+     * @brief Changes the number of threads (one per core by default).
+     */
+    void resize(size_t threads);
+
+private:
+    SearchPool();
+    SearchPool(const SearchPool&) = delete;
+    SearchPool& operator=(const SearchPool&) = delete;
+
+    size_t count;
+    std::vector<std::thread> workers;   // count - 1 of them, started by the first search
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    bool stopping = false;
+
+    // The search in progress, under lock but for `next`
+    unsigned long generation = 0;
+    bool open = false;
+    const std::deque<std::string>* lines = nullptr;
+    std::vector<Chunk>* chunks = nullptr;
+    std::shared_ptr<SearchPattern> source;                // the pattern `prototype` was copied from
+    std::shared_ptr<const SearchPattern> prototype;       // never searched with: the workers copy it
+    std::atomic<size_t> next{0};                          // the next chunk to take
+    size_t done = 0;                                      // chunks searched
+    size_t working = 0;                                   // workers inside the search
+
+    void stop();
+    void run();
+    static size_t take(const std::deque<std::string>& lines, SearchPattern& pattern, std::vector<Chunk>& chunks, std::atomic<size_t>& next);
+};
@@ -1,4 +1,5 @@
 #include "editor.hpp"
+#include "backgroundHighlighter.hpp"
 
 class service {
 public:
@@ -6,9 +7,9 @@ public:
     service() {
         // Initialize default services
         
-        modes.emplace_back("find", true, []() { editor::find::highlight_searched_word(); });
-        modes.emplace_back("highlighting", true, []() { editor::visual::highlight_keywords(); }); 
         modes.emplace_back("visual", true, []() { editor::visual::highlight_selected(); });
+        modes.emplace_back("brackets", true, []() { editor::visual::highlight_matching_bracket(); });
+        modes.emplace_back("highlight", true, []() { BackgroundHighlighter::instance().schedule(buffer, starting_row); });
     }
 
     // Enables a mode and sets the associated editor
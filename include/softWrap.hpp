@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "lineIndex.hpp"
+#include "textBuffer.hpp"
+
+/**
+ * @class SoftWrap
+ * @brief Maps buffer rows to screen lines when long rows are wrapped.
+ *
+ * The number of screen lines every row of the active buffer takes is kept
+ * in a LineIndex, so the first screen line of a row and the row shown on a
+ * screen line are both found in O(log n). The index follows the buffer
+ * through its edit journal: editing a row only reweights that row. It is
+ * rebuilt when the text width changes or another document becomes active.
+ */
+class SoftWrap {
+public:
+    static SoftWrap& instance() {
+        static SoftWrap instance;
+        return instance;
+    }
+
+    /**
+     * @brief Brings the index up to date with a buffer and a text width.
+     */
+    void sync(const textBuffer& text, size_t width);
+
+    /**
+     * @brief Screen lines taken by a row of the given length.
+     * The end of a row always gets a cell, so the cursor can stand after
+     * the last character.
+     */
+    size_t height(size_t length) const { return length / width + 1; }
+
+    /**
+     * @brief Returns the first screen line of a row, counted from the top of the document.
+     */
+    uint64_t line_of(size_t row) const { return lines.prefix(row); }
+
+    /**
+     * @brief Returns the row shown on a screen line, counted from the top of the document.
+     */
+    size_t row_at(uint64_t line) const { return lines.find(line); }
+
+    /**
+     * @brief Screen lines of the whole document.
+     */
+    uint64_t total_lines() const { return lines.total(); }
+
+    /**
+     * @brief Scrolls the view so the cursor is visible, keeping the scroll
+     * margin, and places the cursor on its wrapped screen line.
+     * Works on the active buffer (the global system variables).
+     */
+    void follow_cursor();
+
+    /**
+     * @brief Finds the buffer position shown at a point of the active window.
+     * @param y The screen line inside the window.
+     * @param x The column inside the window, gutter included.
+     * @param row Receives the buffer row, clamped to the document.
+     * @param col Receives the column, clamped to the row.
+     */
+    void hit(int y, int x, int& row, int& col);
+
+    /**
+     * @brief Finds where a buffer position is drawn in the active window.
+     * @return false if the position is above or below the window.
+     */
+    bool position(size_t row, size_t col, int& y, int& x) const;
+
+private:
+    SoftWrap() = default;
+
+    LineIndex<uint32_t> lines;     ///< Screen lines taken by every row.
+    unsigned long document = 0;    ///< Document the index describes.
+    unsigned long version = 0;     ///< Buffer version the index matches.
+    size_t width = 1;              ///< Text columns per screen line.
+    bool built = false;
+    std::vector<BufferEdit> edits; ///< Scratch space for the journal.
+
+    void rebuild(const textBuffer& text);
+};
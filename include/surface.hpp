@@ -0,0 +1,100 @@
+#pragma once
+#include <ncurses.h>
+#include <string>
+#include <vector>
+
+/**
+ * @class Surface
+ * @brief A grid of attributed cells the screen is drawn on.
+ *
+ * The Screen renders through this interface instead of calling ncurses
+ * directly, so the same drawing code can target a terminal window or an
+ * in-memory grid (tests and benchmarks, where no terminal exists).
+ * Cells are ncurses `chtype`s: a character plus its attributes and color pair.
+ */
+class Surface {
+public:
+    virtual ~Surface() = default;
+
+    virtual int rows() const = 0;
+    virtual int cols() const = 0;
+
+    /**
+     * @brief Writes n cells starting at (y, x), clipped to the row.
+     */
+    virtual void put(int y, int x, const chtype* cells, int n) = 0;
+
+    /**
+     * @brief Blanks every row from y to the bottom.
+     */
+    virtual void clear_below(int y) = 0;
+
+    /**
+     * @brief Moves the first `height` rows up by delta (down when negative).
+     * Rows exposed by the move are blank.
+     */
+    virtual void scroll_rows(int height, int delta) = 0;
+
+    /**
+     * @brief Changes the attributes and color of n cells, keeping their characters.
+     */
+    virtual void recolor(int y, int x, int n, attr_t attrs, short pair) = 0;
+};
+
+/**
+ * @class NcursesSurface
+ * @brief Draws on an ncurses window.
+ */
+class NcursesSurface : public Surface {
+public:
+    explicit NcursesSurface(WINDOW* window = nullptr) : window(window) {}
+
+    void set_window(WINDOW* target) { window = target; }
+    WINDOW* get_window() const { return window; }
+
+    int rows() const override;
+    int cols() const override;
+    void put(int y, int x, const chtype* cells, int n) override;
+    void clear_below(int y) override;
+    void scroll_rows(int height, int delta) override;
+    void recolor(int y, int x, int n, attr_t attrs, short pair) override;
+
+private:
+    WINDOW* window;
+};
+
+/**
+ * @class CellGrid
+ * @brief Keeps the drawn cells in memory; needs no terminal.
+ */
+class CellGrid : public Surface {
+public:
+    CellGrid(int rows, int cols);
+
+    int rows() const override { return height; }
+    int cols() const override { return width; }
+    void put(int y, int x, const chtype* cells, int n) override;
+    void clear_below(int y) override;
+    void scroll_rows(int height, int delta) override;
+    void recolor(int y, int x, int n, attr_t attrs, short pair) override;
+
+    /**
+     * @brief Returns the cell at (y, x).
+     */
+    chtype at(int y, int x) const { return cells[y * width + x]; }
+
+    /**
+     * @brief Returns the color pair of the cell at (y, x).
+     */
+    short pair_at(int y, int x) const { return PAIR_NUMBER(at(y, x)); }
+
+    /**
+     * @brief Returns the characters of a row, trailing blanks removed.
+     */
+    std::string row_text(int y) const;
+
+private:
+    int height;
+    int width;
+    std::vector<chtype> cells;
+};
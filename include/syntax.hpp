@@ -2,13 +2,17 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <unordered_map>
 #include <ncurses.h>
 #include <filesystem>
 #include "globals/mvimResources.h"
+#include "keywordMatcher.hpp"
+#include "tokenLexer.hpp"
 
 struct SyntaxGroup {
     std::vector<std::string> keywords;
-    short color;
+    const short* color; // points at the color scheme entry, resolved when drawing
 };
 
 struct Language {
@@ -20,32 +24,68 @@ struct Language {
     std::string multiLineCommentStart; 
     std::string multiLineCommentEnd;   
     std::string brackets; 
+
+    TokenRules tokenRules;
+
+    KeywordMatcher keywordMatcher; // every keyword of every group, built with the language
+    TokenLexer lexer;              // comments, strings, numbers and types, built from tokenRules
 };
 
 class SyntaxHighlighter {
 public:
     static SyntaxHighlighter& instance() {
         static SyntaxHighlighter instance;
+        // Load on first use, outside the constructor: loading may report to the
+        // status bar, which redraws the screen and asks for the highlighter again
+        if (!instance.loaded) {
+            instance.loaded = true;
+            instance.loadLanguages();
+        }
         return instance;
     }
 
-    // Load all .mvimlang files from the 'languages' directory
+    // Index the .mvimlang files of the 'languages' directory
     void loadLanguages();
 
+    // Index the .mvimlang files of a directory: only their name and extensions
+    // are read, a language is parsed the first time a file needs it
+    void indexLanguages(const std::filesystem::path& dir);
+
+    // Sets the language of the active buffer (pointed_language); every
+    // buffer keeps its own, saved and restored by the BufferManager
     void setLanguageFromFile(const std::string& filename);
     const Language* getCurrentLanguage() const;
 
+    size_t indexedLanguages() const { return languageFiles.size(); }
+
 private:
-    SyntaxHighlighter() { 
-        // Try to load immediately on startup
-        loadLanguages(); 
-    }
+    SyntaxHighlighter() = default;
+
+    struct LanguageFile {
+        std::filesystem::path path;
+        std::string name;
+        std::vector<std::string> extensions;
+    };
+
+    struct CompiledLanguage {
+        std::filesystem::file_time_type mtime;
+        const Language* language;
+    };
     
-    std::vector<Language> languages;
-    const Language* currentLanguage = nullptr;
+    bool loaded = false;
+    std::vector<LanguageFile> languageFiles;
+    std::unordered_map<std::string, size_t> filesByExtension;      // first file wins, as in the directory listing
+    std::unordered_map<std::string, CompiledLanguage> compiled;    // by path, reparsed when the file changes
+    std::vector<std::unique_ptr<Language>> compiledLanguages;      // never freed: caches keep pointers to them
     
     std::string getExtension(const std::string& filename);
+
+    // Reads the name and extensions of a language file, stopping as soon as both are known
+    bool readHeader(const std::filesystem::path& path, LanguageFile& file);
+
+    // Returns the compiled language of a file, parsing it on first use
+    const Language* compile(const LanguageFile& file);
     
     // Helper to parse a single file
-    void parseLanguageFile(const std::filesystem::path& path);
+    bool parseLanguageFile(const std::filesystem::path& path, Language& lang);
 };
\ No newline at end of file
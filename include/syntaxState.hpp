@@ -0,0 +1,56 @@
+#pragma once
+#include <set>
+#include <vector>
+#include "documentStates.hpp"
+#include "textBuffer.hpp"
+
+struct Language;
+
+/**
+ * @class SyntaxStateCache
+ * @brief Remembers the lexer state at the end of every row of a document.
+ *
+ * Highlighting a row needs the state it starts in (e.g. "inside a block
+ * comment"), which depends on every row above it, also the ones above the
+ * window. States are kept per row and follow the buffer's edit journal:
+ * an edited row is only marked stale, and when a state is asked for, the
+ * rows are lexed again forward from the first stale one until the end
+ * state matches the stored one. So a keystroke costs the rows it actually
+ * changed, not the rows above the window.
+ */
+class SyntaxStateCache {
+public:
+    static SyntaxStateCache& instance() {
+        static SyntaxStateCache instance;
+        return instance;
+    }
+
+    /**
+     * @brief Returns the lexer state at the start of a row of the buffer,
+     * lexed with the current language. Every document keeps its own states.
+     */
+    bool state_before(const textBuffer& text, size_t row);
+
+private:
+    SyntaxStateCache() = default;
+
+    // The states of one document, kept while the buffer is in the background
+    struct Document {
+        std::vector<unsigned char> end_states;  ///< State at the end of each row.
+        std::set<size_t> stale;                 ///< Rows whose end state must be recomputed.
+        size_t valid = 0;                       ///< Rows from the top that were lexed at least once.
+        unsigned long version = 0;
+        const Language* language = nullptr;
+        bool built = false;
+
+        void sync(const textBuffer& text, std::vector<BufferEdit>& edits);
+        void reset(size_t rows);
+        void mark_stale(size_t row);
+
+        // Lexes the stale rows above `row`, going on past a row only while its end state changes
+        void relex(const textBuffer& text, size_t row);
+    };
+
+    DocumentStates<Document> documents;
+    std::vector<BufferEdit> edits;          ///< Scratch space for the journal.
+};
@@ -4,6 +4,35 @@
 #include <vector>
 #include <deque>
 
+/**
+ * @brief A change to the rows of a buffer, recorded so that indexes built
+ * over the rows can be updated instead of rebuilt.
+ */
+struct BufferEdit
+{
+  enum Kind
+  {
+    CHANGE,   ///< The content of `row` changed.
+    INSERT,   ///< `count` rows were inserted before `row`.
+    ERASE,    ///< `count` rows starting at `row` were removed.
+    RESET     ///< The whole content was replaced.
+  };
+
+  Kind kind;
+  int row;
+  int count;
+};
+
+/**
+ * @brief Rows that take the place of a run of rows, for textBuffer::replace_rows().
+ */
+struct RowRun
+{
+  int row;                         ///< The first row of the run.
+  int count;                       ///< How many rows it covers.
+  std::vector<std::string> rows;   ///< The rows that replace them.
+};
+
 /**
  * @class Buffer
  * @brief A class to manage a text buffer for a text editor.
@@ -23,6 +52,16 @@ private:
   std::deque<std::string> buffer;   ///< The internal storage for the lines of text.
   int size;   ///< The current number of rows in the buffer.
   int nonEmptyRowCount;
+  unsigned long id;        ///< Identifies the document, shared by copies of the same buffer.
+  unsigned long version;   ///< Generation counter, bumped by every modification.
+
+  std::vector<BufferEdit> journal;   ///< Edits that produced versions journal_base+1 .. version.
+  unsigned long journal_base;        ///< Version before the oldest edit still in the journal.
+
+  /**
+   * @brief Bumps the version and records the edit that produced it.
+   */
+  void record(BufferEdit::Kind kind, int row, int count = 1);
 
 public:
   /**
@@ -147,4 +186,52 @@ public:
    * @param row2 The index of the second row.
    */
   void swap_rows(int row1, int row2);
+
+  /**
+   * @brief Replaces the whole content of a row.
+   * @param row The index of the row to overwrite.
+   * @param str The new content of the row.
+   */
+  void set_row(int row, std::string str);
+
+  /**
+   * @brief Replaces a portion of a row with another string.
+   * @param row The index of the row to modify.
+   * @param pos The position of the first character to replace.
+   * @param len The number of characters to replace.
+   * @param str The replacement text.
+   */
+  void replace(int row, int pos, int len, const std::string& str);
+
+  /**
+   * @brief Replaces several runs of rows in one pass over the buffer, however
+   * many rows they add or remove.
+   * @param runs The runs, in row order and not overlapping; their rows are moved from.
+   */
+  void replace_rows(std::vector<RowRun>& runs);
+
+  /**
+   * @brief Gets the identifier of the document held by the buffer.
+   * Copies of a buffer share the identifier, a new buffer gets a fresh one.
+   * @return The document identifier.
+   */
+  unsigned long getId() const;
+
+  /**
+   * @brief Gets the generation counter of the buffer.
+   * The counter grows every time the buffer is modified, so two equal values
+   * for the same document mean the content did not change in between.
+   * @return The current version.
+   */
+  unsigned long getVersion() const;
+
+  /**
+   * @brief Collects the edits made after a given version, oldest first.
+   * Only the most recent edits are kept: when the version is too old the
+   * caller has to rebuild whatever it derived from the buffer.
+   * @param since The version the caller last saw.
+   * @param out Receives the edits.
+   * @return false if the edits since that version are no longer known.
+   */
+  bool edits_since(unsigned long since, std::vector<BufferEdit>& out) const;
 };
@@ -0,0 +1,118 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The token rules of a language, as read from its .mvimlang file.
+ * Character sets are lists of characters and ranges, such as "a-zA-Z_".
+ */
+struct TokenRules {
+    std::string stringDelimiters;  // each character opens and closes a string
+    char escape = '\\';            // inside strings, the next character is taken as is
+    std::string numberStart;       // characters a number literal starts with
+    std::string numberChars;       // characters a number literal goes on with
+    std::string identifierStart;   // characters an identifier starts with
+    std::string identifierChars;   // characters an identifier goes on with
+    std::string typeStart;         // identifiers starting with one of these are types
+    std::string lineComment;       // opens a comment that runs to the end of the row
+    std::string blockStart;        // open and close a comment that may span rows
+    std::string blockEnd;
+};
+
+/**
+ * @class TokenLexer
+ * @brief Splits a row into comments, strings, numbers and identifiers in one pass.
+ *
+ * The rules are compiled into a DFA: a small set of states (between tokens,
+ * in an identifier, in a number, in a string opened by a given delimiter, in
+ * a comment...) and a transition table indexed by state and byte class, where
+ * bytes that behave the same in every state share a class. Scanning is one
+ * lookup per byte. Comment delimiters longer than a byte are followed with
+ * states for the part of them read so far, so a quote inside a comment or a
+ * comment delimiter inside a string are taken for what they are; the bytes
+ * read before a delimiter is complete are reported again as a comment once it is.
+ */
+class TokenLexer {
+public:
+    enum class Token : uint8_t { TEXT, IDENTIFIER, TYPE, NUMBER, STRING, COMMENT };
+
+    /**
+     * @brief Compiles the rules; a language without rules gets an empty lexer.
+     */
+    void build(const TokenRules& rules);
+
+    bool empty() const { return next.empty(); }
+
+    /**
+     * @brief Parses a character set such as "a-zA-Z_" into the list of its characters.
+     */
+    static std::string expand_set(const std::string& set);
+
+    /**
+     * @brief Reports the tokens of a row, merged into runs of the same kind.
+     * @param on_span Called as on_span(from, to, token) for each run [from, to), TEXT runs included.
+     */
+    template<typename OnSpan>
+    void scan(const std::string& text, OnSpan&& on_span) const
+    {
+        scan(text, 0, text.size(), false, on_span);
+    }
+
+    /**
+     * @brief Same, reporting only the runs within [from, to). The bytes before
+     * `from` are only run through the table to know the state there.
+     * @param in_comment Whether the row starts inside a multi-line comment.
+     * @return Whether the next row starts inside one.
+     */
+    template<typename OnSpan>
+    bool scan(const std::string& text, size_t from, size_t to, bool in_comment, OnSpan&& on_span) const
+    {
+        to = std::min(to, text.size());
+        if (next.empty()) {
+            return false;
+        }
+        if (from >= to) {
+            return ends_in_comment(text, in_comment);
+        }
+        uint8_t state = in_comment ? block_state : 0;
+        for (size_t i = 0; i < from; ++i) {
+            state = next[state * classes + byte_class[(unsigned char)text[i]]];
+        }
+        size_t start = from;
+        Token current = token[state];
+        for (size_t i = from; i < to; ++i) {
+            state = next[state * classes + byte_class[(unsigned char)text[i]]];
+            if (token[state] != current) {
+                // A comment takes back the bytes of its delimiter read before it was complete
+                size_t split = std::max(start, i - std::min<size_t>(i, back[state]));
+                if (split > start) on_span(start, split, current);
+                start = split;
+                current = token[state];
+            }
+        }
+        on_span(start, to, current);
+        for (size_t i = to; i < text.size(); ++i) {
+            state = next[state * classes + byte_class[(unsigned char)text[i]]];
+        }
+        return block[state];
+    }
+
+    /**
+     * @brief Follows a row only to tell whether the next one starts inside a
+     * multi-line comment. Rows without a comment delimiter are not scanned.
+     */
+    bool ends_in_comment(const std::string& text, bool in_comment) const;
+
+private:
+    uint8_t byte_class[256] = {};
+    uint32_t classes = 0;
+    std::vector<uint8_t> next;   ///< next[state * classes + class]
+    std::vector<Token> token;    ///< The token each state's byte belongs to.
+    std::vector<uint8_t> back;   ///< Bytes before this one that belong to the comment it opens.
+    std::vector<bool> block;     ///< Whether the state is inside a multi-line comment.
+    uint8_t block_state = 0;     ///< Just inside a multi-line comment, where rows in one start.
+    std::string block_start;
+    std::string block_end;
+};
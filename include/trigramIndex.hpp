@@ -0,0 +1,130 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "documentStates.hpp"
+#include "textBuffer.hpp"
+
+/**
+ * @class TrigramIndex
+ * @brief Tells which rows of a large document can contain a text, so a search
+ * only checks those.
+ *
+ * The rows are grouped in blocks, and each sequence of three bytes (letters
+ * in lower case) keeps the sorted list of the blocks it appears in. The rows
+ * that can contain a text are those of the blocks in the lists of all its
+ * trigrams. Documents with at least `search_index_rows` rows are indexed on a
+ * worker thread, from copies of their rows, as BackgroundHighlighter styles
+ * them. Edits follow the buffer's journal: an edited block is searched in
+ * full until it is indexed again, and the old entries it leaves in the lists
+ * only make it a candidate for nothing. The index is built again from scratch
+ * once too many blocks changed. Blocks not indexed yet are always candidates,
+ * so the index narrows searches while it is still being built.
+ */
+class TrigramIndex {
+public:
+    using clock = std::chrono::steady_clock;
+
+    static TrigramIndex& instance() {
+        static TrigramIndex instance;
+        return instance;
+    }
+
+    ~TrigramIndex();
+
+    /**
+     * @brief Follows the edits of a document and hands the worker the next blocks to index.
+     * Called by the main loop while it is idle.
+     * @return True while blocks of the document are left to index.
+     */
+    bool schedule(const textBuffer& text);
+
+    /**
+     * @brief The rows that can contain every one of the texts, in order.
+     * @param literals Texts in lower case; those shorter than three bytes are not used.
+     * @return False if the index cannot narrow the search: the document is not
+     * indexed, no text is long enough, or too many rows remain.
+     */
+    bool candidates(const textBuffer& text, const std::vector<std::string>& literals, std::vector<int>& rows);
+
+    /**
+     * @brief Waits until the worker has nothing left to do (for tests and benchmarks).
+     */
+    void wait_idle();
+
+    /**
+     * @brief Memory held by the index of a document, in bytes (0 if it is not indexed).
+     */
+    size_t bytes(const textBuffer& text);
+
+private:
+    TrigramIndex() = default;
+    TrigramIndex(const TrigramIndex&) = delete;
+    TrigramIndex& operator=(const TrigramIndex&) = delete;
+
+    static constexpr uint32_t BLOCK_ROWS = 128;          // rows per block when the index is built
+    static constexpr uint32_t MAX_BLOCK_ROWS = 1024;     // a block grown past this by insertions starts the index over
+    static constexpr size_t JOB_BLOCKS = 64;             // blocks copied for the worker at a time
+    static constexpr size_t QUEUED_JOBS = 4;             // jobs waiting for the worker at most
+
+    struct Block {
+        uint32_t first = 0;         // its first row
+        uint32_t rows = 0;
+        uint32_t generation = 0;    // moves on with every edit of its rows
+        bool indexed = false;
+        bool queued = false;        // a job holds a copy of its rows
+    };
+
+    struct Document {
+        unsigned long version = 0;
+        unsigned long epoch = 0;    // moves on when the index starts over: older jobs are dropped
+        std::vector<Block> blocks;
+        std::unordered_map<uint32_t, std::vector<uint32_t>> postings;   // trigram -> blocks
+        std::unordered_set<uint32_t> unsorted;   // lists a block was added to out of order
+        size_t pending = 0;         // blocks not indexed
+        size_t stale = 0;           // blocks indexed again: their old entries are still in the lists
+        size_t entries = 0;         // in all the lists
+        size_t next = 0;            // the first block that may still need a job
+        clock::time_point started;
+        double build_ms = 0;
+
+        void reset(size_t rows);
+        size_t block_of(size_t row) const;
+        void dirty(size_t block);
+    };
+
+    struct Job {
+        unsigned long document;
+        unsigned long epoch;
+        std::vector<uint32_t> blocks;
+        std::vector<uint32_t> generations;
+        std::vector<size_t> ends;   // where the rows of each block end in `rows`
+        std::vector<std::string> rows;
+    };
+
+    // --- Shared with the worker, under lock ---
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    DocumentStates<Document> documents{2};
+    std::deque<Job> jobs;
+    bool busy = false;
+    bool stopping = false;
+    std::thread worker;
+
+    // --- Render thread ---
+    std::vector<BufferEdit> edits;
+
+    Document* sync(const textBuffer& text);
+    void post(const textBuffer& text, Document& document);
+    void run();
+
+    static size_t memory(const Document& document);
+};
@@ -43,10 +43,11 @@ public:
         }
 
         WINDOW* win = newwin(1, 1, 0, 0); // Temporary size
-        keypad(win, TRUE);
         if (win == nullptr) {
             return EXIT_FAILURE;
         }
+        keypad(win, TRUE);
+        idlok(win, TRUE); // allow terminal scroll regions when the text scrolls
 
         windows[key] = win;  // Add the window to the map
         resize_windows();    // Resize all windows
@@ -57,6 +58,22 @@ public:
         return destroy_window(name);  // Alias for destroy_window
     }   
 
+    /**
+     * @brief Gets the layout generation, bumped whenever the windows are
+     * moved, resized or covered by something drawn over them.
+     */
+    unsigned long get_layout_generation() const {
+        return layout_generation;
+    }
+
+    /**
+     * @brief Marks every window as needing a full redraw, e.g. after a popup
+     * has been drawn on top of them.
+     */
+    void invalidate_layout() {
+        layout_generation++;
+    }
+
 
     void refresh_separators() {
         int num_windows = windows.size();
@@ -104,6 +121,9 @@ public:
         // Reserve the last row for the status bar
         int effectiveHeight = maxHeight - 1;
 
+        // Every window has to be drawn again after this
+        invalidate_layout();
+
         // 1. CLEAR STD SCR FIRST
         // Remove old artifacts/lines before calculating new positions
         wclear(stdscr); 
@@ -185,6 +205,7 @@ WINDOW* getWindowAt(int y, int x) {
 private:
     // Private members
     std::map<std::string, WINDOW*> windows;
+    unsigned long layout_generation = 0;
 
     // Private constructor and destructor for Singleton
     WindowManager() {
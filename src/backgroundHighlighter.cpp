@@ -0,0 +1,327 @@
+#include "../include/backgroundHighlighter.hpp"
+#include "../include/editor.hpp"
+#include "../include/editorStats.hpp"
+#include "../include/syntax.hpp"
+#include "../include/syntaxState.hpp"
+#include <algorithm>
+
+BackgroundHighlighter::~BackgroundHighlighter()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void BackgroundHighlighter::Document::reset(size_t rows)
+{
+    entries.assign(rows, Entry());
+    missing = rows;
+    inflight.clear();
+}
+
+void BackgroundHighlighter::Document::invalidate(size_t row)
+{
+    if (row < entries.size() && entries[row].valid) {
+        entries[row] = Entry();
+        missing++;
+    }
+}
+
+void BackgroundHighlighter::drop_jobs()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    jobs.clear();
+}
+
+BackgroundHighlighter::Document& BackgroundHighlighter::sync(const textBuffer& text)
+{
+    const Language* lang = SyntaxHighlighter::instance().getCurrentLanguage();
+    size_t rows = text.get_buffer().size();
+
+    // Another buffer came to the front: its cache is still there, the
+    // queued jobs of the previous one are not worth finishing first
+    if (text.getId() != active) {
+        if (Document* previous = documents.find(active)) {
+            previous->inflight.clear();
+        }
+        drop_jobs();
+        active = text.getId();
+    }
+    Document& document = documents.get(active);
+
+    if (!document.built || document.language != lang || !text.edits_since(document.version, edits)) {
+        document.built = true;
+        document.version = text.getVersion();
+        document.language = lang;
+        document.reset(rows);
+        drop_jobs();
+        return document;
+    }
+
+    if (document.version == text.getVersion()) {
+        return document;
+    }
+    document.version = text.getVersion();
+
+    // Whatever the worker has in hand was copied from an older version
+    document.inflight.clear();
+    drop_jobs();
+
+    std::vector<Entry>& entries = document.entries;
+    for (const BufferEdit& edit : edits) {
+        size_t row = edit.row;
+        size_t count = edit.count;
+        switch (edit.kind) {
+            case BufferEdit::CHANGE:
+                document.invalidate(row);
+                break;
+            case BufferEdit::INSERT:
+                row = std::min(row, entries.size());
+                entries.insert(entries.begin() + row, count, Entry());
+                document.missing += count;
+                break;
+            case BufferEdit::ERASE: {
+                size_t last = std::min(row + count, entries.size());
+                for (size_t r = row; r < last; ++r) {
+                    if (!entries[r].valid) document.missing--;
+                }
+                if (row < last) entries.erase(entries.begin() + row, entries.begin() + last);
+                break;
+            }
+            case BufferEdit::RESET:
+                document.reset(rows);
+                return document;
+        }
+    }
+
+    if (entries.size() != rows) {
+        document.reset(rows);
+    }
+    return document;
+}
+
+void BackgroundHighlighter::encode(const std::vector<color>& colors, Entry& entry)
+{
+    entry.spans.clear();
+    size_t i = 0;
+    while (i < colors.size()) {
+        if (colors[i] == textColor) {
+            i++;
+            continue;
+        }
+        size_t j = i + 1;
+        while (j < colors.size() && j - i < UINT16_MAX && colors[j] == colors[i]) j++;
+        entry.spans.push_back({(uint32_t)i, (uint16_t)(j - i), colors[i]});
+        i = j;
+    }
+}
+
+bool BackgroundHighlighter::lookup(const textBuffer& text, size_t row, bool in_comment, std::vector<color>& colors, bool& end_state)
+{
+    Document& document = sync(text);
+    if (!document.language || row >= document.entries.size()) {
+        return false;
+    }
+
+    const Entry& entry = document.entries[row];
+    if (!entry.valid || entry.start != in_comment) {
+        return false;
+    }
+
+    colors.assign(text.get_buffer()[row].length(), textColor);
+    for (const Span& span : entry.spans) {
+        size_t to = std::min<size_t>(span.from + span.length, colors.size());
+        for (size_t i = span.from; i < to; ++i) colors[i] = span.c;
+    }
+    end_state = entry.end;
+    return true;
+}
+
+void BackgroundHighlighter::store(const textBuffer& text, size_t row, bool in_comment, const std::vector<color>& colors, bool end_state)
+{
+    Document& document = sync(text);
+    if (!document.language || row >= document.entries.size()) {
+        return;
+    }
+
+    Entry& entry = document.entries[row];
+    if (!entry.valid) document.missing--;
+    entry.valid = true;
+    entry.start = in_comment;
+    entry.end = end_state;
+    encode(colors, entry);
+}
+
+size_t BackgroundHighlighter::missing_rows()
+{
+    Document* document = documents.find(active);
+    return document ? document->missing : 0;
+}
+
+void BackgroundHighlighter::merge()
+{
+    std::vector<Result> done;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        done.swap(results);
+    }
+
+    for (Result& result : done) {
+        // Results go to their own document, even if it went to the background meanwhile
+        Document* document = documents.find(result.document);
+        if (!document || result.version != document->version || result.lang != document->language) {
+            continue;   // styled from rows that changed since
+        }
+        std::vector<Entry>& entries = document->entries;
+        for (size_t i = 0; i < result.entries.size(); ++i) {
+            size_t row = result.first + i;
+            if (row < entries.size() && !entries[row].valid) {
+                entries[row] = std::move(result.entries[i]);
+                document->missing--;
+                EditorStats::instance().rows_highlighted++;
+            }
+        }
+        auto& inflight = document->inflight;
+        inflight.erase(std::remove_if(inflight.begin(), inflight.end(), [&](const std::pair<size_t, size_t>& range) {
+            return range.first == result.first;
+        }), inflight.end());
+    }
+}
+
+bool BackgroundHighlighter::Document::next_gap(size_t from, bool forward, size_t& row) const
+{
+    auto in_flight = [&](size_t r) {
+        for (const auto& range : inflight) {
+            if (r >= range.first && r < range.first + range.second) return true;
+        }
+        return false;
+    };
+
+    if (forward) {
+        for (size_t r = from; r < entries.size(); ++r) {
+            if (!entries[r].valid && !in_flight(r)) {
+                row = r;
+                return true;
+            }
+        }
+    } else {
+        for (size_t r = std::min(from + 1, entries.size()); r-- > 0;) {
+            if (!entries[r].valid && !in_flight(r)) {
+                row = r;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void BackgroundHighlighter::post(const textBuffer& text, Document& document, size_t first, size_t count, std::vector<Job>& batch)
+{
+    const auto& rows = text.get_buffer();
+    Job job{active, document.version, document.language, first,
+            SyntaxStateCache::instance().state_before(text, first), max_highlight_length,
+            std::vector<std::string>(rows.begin() + first, rows.begin() + first + count)};
+    batch.push_back(std::move(job));
+    document.inflight.push_back({first, count});
+}
+
+void BackgroundHighlighter::schedule(const textBuffer& text, size_t top)
+{
+    Document& document = sync(text);
+    merge();
+    if (!document.language || document.missing == 0 || !document.inflight.empty()) {
+        return;
+    }
+
+    // Alternate between the rows below the window and the rows above it,
+    // starting with the window itself
+    std::vector<Job> batch;
+    size_t rows = document.entries.size();
+    size_t ahead = std::min(top, rows);
+    size_t behind = ahead;
+    bool more_ahead = true;
+    bool more_behind = behind > 0;
+
+    while (batch.size() < BATCH_CHUNKS && (more_ahead || more_behind)) {
+        size_t row;
+        if (more_ahead) {
+            if ((more_ahead = document.next_gap(ahead, true, row))) {
+                size_t count = std::min(CHUNK_ROWS, rows - row);
+                post(text, document, row, count, batch);
+                ahead = row + count;
+            }
+        }
+        if (more_behind && batch.size() < BATCH_CHUNKS) {
+            if ((more_behind = behind > 0 && document.next_gap(behind - 1, false, row))) {
+                size_t first = row + 1 > CHUNK_ROWS ? row + 1 - CHUNK_ROWS : 0;
+                post(text, document, first, row + 1 - first, batch);
+                behind = first;
+            }
+        }
+    }
+
+    if (batch.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (Job& job : batch) jobs.push_back(std::move(job));
+    if (!worker.joinable()) {
+        worker = std::thread(&BackgroundHighlighter::run, this);
+    }
+    wake.notify_one();
+}
+
+void BackgroundHighlighter::wait_idle()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [&]() { return jobs.empty() && !busy; });
+}
+
+void BackgroundHighlighter::run()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    std::vector<color> colors;
+
+    while (true) {
+        wake.wait(guard, [&]() { return stopping || !jobs.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        busy = true;
+        guard.unlock();
+
+        Result result{job.document, job.version, job.lang, job.first, std::vector<Entry>(job.rows.size())};
+        bool state = job.start;
+        for (size_t i = 0; i < job.rows.size(); ++i) {
+            Entry& entry = result.entries[i];
+            entry.start = state;
+            entry.valid = true;
+            if (job.rows[i].length() > job.limit) {
+                editor::visual::style_block_comments(*job.lang, job.rows[i], nullptr, state);
+                entry.end = state;
+                continue;
+            }
+            colors.assign(job.rows[i].length(), textColor);
+            editor::visual::style_row(*job.lang, job.rows[i], colors, state);
+            entry.end = state;
+            encode(colors, entry);
+        }
+
+        guard.lock();
+        results.push_back(std::move(result));
+        busy = false;
+        if (jobs.empty()) {
+            idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,1032 @@
+#include "../include/benchmark.hpp"
+#include "../include/editor.hpp"
+#include "../include/screen.hpp"
+#include "../include/softWrap.hpp"
+#include "../include/syntaxState.hpp"
+#include "../include/syntax.hpp"
+#include "../include/backgroundHighlighter.hpp"
+#include "../include/bracketIndex.hpp"
+#include "../include/editorStats.hpp"
+#include "../include/regexMatcher.hpp"
+#include "../include/incrementalSearch.hpp"
+#include "../include/searchPool.hpp"
+#include "../include/literalFinder.hpp"
+#include "../include/trigramIndex.hpp"
+#include "../include/projectSearch.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+
+double benchmark::measure(const std::string& label, int iterations, const std::function<void()>& fn)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i)
+  {
+    fn();
+  }
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+  double per_call = elapsed.count() / iterations;
+  std::cout << std::left << std::setw(32) << label
+            << std::right << std::setw(12) << std::fixed << std::setprecision(2) << per_call << " us" << std::endl;
+  return per_call;
+}
+
+void benchmark::render(CellGrid& grid)
+{
+  Screen& screen = Screen::getScreen();
+
+  // One row is left for the status bar, as in the editor
+  max_row = grid.rows() - 1;
+  max_col = grid.cols() - span - 1;
+  starting_row = 0;
+  starting_col = 0;
+
+  std::cout << "Render (" << grid.rows() << "x" << grid.cols() << " cells, "
+            << buffer.getSize() << " rows):" << std::endl;
+
+  measure("  frame, cache cold", 200, [&]() {
+    screen.invalidate_render_cache();
+    screen.update();
+  });
+
+  measure("  frame, nothing changed", 2000, [&]() {
+    screen.update();
+  });
+
+  size_t last_top = buffer.getSize() > max_row ? buffer.getSize() - max_row : 0;
+  measure("  frame, one-line scroll", 2000, [&]() {
+    starting_row = (starting_row < last_top) ? starting_row + 1 : 0;
+    screen.update();
+  });
+  starting_row = 0;
+
+  // Styling alone: what every visible row costs when nothing is cached
+  std::vector<color> colors;
+  measure("  highlight, visible rows", 200, [&]() {
+    bool in_comment = false;
+    for (size_t row = starting_row; row < buffer.getSize() && row < starting_row + max_row; ++row)
+    {
+      colors.assign(buffer[row].length(), textColor);
+      editor::visual::style_keywords(buffer[row], colors, in_comment);
+    }
+  });
+
+  // Comment state at the end of the file, after touching one row
+  SyntaxStateCache& states = SyntaxStateCache::instance();
+  size_t rows = buffer.getSize();
+  size_t row = 0;
+  states.state_before(buffer, rows);
+  measure("  edit one row, state at EOF", 2000, [&]() {
+    row = (row * 7 + 13) % rows;
+    buffer.set_row(row, buffer[row]);
+    states.state_before(buffer, rows);
+  });
+}
+
+void benchmark::soft_wrap(CellGrid& grid)
+{
+  SoftWrap& wrap = SoftWrap::instance();
+  size_t width = grid.cols() - span - 1;
+
+  // A million rows, one in four long enough to wrap several times
+  textBuffer loaded = buffer;
+  buffer.clear();
+  for (size_t i = 0; i < 1000000; ++i)
+  {
+    buffer.push_back(std::string((i % 4 == 0) ? 3 * width + 7 : 40, 'x'));
+  }
+
+  std::cout << "Soft wrap (" << buffer.getSize() << " rows, " << width << " columns):" << std::endl;
+
+  measure("  index build", 5, [&]() {
+    wrap.sync(textBuffer(), width);   // another document: forces a rebuild
+    wrap.sync(buffer, width);
+  });
+
+  size_t rows = buffer.getSize();
+  size_t row = 0;
+  measure("  edit one row + sync", 10000, [&]() {
+    row = (row * 7 + 13) % rows;
+    buffer.insert_letter(row, 0, 'x');
+    wrap.sync(buffer, width);
+  });
+
+  uint64_t lines = wrap.total_lines();
+  uint64_t line = 0;
+  volatile size_t sink = 0;
+  measure("  screen line -> row", 100000, [&]() {
+    line = (line * 31 + 17) % lines;
+    sink = sink + wrap.row_at(line);
+  });
+  measure("  row -> screen line", 100000, [&]() {
+    row = (row * 31 + 17) % rows;
+    sink = sink + wrap.line_of(row);
+  });
+
+  ::soft_wrap = true;
+  max_row = grid.rows() - 1;
+  max_col = width;
+  measure("  frame, wrapped scroll", 2000, [&]() {
+    pointed_row = (pointed_row + 1) % rows;
+    wrap.follow_cursor();
+    Screen::getScreen().update();
+  });
+  ::soft_wrap = false;
+  pointed_row = starting_row = 0;
+  buffer = loaded;
+}
+
+void benchmark::keywords()
+{
+  // 500 made-up keywords of 2 to 9 letters, plus the rows' own words so some of them match
+  Language lang;
+  lang.syntaxGroups.push_back({{}, &keyWordColor});
+  lang.syntaxGroups.push_back({{}, &preprocessorColor});
+  unsigned seed = 12345;
+  while (lang.syntaxGroups[0].keywords.size() < 490)
+  {
+    std::string word;
+    seed = seed * 1103515245 + 12345;
+    size_t length = 2 + (seed >> 16) % 8;
+    for (size_t i = 0; i < length; ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      word += (char)('a' + (seed >> 16) % 26);
+    }
+    lang.syntaxGroups[0].keywords.push_back(word);
+  }
+  for (const char* word : {"int", "return", "if", "else", "for", "while", "void", "char", "#include", "#define"})
+  {
+    lang.syntaxGroups[word[0] == '#' ? 1 : 0].keywords.push_back(word);
+  }
+  for (size_t group = 0; group < lang.syntaxGroups.size(); ++group)
+  {
+    for (const std::string& keyword : lang.syntaxGroups[group].keywords)
+    {
+      lang.keywordMatcher.add(keyword, group);
+    }
+  }
+  lang.keywordMatcher.build();
+
+  size_t rows = std::min<size_t>(buffer.getSize(), 2000);
+  std::cout << "Keywords (" << lang.keywordMatcher.keyword_count() << " keywords, "
+            << rows << " rows):" << std::endl;
+
+  std::vector<color> colors;
+  double search = measure("  search per keyword, all rows", 20, [&]() {
+    for (size_t row = 0; row < rows; ++row)
+    {
+      colors.assign(buffer[row].length(), textColor);
+      editor::visual::style_keyword_groups_by_search(lang, buffer[row], colors);
+    }
+  }) / std::max<size_t>(rows, 1);
+  double automaton = measure("  automaton, all rows", 20, [&]() {
+    for (size_t row = 0; row < rows; ++row)
+    {
+      colors.assign(buffer[row].length(), textColor);
+      editor::visual::style_keyword_groups(lang, buffer[row], colors);
+    }
+  }) / std::max<size_t>(rows, 1);
+
+  std::cout << "  (" << std::setprecision(3) << search << " vs " << automaton << " us per row)" << std::endl;
+}
+
+void benchmark::background_highlight(CellGrid& grid)
+{
+  if (buffer.getSize() == 0 || !SyntaxHighlighter::instance().getCurrentLanguage())
+  {
+    return;
+  }
+
+  // 500k rows made of the loaded file, over and over; each call is a new document
+  textBuffer loaded = buffer;
+  auto make_document = [&]() {
+    textBuffer document;
+    document.set_row(0, loaded[0]);
+    for (size_t row = 1; document.getSize() < 500000; ++row)
+    {
+      document.push_back(loaded[row % loaded.getSize()]);
+    }
+    return document;
+  };
+
+  Screen& screen = Screen::getScreen();
+  BackgroundHighlighter& highlighter = BackgroundHighlighter::instance();
+  max_row = grid.rows() - 1;
+  max_col = grid.cols() - span - 1;
+  size_t rows = 500000;
+  size_t last_top = rows - max_row;
+
+  std::cout << "Background highlighting (" << rows << " rows):" << std::endl;
+
+  // The same jumps both times: a page each, all over the document
+  auto jump = [&](size_t& top) {
+    top = (top + 7919 * max_row) % last_top;
+    starting_row = top;
+    screen.update();
+  };
+
+  buffer = make_document();
+  size_t top = 0;
+  measure("  page jump, rows styled in frame", 200, [&]() { jump(top); });
+
+  buffer = make_document();
+  auto start = std::chrono::steady_clock::now();
+  do
+  {
+    highlighter.schedule(buffer, 0);
+    highlighter.wait_idle();
+  }
+  while (highlighter.missing_rows() > 0);
+  std::chrono::duration<double, std::milli> fill = std::chrono::steady_clock::now() - start;
+  std::cout << std::left << std::setw(32) << "  whole document in background"
+            << std::right << std::setw(12) << std::fixed << std::setprecision(2) << fill.count() << " ms" << std::endl;
+
+  top = 0;
+  measure("  page jump, rows from the cache", 200, [&]() { jump(top); });
+
+  starting_row = 0;
+  buffer = loaded;
+}
+
+void benchmark::language_loading()
+{
+  namespace fs = std::filesystem;
+  SyntaxHighlighter& syntax = SyntaxHighlighter::instance();
+
+  // 200 languages of about 100 keywords each, in a scratch directory
+  fs::path dir = fs::temp_directory_path() / "mvim-benchmark-languages";
+  fs::create_directories(dir);
+  for (int i = 0; i < 200; ++i)
+  {
+    std::ofstream file(dir / ("lang" + std::to_string(i) + ".mvimlang"));
+    file << "name=Language " << i << "\n"
+         << "extensions=.l" << i << " .m" << i << "\n"
+         << "single_line_comment=//\nmulti_line_comment_start=/*\nmulti_line_comment_end=*/\n"
+         << "brackets=()[]{}\nstrings=\" '\nnumbers=0-9\nnumber_chars=0-9a-zA-Z_.\n"
+         << "identifier_start=a-zA-Z_\nidentifier_chars=a-zA-Z0-9_\ntypes=A-Z\n"
+         << "keywords=";
+    for (int k = 0; k < 100; ++k)
+    {
+      file << "kw" << i << "_" << k << " ";
+    }
+    file << "\n";
+  }
+
+  std::cout << "Languages (200 files):" << std::endl;
+  measure("  startup, index headers", 20, [&]() { syntax.indexLanguages(dir); });
+  measure("  parse + compile all", 1, [&]() {
+    for (int i = 0; i < 200; ++i)
+    {
+      syntax.setLanguageFromFile("file.l" + std::to_string(i));
+    }
+  });
+  measure("  open a file, language cached", 1000, [&]() { syntax.setLanguageFromFile("file.l7"); });
+
+  std::error_code error;
+  fs::remove_all(dir, error);
+  syntax.loadLanguages();
+  syntax.setLanguageFromFile(pointed_file);
+}
+
+void benchmark::brackets()
+{
+  if (!SyntaxHighlighter::instance().getCurrentLanguage())
+  {
+    return;
+  }
+
+  const size_t depth = 50000;
+  textBuffer loaded = buffer;
+  buffer = textBuffer();
+  buffer.set_row(0, "if (x[0]) {");
+  for (size_t row = 1; row < depth; ++row)
+  {
+    buffer.push_back("if (x[" + std::to_string(row) + "]) {  // " + std::string(row % 40, '-'));
+  }
+  for (size_t row = 0; row < depth; ++row)
+  {
+    buffer.push_back("}");
+  }
+
+  BracketIndex& index = BracketIndex::instance();
+  BracketPair pair;
+  std::cout << "Brackets (" << 2 * depth << " rows, " << depth << " deep):" << std::endl;
+  measure("  build the index", 1, [&]() { index.match(buffer, 0, 10, pair); });
+  measure("  match the outermost pair", 1000, [&]() { index.match(buffer, 0, 10, pair); });
+  measure("  match from the last row", 1000, [&]() { index.match(buffer, 2 * depth - 1, 0, pair); });
+
+  size_t row = 0;
+  measure("  edit a row + match", 1000, [&]() {
+    row = (row + 7919) % depth;
+    buffer.set_row(row, "if (y) {");
+    index.match(buffer, 0, 10, pair);
+  });
+  measure("  insert a row + match", 100, [&]() {
+    buffer.new_row("x = (1);", depth);
+    index.match(buffer, 0, 10, pair);
+  });
+
+  buffer = loaded;
+}
+
+void benchmark::long_lines(CellGrid& grid)
+{
+  if (!SyntaxHighlighter::instance().getCurrentLanguage())
+  {
+    return;
+  }
+
+  Screen& screen = Screen::getScreen();
+  EditorStats& stats = EditorStats::instance();
+  textBuffer loaded = buffer;
+  max_row = grid.rows() - 1;
+  max_col = grid.cols() - span - 1;
+  starting_row = 0;
+  starting_col = 0;
+
+  // Every frame styles the rows again: they are rewritten and nothing is cached
+  auto cold_frame = [&]() {
+    for (size_t row = 0; row < max_row && row < (size_t)buffer.getSize(); ++row)
+    {
+      buffer.set_row(row, buffer[row]);
+    }
+    screen.invalidate_render_cache();
+    screen.update();
+  };
+
+  std::cout << "Pathological rows:" << std::endl;
+
+  // A minified file: one 2 MB row
+  std::string minified;
+  while (minified.size() < 2000000)
+  {
+    minified += "function f(a,b){if(a[0]>1){return \"x\"+b;}var c=12.5;while(c<a.length){c++;}return c;}";
+  }
+  buffer = textBuffer();
+  buffer.set_row(0, minified);
+  buffer.push_back("int x = 0;");
+  measure("  2 MB row, frame", 20, cold_frame);
+  size_t limit = max_highlight_length;
+  max_highlight_length = SIZE_MAX;
+  measure("  2 MB row, frame, highlighted", 3, cold_frame);
+  max_highlight_length = limit;
+
+  // A screen of rows much wider than the window, scrolled to the middle
+  std::string wide;
+  while (wide.size() < 15000)
+  {
+    wide += "if (value[3] == \"text\") { count += 0x1F; return ok; } ";
+  }
+  buffer = textBuffer();
+  buffer.set_row(0, wide);
+  for (size_t row = 1; row < max_row; ++row)
+  {
+    buffer.push_back(wide);
+  }
+  starting_col = 7000;
+  measure("  wide rows, frame at column 7000", 50, cold_frame);
+  std::vector<color> colors;
+  measure("  wide rows, styled whole", 10, [&]() {
+    bool in_comment = false;
+    for (size_t row = 0; row < max_row; ++row)
+    {
+      colors.assign(buffer[row].length(), textColor);
+      editor::visual::style_keywords(buffer[row], colors, in_comment);
+    }
+  });
+  starting_col = 0;
+
+  // A screen of dense rows, every one styled in the frame, then with no
+  // budget at all: the first row is styled, the others wait for the next frames
+  size_t budget = highlight_budget_ms;
+  buffer = textBuffer();
+  buffer.set_row(0, wide.substr(0, 400));
+  for (size_t row = 1; row < 1000; ++row)
+  {
+    buffer.push_back(wide.substr(0, 400));
+  }
+  measure("  dense rows, frame", 100, cold_frame);
+  highlight_budget_ms = 0;
+  unsigned long deferred = stats.rows_deferred;
+  measure("  dense rows, frame, budget spent", 100, cold_frame);
+  std::cout << "  (" << (stats.rows_deferred - deferred) / 100 << " of " << max_row << " rows drawn plain)" << std::endl;
+  highlight_budget_ms = budget;
+
+  buffer = loaded;
+}
+
+void benchmark::regex_search()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // About 100 MB of code-like rows
+  textBuffer loaded = buffer;
+  const char* names[] = {"value", "count", "Buffer", "index", "result", "Node", "offset", "cursor"};
+  const char* calls[] = {"compute", "update_row", "find", "Render", "parse_token", "insert"};
+  unsigned seed = 2024;
+  auto next = [&]() { seed = seed * 1103515245 + 12345; return seed >> 16; };
+  std::vector<std::string> rows;
+  size_t bytes = 0;
+  while (bytes < 100 * 1000 * 1000)
+  {
+    std::string row = std::string(2 * (next() % 4), ' ');
+    switch (next() % 4)
+    {
+      case 0: row += "int " + std::string(names[next() % 8]) + "_" + std::to_string(next() % 1000) + " = " + std::to_string(next() % 100000) + ";"; break;
+      case 1: row += "if (" + std::string(names[next() % 8]) + " > " + std::to_string(next() % 50) + ") { " + calls[next() % 6] + "(x, y); }"; break;
+      case 2: row += "return " + std::string(calls[next() % 6]) + "(" + names[next() % 8] + ", \"text\");"; break;
+      case 3: row += "// " + std::string(names[next() % 8]) + " is " + calls[next() % 6] + "d once per frame, see " + names[next() % 8]; break;
+    }
+    bytes += row.size() + 1;
+    rows.push_back(std::move(row));
+  }
+  buffer = textBuffer();
+  buffer.set_row(0, rows[0]);
+  for (size_t row = 1; row < rows.size(); ++row)
+  {
+    buffer.push_back(rows[row]);
+  }
+
+  std::cout << "Regex search (" << rows.size() << " rows, " << bytes / 1000000 << " MB):" << std::endl;
+  std::cout << "  " << std::left << std::setw(30) << "pattern" << std::right << std::setw(14) << "std::regex"
+            << std::setw(14) << "matcher" << std::setw(12) << "matches" << std::endl;
+  for (const char* pattern : {"update_row", "return [a-z]+\\(", "[A-Z][a-z]+_[0-9]{3}\\b", "\\b(count|index)_\\d+ = \\d{5};", "\\(x, y\\);? }$"})
+  {
+    std::regex reference(pattern);
+    size_t expected = 0;
+    double reference_ms = elapsed_ms([&]() {
+      for (const std::string& row : rows)
+      {
+        expected += std::distance(std::sregex_iterator(row.begin(), row.end(), reference), std::sregex_iterator());
+      }
+    });
+    double matcher_ms = elapsed_ms([&]() { editor::find::find_all_occurrence(pattern); });
+    std::cout << "  " << std::left << std::setw(30) << pattern << std::right << std::fixed << std::setprecision(1)
+              << std::setw(11) << reference_ms << " ms" << std::setw(11) << matcher_ms << " ms"
+              << std::setw(12) << editor::found_occurrences.size()
+              << (expected == editor::found_occurrences.size() ? "" : " (std::regex: " + std::to_string(expected) + ")") << std::endl;
+  }
+  editor::found_occurrences.clear();
+  rows.clear();
+
+  // (a*)*b over a row of a's: backtracking tries every way to split the row
+  const char* pathological = "(a*)*b";
+  std::regex reference(pathological);
+  std::cout << "  " << pathological << " over n a's:" << std::endl;
+  for (size_t n = 6; n <= 20; n += 2)
+  {
+    std::string row(n, 'a');
+    double reference_ms = elapsed_ms([&]() { std::regex_search(row, reference); });
+    std::cout << "    std::regex, n = " << std::setw(7) << n << std::setw(14) << std::setprecision(2) << reference_ms << " ms" << std::endl;
+    if (reference_ms > 500)
+    {
+      break;
+    }
+  }
+  RegexMatcher matcher;
+  matcher.compile(pathological);
+  std::string row(10 * 1000 * 1000, 'a');
+  size_t start, end;
+  double matcher_ms = elapsed_ms([&]() { matcher.search(row, 0, start, end); });
+  std::cout << "    matcher, n = " << std::setw(10) << row.size() << std::setw(14) << matcher_ms << " ms" << std::endl;
+
+  buffer = loaded;
+}
+
+void benchmark::incremental_search()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // 1M rows, the term near the end so the first slices find nothing near the cursor
+  textBuffer loaded = buffer;
+  buffer = textBuffer();
+  buffer.set_row(0, "int value_0 = 0;");
+  for (size_t row = 1; row < 1000 * 1000; ++row)
+  {
+    buffer.push_back(row % 1000 == 0 ? "  cursor_" + std::to_string(row) + " = update_row(x, y);"
+                                     : "  int value_" + std::to_string(row) + " = compute(x, y);");
+  }
+
+  IncrementalSearch& search = IncrementalSearch::instance();
+  EditorStats& stats = EditorStats::instance();
+  const std::string term = "cursor_99";
+  const size_t origin = 500 * 1000;
+  std::cout << "Incremental search (" << buffer.get_buffer().size() << " rows, typing \"" << term << "\" from row " << origin << "):" << std::endl;
+  std::cout << "  " << std::left << std::setw(14) << "term" << std::right << std::setw(14) << "first slice"
+            << std::setw(14) << "to finish" << std::setw(14) << "rows checked" << std::setw(14) << "full search" << std::setw(10) << "matches" << std::endl;
+  search.clear();
+  for (size_t length = 1; length <= term.size(); ++length)
+  {
+    std::string typed = term.substr(0, length);
+    unsigned long before = stats.rows_searched;
+    double slice_ms = elapsed_ms([&]() {
+      search.start(buffer, typed, origin, 0);
+      search.run(buffer, IncrementalSearch::clock::now() + std::chrono::milliseconds(8));
+    });
+    double finish_ms = elapsed_ms([&]() { search.finish(buffer); });
+    unsigned long checked = stats.rows_searched - before;
+    size_t matches = editor::found_occurrences.size();
+
+    // What every keystroke would cost without the previous results
+    search.clear();
+    double full_ms = elapsed_ms([&]() { editor::find::find_all_occurrence(typed); });
+    std::cout << "  " << std::left << std::setw(14) << typed << std::right << std::fixed << std::setprecision(2)
+              << std::setw(11) << slice_ms << " ms" << std::setw(11) << finish_ms << " ms" << std::setw(14) << checked
+              << std::setw(11) << full_ms << " ms" << std::setw(10) << matches << std::endl;
+
+    // find_all_occurrence searched from the top: start the next term from these results
+    search.start(buffer, typed, origin, 0);
+    search.finish(buffer);
+  }
+  search.clear();
+  editor::found_occurrences.clear();
+
+  buffer = loaded;
+}
+
+void benchmark::parallel_search()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // About 200 MB of log rows
+  textBuffer loaded = buffer;
+  const char* levels[] = {"INFO", "DEBUG", "WARN", "ERROR"};
+  const char* events[] = {"request served", "cache miss for key", "connection reset by peer", "retrying upload of chunk"};
+  buffer = textBuffer();
+  buffer.set_row(0, "start");
+  size_t bytes = 0;
+  for (unsigned row = 1; bytes < 200 * 1000 * 1000; ++row)
+  {
+    std::string line = "2024-05-" + std::to_string(10 + row % 20) + " 12:" + std::to_string(10 + row % 50) + " [" + levels[(row * 7) % 4] + "] worker-" +
+                       std::to_string(row % 64) + " " + events[(row * 13) % 4] + " " + std::to_string(row * 2654435761u % 100000);
+    bytes += line.size() + 1;
+    buffer.push_back(line);
+  }
+
+  SearchPool& pool = SearchPool::instance();
+  size_t cores = pool.threads();
+  std::cout << "Parallel search (" << buffer.getSize() << " rows, " << bytes / 1000000 << " MB, " << cores << " cores):" << std::endl;
+  std::cout << "  " << std::left << std::setw(34) << "pattern" << std::right;
+  std::vector<size_t> counts = {1, 2, 4, 8};
+  if (std::find(counts.begin(), counts.end(), cores) == counts.end())
+  {
+    counts.push_back(cores);
+  }
+  for (size_t threads : counts)
+  {
+    std::cout << std::setw(10) << threads << " thr";
+  }
+  std::cout << std::setw(10) << "matches" << std::endl;
+
+  for (const char* pattern : {"connection reset", "\\[ERROR\\] worker-6\\d", "chunk \\d+7$"})
+  {
+    std::cout << "  " << std::left << std::setw(34) << pattern << std::right << std::fixed << std::setprecision(1);
+    for (size_t threads : counts)
+    {
+      pool.resize(threads);
+      IncrementalSearch::instance().clear();
+      double ms = elapsed_ms([&]() { editor::find::find_all_occurrence(pattern); });
+      std::cout << std::setw(11) << ms << " ms";
+    }
+    std::cout << std::setw(10) << editor::found_occurrences.size() << std::endl;
+  }
+  pool.resize(cores);
+  IncrementalSearch::instance().clear();
+
+  buffer = loaded;
+}
+
+void benchmark::literal_search()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // 256 MB of code-like text, in one piece and as rows
+  const char* names[] = {"value", "count", "Buffer", "index", "result", "Node", "offset", "cursor"};
+  std::string text;
+  text.reserve(256 << 20);
+  textBuffer loaded = buffer;
+  buffer = textBuffer();
+  buffer.set_row(0, "");
+  for (unsigned row = 0; text.size() < (256u << 20); ++row)
+  {
+    std::string line = "    " + std::string(names[row % 8]) + "_" + std::to_string(row % 997) + " = update_" + names[(row * 5) % 8] +
+                       "(" + std::to_string(row * 2654435761u % 100000) + ", " + names[(row * 3) % 8] + ");";
+    text += line;
+    text += '\n';
+    buffer.push_back(line);
+  }
+  auto rate = [&](double ms) { return text.size() / ms / 1e6; };
+
+  std::cout << "Literal search (" << (text.size() >> 20) << " MB, " << LiteralFinder::instruction_set() << "):" << std::endl;
+  double bandwidth_ms = elapsed_ms([&]() { if (std::memchr(text.data(), '\x01', text.size())) std::cout << "?"; });
+  std::cout << "  " << std::left << std::setw(44) << "memchr of an absent byte (bandwidth)" << std::right << std::fixed
+            << std::setprecision(2) << std::setw(8) << rate(bandwidth_ms) << " GB/s" << std::endl;
+
+  // "update_index_42" is not in the text: every byte is looked at
+  LiteralFinder finder;
+  for (const std::string needle : {"update_index_42", "cursor_996 ="})
+  {
+    size_t expected = 0, found = 0;
+    double reference_ms = elapsed_ms([&]() {
+      for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + needle.size())) ++expected;
+    });
+    finder.assign(needle);
+    double exact_ms = elapsed_ms([&]() {
+      for (size_t at = finder.find(text); at != std::string::npos; at = finder.find(text, at + needle.size())) ++found;
+    });
+    finder.assign(needle, true);
+    double folded_ms = elapsed_ms([&]() {
+      for (size_t at = finder.find(text); at != std::string::npos; at = finder.find(text, at + needle.size())) ++found;
+    });
+    std::cout << "  \"" << needle << "\" (" << expected << " matches" << (2 * expected == found ? "" : ", MISMATCH") << ")" << std::endl;
+    std::cout << "    " << std::left << std::setw(42) << "std::string::find" << std::right << std::setw(8) << rate(reference_ms) << " GB/s" << std::endl;
+    std::cout << "    " << std::left << std::setw(42) << "LiteralFinder" << std::right << std::setw(8) << rate(exact_ms) << " GB/s" << std::endl;
+    std::cout << "    " << std::left << std::setw(42) << "LiteralFinder, ignoring case" << std::right << std::setw(8) << rate(folded_ms) << " GB/s" << std::endl;
+  }
+
+  // The whole find path, one row at a time (rows are not contiguous, so less than the above)
+  for (const char* pattern : {"update_index_42", "[Uu][Pp][Dd][Aa][Tt][Ee]_[Ii][Nn][Dd][Ee][Xx]_42", "cursor_996 ="})
+  {
+    IncrementalSearch::instance().clear();
+    double ms = elapsed_ms([&]() { editor::find::find_all_occurrence(pattern); });
+    std::cout << "  find " << std::left << std::setw(54) << pattern << std::right << std::setw(8) << rate(ms) << " GB/s"
+              << std::setw(10) << editor::found_occurrences.size() << " matches" << std::endl;
+  }
+  IncrementalSearch::instance().clear();
+
+  buffer = loaded;
+}
+
+void benchmark::search_edits()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // 1M rows, 2M matches
+  textBuffer loaded = buffer;
+  buffer = textBuffer();
+  buffer.set_row(0, "int index = 0;");
+  for (int row = 1; row < 1000 * 1000; ++row)
+  {
+    buffer.push_back("  index_" + std::to_string(row) + " = index_" + std::to_string(row - 1) + " + 1;");
+  }
+  IncrementalSearch& search = IncrementalSearch::instance();
+  EditorStats& stats = EditorStats::instance();
+  search.clear();
+  double search_ms = elapsed_ms([&]() { editor::find::find_all_occurrence("index_\\d+"); });
+  std::cout << "Search results across edits (" << buffer.getSize() << " rows, " << editor::found_occurrences.size()
+            << " matches, searching it all: " << std::fixed << std::setprecision(2) << search_ms << " ms):" << std::endl;
+
+  auto report = [&](const char* label, const std::function<void()>& edit) {
+    edit();
+    unsigned long before = stats.rows_searched;
+    double ms = elapsed_ms([&]() { search.follow(buffer); });
+    std::cout << "  " << std::left << std::setw(36) << label << std::right << std::setw(10) << ms << " ms"
+              << std::setw(12) << stats.rows_searched - before << " rows searched" << std::endl;
+  };
+  report("a row changed", [&]() { buffer.set_row(500000, "  index_x = 0;"); });
+  report("10 rows changed", [&]() { for (int row = 0; row < 10; ++row) buffer.set_row(row * 1000, "index_0"); });
+  report("a row inserted in the middle", [&]() { buffer.new_row("index_new", 500000); });
+  report("a row deleted at the top", [&]() { buffer.del_row(0); });
+  report("1000 rows changed", [&]() { for (int row = 0; row < 1000; ++row) buffer.set_row(row * 997, "x"); });
+  search.clear();
+
+  buffer = loaded;
+}
+
+void benchmark::search_highlight()
+{
+  // 1M rows, about 10 matches of "e" in each
+  textBuffer loaded = buffer;
+  Mode previous_mode = mode;
+  buffer = textBuffer();
+  buffer.set_row(0, "#include <vector>");
+  for (int row = 1; row < 1000 * 1000; ++row)
+  {
+    buffer.push_back("    result_" + std::to_string(row) + " = get_next_element(tree, level);");
+  }
+  IncrementalSearch::instance().clear();
+  editor::find::find_all_occurrence("e");
+  const editor::SearchMatches& found = editor::found_occurrences;
+  std::cout << "Search highlighting (" << buffer.getSize() << " rows, " << found.size() << " matches of \"e\", "
+            << max_row << " rows in the window):" << std::endl;
+
+  // The window moves through the document, as when scrolling
+  mode = Mode::find;
+  size_t top = 0;
+  auto next_top = [&]() { top = (top + 7919) % (buffer.getSize() - max_row); return top; };
+  measure("  every match, per frame", 20, [&]() {
+    // What each frame did before: walk all the matches, keep the visible ones
+    size_t first = next_top();
+    std::vector<std::vector<editor::SearchMatch>> visible(max_row);
+    for (const auto& occ : found)
+    {
+      if (occ.row >= (int)first && occ.row < (int)(first + max_row)) visible[occ.row - first].push_back(occ);
+    }
+  });
+  measure("  rows in the window, per frame", 10000, [&]() { editor::find::visible_occurrences(next_top(), max_row); });
+
+  IncrementalSearch::instance().clear();
+  mode = previous_mode;
+  buffer = loaded;
+}
+
+void benchmark::search_from_cursor()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // 2M rows, a match in one row out of 1000; the cursor in the middle
+  textBuffer loaded = buffer;
+  buffer = textBuffer();
+  buffer.set_row(0, "int level = 0;");
+  for (int row = 1; row < 2000 * 1000; ++row)
+  {
+    buffer.push_back(row % 1000 ? "    level_" + std::to_string(row) + " = next(level_" + std::to_string(row - 1) + ");"
+                                : "    TODO(" + std::to_string(row) + "): check the level");
+  }
+  IncrementalSearch& search = IncrementalSearch::instance();
+  const size_t cursor = buffer.getSize() / 2 + 1;
+  std::cout << "Search from the cursor (" << buffer.getSize() << " rows, \"TODO\" in one row out of 1000):" << std::endl;
+  auto report = [](const char* label, double ms) {
+    std::cout << "  " << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << ms << " ms" << std::endl;
+  };
+
+  // Before: the whole buffer, then the cursor on the nearest match
+  search.clear();
+  report("every match, then the first", elapsed_ms([&]() { search.start(buffer, "TODO", cursor, 0); search.finish(buffer); }));
+
+  // Now: only as far as the nearest match, then one step with n while the rest is counted
+  search.clear();
+  report("the nearest match", elapsed_ms([&]() {
+    search.start(buffer, "TODO", cursor, 0);
+    editor::SearchMatch nearest;
+    search.run(buffer, IncrementalSearch::clock::time_point::max(), [&]() { return search.nearest(nearest); });
+  }));
+  editor::SearchMatch match;
+  report("the next one, still counting", elapsed_ms([&]() { search.scan_from(buffer, cursor, 0, true, match); }));
+  report("the rest, counted", elapsed_ms([&]() { search.finish(buffer); }));
+
+  search.clear();
+  buffer = loaded;
+}
+
+void benchmark::replace_all()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // 500K rows, two matches in each
+  textBuffer loaded = buffer;
+  std::stack<editor::Action> history = editor::action_history;
+  textBuffer text;
+  text.set_row(0, "  total = total + value_0;");
+  for (int row = 1; row < 500 * 1000; ++row)
+  {
+    text.push_back("  total = total + value_" + std::to_string(row) + ";");
+  }
+  buffer = text;
+  IncrementalSearch::instance().clear();
+  editor::find::find_all_occurrence("total");
+  std::vector<editor::SearchMatch> matches(editor::found_occurrences.begin(), editor::found_occurrences.end());
+  std::cout << "Replace all (" << buffer.getSize() << " rows, " << matches.size() << " matches of \"total\"):" << std::endl;
+  auto report = [](const char* label, double ms) {
+    std::cout << "  " << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << ms << " ms" << std::endl;
+  };
+
+  // Before: each match replaced in place, with two undo records
+  editor::action_history = std::stack<editor::Action>();
+  report("one match at a time", elapsed_ms([&]() {
+    for (auto occ = matches.rbegin(); occ != matches.rend(); ++occ)
+    {
+      editor::action_history.push({editor::ActionType::DELETE_SELECTION, occ->row, occ->col, 0, buffer[occ->row].substr(occ->col, occ->length), true});
+      editor::action_history.push({editor::ActionType::PASTE, occ->row, occ->col, 0, "sum", true});
+      buffer.replace(occ->row, occ->col, occ->length, "sum");
+    }
+  }));
+  std::string expected = buffer[1234];
+
+  // Now: each row changed once, a single undo record
+  buffer = text;
+  editor::action_history = std::stack<editor::Action>();
+  editor::find::find_all_occurrence("total");
+  report("each row once", elapsed_ms([&]() { editor::modify::replace_all("sum"); }));
+  if (buffer[1234] != expected) std::cout << "  the rows differ: " << buffer[1234] << std::endl;
+  report("undone", elapsed_ms([&]() { editor::modify::undo(); }));
+
+  IncrementalSearch::instance().clear();
+  editor::action_history = history;
+  buffer = loaded;
+}
+
+void benchmark::search_index()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // About 100 MB of log rows, with request ids and a rare event
+  textBuffer loaded = buffer;
+  const char* levels[] = {"INFO", "DEBUG", "WARN", "ERROR"};
+  const char* events[] = {"request served", "cache miss for key", "connection reset by peer", "retrying upload of chunk"};
+  buffer = textBuffer();
+  buffer.set_row(0, "start");
+  size_t bytes = 0;
+  char id[16];
+  for (unsigned row = 1; bytes < 100 * 1000 * 1000; ++row)
+  {
+    std::snprintf(id, sizeof(id), "%06x", row * 2654435761u >> 8);
+    std::string line = "2024-05-" + std::to_string(10 + row % 20) + " 12:" + std::to_string(10 + row % 50) + " [" + levels[(row * 7) % 4] + "] req-" + id + " " +
+                       (row % 5000 == 0 ? std::string("timeout after ") + std::to_string(row % 900) + " ms" : events[(row * 13) % 4]);
+    bytes += line.size() + 1;
+    buffer.push_back(line);
+  }
+  std::cout << "Search index (" << buffer.getSize() << " rows, " << bytes / 1000000 << " MB):" << std::endl;
+  // A rare id, a rare event, and texts found in too many blocks to narrow anything
+  const std::vector<const char*> patterns = {"req-4a7c15", "timeout after \\d+ ms", "WARN\\] req-00\\w+ connection"};
+
+  // Every row, without the index
+  std::vector<double> scanned;
+  for (const char* pattern : patterns)
+  {
+    IncrementalSearch::instance().clear();
+    scanned.push_back(elapsed_ms([&]() { editor::find::find_all_occurrence(pattern); }));
+  }
+
+  TrigramIndex& index = TrigramIndex::instance();
+  size_t threshold = search_index_rows;
+  search_index_rows = 1;
+  double build_ms = elapsed_ms([&]() { while (index.schedule(buffer)) index.wait_idle(); });
+  std::cout << "  built in " << std::fixed << std::setprecision(0) << build_ms << " ms, " << index.bytes(buffer) / 1000000 << " MB" << std::endl;
+  std::cout << "  " << std::left << std::setw(34) << "pattern" << std::right << std::setw(14) << "every row" << std::setw(14) << "indexed"
+            << std::setw(10) << "matches" << std::endl;
+  for (size_t i = 0; i < patterns.size(); ++i)
+  {
+    IncrementalSearch::instance().clear();
+    double ms = elapsed_ms([&]() { editor::find::find_all_occurrence(patterns[i]); });
+    std::cout << "  " << std::left << std::setw(34) << patterns[i] << std::right << std::setprecision(2) << std::setw(11) << scanned[i] << " ms"
+              << std::setw(11) << ms << " ms" << std::setw(10) << editor::found_occurrences.size() << std::endl;
+  }
+
+  IncrementalSearch::instance().clear();
+  search_index_rows = threshold;
+  buffer = loaded;
+}
+
+void benchmark::multiline_search()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+  auto report = [](const std::string& label, double ms) {
+    std::cout << "  " << std::left << std::setw(36) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(10) << ms << " ms" << std::endl;
+  };
+
+  // 1M rows of code, with calls broken over two rows
+  textBuffer loaded = buffer;
+  std::stack<editor::Action> history = editor::action_history;
+  buffer = textBuffer();
+  buffer.set_row(0, "int main(void)");
+  size_t bytes = 0;
+  for (int row = 1; row < 1000 * 1000; ++row)
+  {
+    std::string line = row % 10 == 0 ? "  call_" + std::to_string(row % 97) + "(" : "  value_" + std::to_string(row) + " = value_" + std::to_string(row - 1) + " + 1;";
+    bytes += line.size() + 1;
+    buffer.push_back(line);
+  }
+  const std::string term = "\\(\\n\\s*value_\\d+";
+  std::cout << "Multi-line search (" << buffer.getSize() << " rows, " << bytes / 1000000 << " MB, " << term << "):" << std::endl;
+
+  // Before: the rows joined into one string, searched at once
+  RegexMatcher matcher;
+  matcher.compile(term);
+  size_t joined_matches = 0;
+  report("joined, then searched", elapsed_ms([&]() {
+    std::string joined;
+    for (const std::string& row : buffer.get_buffer()) joined += row + '\n';
+    size_t start, end;
+    for (size_t from = 0; matcher.search(joined, from, start, end); from = end > start ? end : end + 1) ++joined_matches;
+  }));
+
+  // Now: the rows read in place, one after the other
+  IncrementalSearch::instance().clear();
+  report("rows read in place", elapsed_ms([&]() { editor::find::find_all_occurrence(term); }));
+  std::cout << "  " << editor::found_occurrences.size() << " matches (" << joined_matches << " joined), no copy of the "
+            << bytes / 1000000 << " MB" << std::endl;
+
+  editor::action_history = std::stack<editor::Action>();
+  size_t rows = buffer.getSize();
+  report("replaced, rows joined", elapsed_ms([&]() { editor::modify::replace_all("(value"); }));
+  std::cout << "  " << rows - buffer.getSize() << " rows fewer" << std::endl;
+  report("undone", elapsed_ms([&]() { editor::modify::undo(); }));
+
+  IncrementalSearch::instance().clear();
+  editor::action_history = history;
+  buffer = loaded;
+}
+
+void benchmark::project_search()
+{
+  auto elapsed_ms = [](const std::function<void()>& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  };
+
+  // 50k source files in 500 directories, a few large ones, an ignored dependency tree and some binaries
+  namespace fs = std::filesystem;
+  fs::path root = fs::temp_directory_path() / ("mvim_project_bench_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  const char* statements[] = {"  int value = compute(input, 42);", "  if (result != nullptr) return result->next;",
+                              "  for (size_t i = 0; i < items.size(); ++i) total += items[i];", "  // keep the cache warm for the next request",
+                              "  std::string name = prefix + std::to_string(count);"};
+  size_t bytes = 0;
+  for (int f = 0; f < 50000; ++f)
+  {
+    fs::path dir = root / (f < 5000 ? "node_modules/pkg_" + std::to_string(f % 50) : "src/module_" + std::to_string(f % 450));
+    fs::create_directories(dir);
+    std::ofstream file(dir / ("file_" + std::to_string(f) + (f % 500 == 7 ? ".bin" : f % 500 == 9 ? ".dat" : ".cpp")), std::ios::binary);
+    std::string text = "#include \"module.hpp\"\n\nvoid function_" + std::to_string(f) + "()\n{\n";
+    int rows = f % 1000 == 3 ? 20000 : 20 + f % 60;
+    for (int row = 0; row < rows; ++row) text += std::string(statements[(f + row) % 5]) + "\n";
+    if (f % 5000 == 11) text += "  handle_rare_event_" + std::to_string(f) + "();\n";
+    text += "}\n";
+    if (f % 500 == 7 || f % 500 == 9) text[10] = '\0';
+    file << text;
+    bytes += text.size();
+  }
+  std::ofstream(root / ".gitignore") << "node_modules/\n*.bin\n";
+  std::cout << "Project search (50000 files, " << bytes / 1000000 << " MB):" << std::endl;
+
+  ProjectSearch& search = ProjectSearch::instance();
+  size_t cores = std::max(1u, std::thread::hardware_concurrency());
+  const std::vector<const char*> patterns = {"handle_rare_event", "std::to_string", "function_[0-9]+7\\(", "[Cc]ache \\w+"};
+  std::cout << "  " << std::left << std::setw(24) << "pattern" << std::right << std::setw(13) << "1 thread" << std::setw(13)
+            << "all cores" << std::setw(13) << "grep -r" << std::setw(10) << "lines" << std::endl;
+  for (const char* pattern : patterns)
+  {
+    std::vector<ProjectSearch::Result> results;
+    double ms[2];
+    for (int run = 0; run < 2; ++run)
+    {
+      results.clear();
+      search.resize(run == 0 ? 1 : cores);
+      ms[run] = elapsed_ms([&]() {
+        search.start(pattern, root.string());
+        while (!search.take(results)) search.wait();
+      });
+    }
+
+    // The same files for grep, told to leave out what .gitignore leaves out and binary files.
+    // Its lines go to a file: written to /dev/null, grep stops at the first match of each file
+    std::string command = "cd '" + root.string() + "' && grep -rnIE --exclude-dir=node_modules --exclude='*.bin' '" + pattern + "' . > '" +
+                          root.string() + ".out'";
+    double grep_ms = elapsed_ms([&]() { (void)std::system(command.c_str()); });
+    std::cout << "  " << std::left << std::setw(24) << pattern << std::right << std::fixed << std::setprecision(1) << std::setw(10) << ms[0]
+              << " ms" << std::setw(10) << ms[1] << " ms" << std::setw(10) << grep_ms << " ms" << std::setw(10) << results.size() << std::endl;
+  }
+  std::cout << "  " << search.files() << " files searched, " << search.binary_files() << " binary skipped" << std::endl;
+
+  search.resize(cores);
+  fs::remove_all(root);
+  fs::remove(root.string() + ".out");
+}
@@ -0,0 +1,415 @@
+#include "../include/bracketIndex.hpp"
+#include "../include/editor.hpp"
+#include "../include/syntax.hpp"
+#include <algorithm>
+
+// Summary field of a range without brackets
+static constexpr int NONE = INT_MAX;
+
+BracketIndex::Summary BracketIndex::combine(const Summary& left, const Summary& right)
+{
+    Summary sum;
+    sum.delta = left.delta + right.delta;
+    sum.low_after = right.low_after == NONE ? left.low_after : std::min(left.low_after, left.delta + right.low_after);
+    sum.low_before = right.low_before == NONE ? left.low_before : std::min(left.low_before, left.delta + right.low_before);
+    return sum;
+}
+
+BracketIndex::Summary BracketIndex::summarize(const std::vector<Bracket>& brackets)
+{
+    Summary sum{0, NONE, NONE};
+    for (const Bracket& bracket : brackets) {
+        sum.low_before = std::min(sum.low_before, sum.delta);
+        sum.delta += bracket.open ? 1 : -1;
+        sum.low_after = std::min(sum.low_after, sum.delta);
+    }
+    return sum;
+}
+
+void BracketIndex::scan(const Language& lang, const std::string& text, Row& row)
+{
+    row.brackets.clear();
+    bool state = row.start;
+
+    if (text.find_first_of(lang.brackets) == std::string::npos) {
+        editor::visual::style_block_comments(lang, text, nullptr, state);
+        row.end = state;
+        row.summary = summarize(row.brackets);
+        return;
+    }
+
+    // Mark what highlighting paints as a comment or a string, so brackets
+    // match what the user sees: with a lexer, one pass tells both
+    static std::vector<color> mask;
+    const color skip = commentsColor;
+    mask.assign(text.size(), (color)(skip + 1));
+
+    if (!lang.lexer.empty()) {
+        state = lang.lexer.scan(text, 0, text.size(), state, [&](size_t from, size_t to, TokenLexer::Token token) {
+            if (token == TokenLexer::Token::STRING || token == TokenLexer::Token::COMMENT) {
+                std::fill(mask.begin() + from, mask.begin() + to, skip);
+            }
+        });
+    } else {
+        if (!lang.singleLineComment.empty()) {
+            size_t comment = text.find(lang.singleLineComment);
+            if (comment != std::string::npos) {
+                std::fill(mask.begin() + comment, mask.end(), skip);
+            }
+        }
+        editor::visual::style_block_comments(lang, text, &mask, state);
+    }
+    row.end = state;
+
+    for (size_t i = text.find_first_of(lang.brackets); i != std::string::npos; i = text.find_first_of(lang.brackets, i + 1)) {
+        if (mask[i] == skip) continue;
+        size_t k = lang.brackets.find(text[i]);
+        row.brackets.push_back({(uint32_t)i, (uint8_t)(k / 2), k % 2 == 0});
+    }
+    row.summary = summarize(row.brackets);
+}
+
+void BracketIndex::Document::build_tree(size_t from)
+{
+    size_t needed = 1;
+    while (needed < rows.size()) needed <<= 1;
+    if (needed != leaves) {
+        leaves = needed;
+        tree.assign(2 * leaves, Summary{0, NONE, NONE});
+        tree_rows = 0;   // the new tree has no leaf of the rows that are gone
+        from = 0;
+    }
+
+    // Rows from `from` on moved: refill their leaves and the nodes above them
+    size_t end = std::max(rows.size(), tree_rows);
+    if (from >= end) {
+        tree_rows = rows.size();
+        return;
+    }
+    for (size_t r = from; r < end; ++r) {
+        tree[leaves + r] = r < rows.size() ? rows[r].summary : Summary{0, NONE, NONE};
+    }
+    tree_rows = rows.size();
+    for (size_t lo = (leaves + from) / 2, hi = (leaves + end - 1) / 2; lo > 0; lo /= 2, hi /= 2) {
+        for (size_t node = lo; node <= hi; ++node) {
+            tree[node] = combine(tree[2 * node], tree[2 * node + 1]);
+        }
+    }
+}
+
+void BracketIndex::Document::update_leaf(size_t row)
+{
+    size_t node = leaves + row;
+    tree[node] = rows[row].summary;
+    for (node /= 2; node > 0; node /= 2) {
+        tree[node] = combine(tree[2 * node], tree[2 * node + 1]);
+    }
+}
+
+void BracketIndex::Document::reset(const textBuffer& text)
+{
+    const auto& lines = text.get_buffer();
+    rows.assign(lines.size(), Row());
+    stale.clear();
+    reshaped = SIZE_MAX;
+    leaves = 0;
+    tree_rows = 0;
+
+    bool state = false;
+    for (size_t r = 0; r < rows.size(); ++r) {
+        rows[r].start = state;
+        scan(*language, lines[r], rows[r]);
+        state = rows[r].end;
+    }
+    build_tree();
+}
+
+void BracketIndex::Document::sync(const textBuffer& text, std::vector<BufferEdit>& edits)
+{
+    const Language* lang = SyntaxHighlighter::instance().getCurrentLanguage();
+
+    if (!built || language != lang || !text.edits_since(version, edits)) {
+        built = true;
+        version = text.getVersion();
+        language = lang;
+        reset(text);
+        return;
+    }
+
+    if (version == text.getVersion()) {
+        return;
+    }
+    version = text.getVersion();
+
+    for (const BufferEdit& edit : edits) {
+        size_t row = edit.row;
+        size_t count = edit.count;
+        switch (edit.kind) {
+            case BufferEdit::CHANGE:
+                stale.insert(row);
+                break;
+            case BufferEdit::INSERT: {
+                std::set<size_t> shifted;
+                for (size_t r : stale) shifted.insert(r >= row ? r + count : r);
+                stale.swap(shifted);
+                row = std::min(row, rows.size());
+                rows.insert(rows.begin() + row, count, Row());
+                for (size_t r = row; r < row + count; ++r) stale.insert(r);
+                reshaped = std::min(reshaped, row);
+                break;
+            }
+            case BufferEdit::ERASE: {
+                std::set<size_t> shifted;
+                for (size_t r : stale) {
+                    if (r < row) shifted.insert(r);
+                    else if (r >= row + count) shifted.insert(r - count);
+                }
+                stale.swap(shifted);
+                size_t last = std::min(row + count, rows.size());
+                if (row < last) rows.erase(rows.begin() + row, rows.begin() + last);
+                stale.insert(row);
+                reshaped = std::min(reshaped, row);
+                break;
+            }
+            case BufferEdit::RESET:
+                reset(text);
+                return;
+        }
+    }
+
+    if (rows.size() != text.get_buffer().size()) {
+        reset(text);
+        return;
+    }
+    rescan(text);
+}
+
+void BracketIndex::Document::rescan(const textBuffer& text)
+{
+    // Rows below an edited one are scanned again only while the comment
+    // state handed down to them changes
+    const auto& lines = text.get_buffer();
+    while (!stale.empty()) {
+        size_t r = *stale.begin();
+        stale.erase(stale.begin());
+        if (r >= rows.size()) continue;
+
+        rows[r].start = r > 0 && rows[r - 1].end;
+        scan(*language, lines[r], rows[r]);
+        if (r < reshaped) update_leaf(r);
+
+        if (r + 1 < rows.size() && rows[r + 1].start != rows[r].end) {
+            stale.insert(r + 1);
+        }
+    }
+
+    if (reshaped != SIZE_MAX) {
+        build_tree(reshaped);
+        reshaped = SIZE_MAX;
+    }
+}
+
+int BracketIndex::Document::depth_before(size_t row) const
+{
+    int depth = 0;
+    for (size_t l = leaves, r = leaves + row; l < r; l /= 2, r /= 2) {
+        if (l & 1) depth += tree[l++].delta;
+        if (r & 1) depth += tree[--r].delta;
+    }
+    return depth;
+}
+
+bool BracketIndex::Document::find_after(size_t node, size_t lo, size_t hi, size_t from, int& depth, int target, size_t& row) const
+{
+    if (hi <= from) {
+        return false;
+    }
+    const Summary& sum = tree[node];
+    if (lo >= from) {
+        if (sum.low_after == NONE || depth + sum.low_after > target) {
+            depth += sum.delta;
+            return false;
+        }
+        if (node >= leaves) {
+            row = lo;
+            return true;
+        }
+    }
+    size_t mid = (lo + hi) / 2;
+    return find_after(2 * node, lo, mid, from, depth, target, row) ||
+           find_after(2 * node + 1, mid, hi, from, depth, target, row);
+}
+
+bool BracketIndex::Document::find_before(size_t node, size_t lo, size_t hi, size_t to, int& depth, int target, size_t& row) const
+{
+    if (lo >= to) {
+        return false;
+    }
+    const Summary& sum = tree[node];
+    if (hi <= to) {
+        int start = depth - sum.delta;
+        if (sum.low_before == NONE || start + sum.low_before > target) {
+            depth = start;
+            return false;
+        }
+        if (node >= leaves) {
+            row = lo;
+            return true;
+        }
+    }
+    size_t mid = (lo + hi) / 2;
+    return find_before(2 * node + 1, mid, hi, to, depth, target, row) ||
+           find_before(2 * node, lo, mid, to, depth, target, row);
+}
+
+bool BracketIndex::close_of(const Document& document, size_t row, size_t index, BracketPair& pair) const
+{
+    const std::vector<Bracket>& brackets = document.rows[row].brackets;
+    int depth = document.depth_before(row);
+    for (size_t k = 0; k < index; ++k) depth += brackets[k].open ? 1 : -1;
+    const int target = depth;   // the depth the partner brings back
+
+    // On the same row
+    depth++;
+    size_t found_row = row;
+    size_t found = brackets.size();
+    for (size_t k = index + 1; k < brackets.size(); ++k) {
+        depth += brackets[k].open ? 1 : -1;
+        if (depth <= target) {
+            found = k;
+            break;
+        }
+    }
+
+    // Else the first row below that goes down to it
+    if (found == brackets.size()) {
+        if (!document.find_after(1, 0, document.leaves, row + 1, depth, target, found_row)) {
+            return false;
+        }
+        const std::vector<Bracket>& below = document.rows[found_row].brackets;
+        for (size_t k = 0; k < below.size(); ++k) {
+            depth += below[k].open ? 1 : -1;
+            if (depth <= target) {
+                found = k;
+                break;
+            }
+        }
+    }
+
+    const Bracket& open = brackets[index];
+    const Bracket& close = document.rows[found_row].brackets[found];
+    if (close.kind != open.kind) {
+        return false;
+    }
+    pair = {row, open.col, found_row, close.col};
+    return true;
+}
+
+bool BracketIndex::open_before(const Document& document, size_t row, size_t index, size_t& open_row, size_t& open_index) const
+{
+    const std::vector<Bracket>& brackets = document.rows[row].brackets;
+    int depth = document.depth_before(row);
+    for (size_t k = 0; k < index; ++k) depth += brackets[k].open ? 1 : -1;
+    const int target = depth - 1;   // the depth before the enclosing bracket
+
+    // On the same row
+    for (size_t k = index; k-- > 0;) {
+        depth -= brackets[k].open ? 1 : -1;
+        if (depth <= target) {
+            open_row = row;
+            open_index = k;
+            return true;
+        }
+    }
+
+    // Else the last row above that goes down to it
+    depth = document.depth_before(row);
+    if (!document.find_before(1, 0, document.leaves, row, depth, target, open_row)) {
+        return false;
+    }
+    const std::vector<Bracket>& above = document.rows[open_row].brackets;
+    depth = document.depth_before(open_row + 1);
+    for (size_t k = above.size(); k-- > 0;) {
+        depth -= above[k].open ? 1 : -1;
+        if (depth <= target) {
+            open_index = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+BracketIndex::Document* BracketIndex::sync(const textBuffer& text)
+{
+    const Language* lang = SyntaxHighlighter::instance().getCurrentLanguage();
+    if (!lang || lang->brackets.size() < 2) {
+        return nullptr;
+    }
+    Document& document = documents.get(text.getId());
+    document.sync(text, edits);
+    return &document;
+}
+
+size_t BracketIndex::bracket_at(const std::vector<Bracket>& brackets, size_t col)
+{
+    return std::lower_bound(brackets.begin(), brackets.end(), col, [](const Bracket& bracket, size_t c) {
+        return bracket.col < c;
+    }) - brackets.begin();
+}
+
+bool BracketIndex::match(const textBuffer& text, size_t row, size_t col, BracketPair& pair)
+{
+    Document* document = sync(text);
+    if (!document || row >= document->rows.size()) {
+        return false;
+    }
+
+    const std::vector<Bracket>& brackets = document->rows[row].brackets;
+    size_t index = bracket_at(brackets, col);
+    if (index == brackets.size() || brackets[index].col != col) {
+        return false;
+    }
+    if (brackets[index].open) {
+        return close_of(*document, row, index, pair);
+    }
+
+    size_t open_row, open_index;
+    if (!open_before(*document, row, index, open_row, open_index)) {
+        return false;
+    }
+    const Bracket& open = document->rows[open_row].brackets[open_index];
+    if (open.kind != brackets[index].kind) {
+        return false;
+    }
+    pair = {open_row, open.col, row, col};
+    return true;
+}
+
+bool BracketIndex::enclosing(const textBuffer& text, size_t row, size_t col, BracketPair& pair)
+{
+    Document* document = sync(text);
+    if (!document || row >= document->rows.size()) {
+        return false;
+    }
+
+    size_t index = bracket_at(document->rows[row].brackets, col);
+    size_t open_row, open_index;
+    return open_before(*document, row, index, open_row, open_index) &&
+           close_of(*document, open_row, open_index, pair);
+}
+
+bool BracketIndex::next_on_row(const textBuffer& text, size_t row, size_t col, size_t& found)
+{
+    Document* document = sync(text);
+    if (!document || row >= document->rows.size()) {
+        return false;
+    }
+
+    const std::vector<Bracket>& brackets = document->rows[row].brackets;
+    size_t index = bracket_at(brackets, col);
+    if (index == brackets.size()) {
+        return false;
+    }
+    found = brackets[index].col;
+    return true;
+}
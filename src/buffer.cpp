@@ -1,8 +1,27 @@
 #include "../include/textBuffer.hpp"
+#include <algorithm>
 
 
-textBuffer::textBuffer() : buffer(1, ""), size(1), nonEmptyRowCount(0) 
+static unsigned long next_document_id = 0;
+
+// Edits kept in the journal; older ones are dropped in halves
+static const size_t journal_capacity = 4096;
+
+textBuffer::textBuffer()
+  : buffer(1, ""), size(1), nonEmptyRowCount(0), id(++next_document_id), version(0), journal_base(0)
+{
+}
+
+void textBuffer::record(BufferEdit::Kind kind, int row, int count)
 {
+  version++;
+  if (journal.size() >= journal_capacity)
+  {
+    size_t dropped = journal.size() / 2;
+    journal.erase(journal.begin(), journal.begin() + dropped);
+    journal_base += dropped;
+  }
+  journal.push_back({kind, row, count});
 }
 
 std::string& textBuffer::operator [] (int row)
@@ -12,12 +31,14 @@ std::string& textBuffer::operator [] (int row)
 
 void textBuffer::new_row(std::string row, int pos)
 {
+  record(BufferEdit::INSERT, pos);
   this->buffer.insert(this->buffer.begin() + pos, std::move(row));
   size++;
 }
 
 void textBuffer::merge_rows(int row1, int row2)
 {
+  record(BufferEdit::CHANGE, row1);
   this->buffer[row1] += std::move(this->buffer[row2]);
   del_row(row2);
 }
@@ -26,21 +47,25 @@ void textBuffer::del_row(int pos)
 {
   if (size == 1)
   {
+    record(BufferEdit::CHANGE, 0);
     this->buffer[0] = std::move(std::string(""));
     return;
   }
+  record(BufferEdit::ERASE, pos);
   this->buffer.erase(this->buffer.begin() + pos);
   size--;
 }
 
 void textBuffer::insert_letter(int row, int pos, char letter)
 {
+  record(BufferEdit::CHANGE, row);
   this->buffer[row].insert(this->buffer[row].begin() + pos, letter);
 }
 
 
 void textBuffer::delete_letter(int row, int pos)
 {
+  record(BufferEdit::CHANGE, row);
   if (this->buffer[row].length() > 0)
   {
     this->buffer[row].erase(this->buffer[row].begin() + pos);
@@ -49,11 +74,13 @@ void textBuffer::delete_letter(int row, int pos)
 
 void textBuffer::row_append(int row, std::string str)
 {
+  record(BufferEdit::CHANGE, row);
   this->buffer[row] += std::move(str);
 }
 
 void textBuffer::push_back(std::string str)
 {
+  record(BufferEdit::INSERT, size);
   this->buffer.emplace_back(std::move(str));
   size++;
 }
@@ -67,6 +94,7 @@ void textBuffer::restore()
 
 void textBuffer::clear()
 {
+  record(BufferEdit::RESET, 0, 0);
   this->buffer.clear();
   size = 0;
 }
@@ -78,6 +106,7 @@ bool textBuffer::is_void_row(int row)
 
 std::string textBuffer::slice_row(int row, int pos, int pos2)
 {
+  record(BufferEdit::CHANGE, row);
   std::string to_del = this->buffer[row].substr(pos, pos2 - pos);
   this->buffer[row].erase(pos, pos2 - pos);
   return to_del;
@@ -114,6 +143,8 @@ bool textBuffer::is_void() const
 
 void textBuffer::swap_rows(int row1, int row2)
 {
+  record(BufferEdit::CHANGE, row1);
+  record(BufferEdit::CHANGE, row2);
   std::swap(this->buffer[row1], this->buffer[row2]);
 }
 
@@ -122,3 +153,131 @@ const std::deque<std::string>& textBuffer::get_buffer() const
   return this->buffer;
 }
 
+
+void textBuffer::set_row(int row, std::string str)
+{
+  record(BufferEdit::CHANGE, row);
+  this->buffer[row] = std::move(str);
+}
+
+void textBuffer::replace(int row, int pos, int len, const std::string& str)
+{
+  record(BufferEdit::CHANGE, row);
+  this->buffer[row].replace(pos, len, str);
+}
+
+void textBuffer::replace_rows(std::vector<RowRun>& runs)
+{
+  // Recorded from the last run up, so that the rows of each edit are those of the buffer before it
+  for (auto run = runs.rbegin(); run != runs.rend(); ++run)
+  {
+    int added = (int)run->rows.size();
+    for (int i = 0; i < std::min(run->count, added); ++i)
+    {
+      record(BufferEdit::CHANGE, run->row + i);
+    }
+    if (added > run->count)
+    {
+      record(BufferEdit::INSERT, run->row + run->count, added - run->count);
+    }
+    else if (added < run->count)
+    {
+      record(BufferEdit::ERASE, run->row + added, run->count - added);
+    }
+  }
+
+  long delta = 0;
+  bool shrinks = true, grows = true;
+  for (const RowRun& run : runs)
+  {
+    delta += (long)run.rows.size() - run.count;
+    shrinks = shrinks && delta <= 0;
+    grows = grows && delta >= 0;
+  }
+
+  if (shrinks)
+  {
+    // The rows move up: what is written never passes what is left to read.
+    // Rows still in place are left alone: a string moved onto itself is emptied
+    size_t read = 0, write = 0;
+    for (RowRun& run : runs)
+    {
+      if (read != write)
+      {
+        write = std::move(this->buffer.begin() + read, this->buffer.begin() + run.row, this->buffer.begin() + write) - this->buffer.begin();
+      }
+      else
+      {
+        write = run.row;
+      }
+      write = std::move(run.rows.begin(), run.rows.end(), this->buffer.begin() + write) - this->buffer.begin();
+      read = run.row + run.count;
+    }
+    if (read != write)
+    {
+      write = std::move(this->buffer.begin() + read, this->buffer.end(), this->buffer.begin() + write) - this->buffer.begin();
+      this->buffer.resize(write);
+    }
+  }
+  else if (grows)
+  {
+    // The same from the end, once the buffer has room
+    size_t read = this->buffer.size();
+    this->buffer.resize(this->buffer.size() + delta);
+    size_t write = this->buffer.size();
+    for (auto run = runs.rbegin(); run != runs.rend(); ++run)
+    {
+      size_t end = run->row + run->count;
+      write = std::move_backward(this->buffer.begin() + end, this->buffer.begin() + read, this->buffer.begin() + write) - this->buffer.begin();
+      write = std::move_backward(run->rows.begin(), run->rows.end(), this->buffer.begin() + write) - this->buffer.begin();
+      read = run->row;
+    }
+  }
+  else
+  {
+    std::deque<std::string> rebuilt;
+    size_t at = 0;
+    for (RowRun& run : runs)
+    {
+      for (; at < (size_t)run.row; ++at)
+      {
+        rebuilt.push_back(std::move(this->buffer[at]));
+      }
+      for (std::string& row : run.rows)
+      {
+        rebuilt.push_back(std::move(row));
+      }
+      at += run.count;
+    }
+    for (; at < this->buffer.size(); ++at)
+    {
+      rebuilt.push_back(std::move(this->buffer[at]));
+    }
+    this->buffer.swap(rebuilt);
+  }
+  if (this->buffer.empty())
+  {
+    this->buffer.push_back("");
+  }
+  size = (int)this->buffer.size();
+}
+
+unsigned long textBuffer::getId() const
+{
+  return id;
+}
+
+unsigned long textBuffer::getVersion() const
+{
+  return version;
+}
+
+bool textBuffer::edits_since(unsigned long since, std::vector<BufferEdit>& out) const
+{
+  if (since < journal_base || since > version)
+  {
+    return false;
+  }
+  out.assign(journal.begin() + (since - journal_base), journal.end());
+  return true;
+}
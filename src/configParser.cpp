@@ -68,6 +68,7 @@ std::map<std::string, std::function<void()>> ConfigParser::getActionMap() {
         {"goto_end_file", editor::movement::move_to_end_of_file},
         {"next_word", editor::movement::move_to_next_word},
         {"previous_word", editor::movement::move_to_previous_word},
+        {"match_bracket", editor::movement::jump_to_matching_bracket},
 
         // Modify
         {"insert_newline_below", editor::movement::go_down_creating_newline},
@@ -85,6 +86,10 @@ std::map<std::string, std::function<void()>> ConfigParser::getActionMap() {
         {"mode_visual", editor::system::change2visual},
         {"mode_normal", editor::system::change2normal},
         {"mode_find", editor::find::find},
+        {"project_search", editor::find::project_search},
+        {"open_result", editor::find::open_project_result},
+        {"show_stats", editor::system::show_stats},
+        {"toggle_wrap", editor::system::toggle_wrap},
         
         // Buffers
         {"buffer_next", editor::system::switch_to_next_buffer},
@@ -103,6 +108,28 @@ std::map<std::string, std::function<void()>> ConfigParser::getActionMap() {
     };
 }
 
+void ConfigParser::setOption(const std::string& name, const std::string& value, int lineNumber) {
+    static const std::map<std::string, size_t*> options = {
+        {"max_highlight_length", &max_highlight_length},
+        {"highlight_budget_ms", &highlight_budget_ms},
+        {"search_index_rows", &search_index_rows}
+    };
+
+    auto option = options.find(name);
+    if (option == options.end()) {
+        ErrorHandler::instance().report(ErrorLevel::WARNING, 
+            "Config Error Line " + std::to_string(lineNumber) + ": Unknown option '" + name + "'");
+        return;
+    }
+
+    try {
+        *option->second = std::stoul(value);
+    } catch (const std::exception&) {
+        ErrorHandler::instance().report(ErrorLevel::WARNING, 
+            "Config Error Line " + std::to_string(lineNumber) + ": Invalid value '" + value + "' for " + name);
+    }
+}
+
 void ConfigParser::loadKeyBindings(Command& command, const std::string& filename) {
     std::vector<std::string> searchPaths = {
         filename,                                   // Current working directory (e.g., .mvimrc)
@@ -145,7 +172,7 @@ void ConfigParser::loadKeyBindings(Command& command, const std::string& filename
             std::transform(currentSection.begin(), currentSection.end(), currentSection.begin(), ::toupper);
             
             if (currentSection != "NORMAL" && currentSection != "INSERT" && 
-                currentSection != "VISUAL" && currentSection != "FIND") {
+                currentSection != "VISUAL" && currentSection != "FIND" && currentSection != "OPTIONS") {
                 ErrorHandler::instance().report(ErrorLevel::WARNING, 
                     "Config Error Line " + std::to_string(lineNumber) + ": Unknown section [" + currentSection + "]");
                 currentSection = "INVALID";
@@ -161,6 +188,11 @@ void ConfigParser::loadKeyBindings(Command& command, const std::string& filename
         std::string keyStr = trim(line.substr(0, delimiterPos));
         std::string actionStr = trim(line.substr(delimiterPos + 1));
 
+        if (currentSection == "OPTIONS") {
+            setOption(keyStr, actionStr, lineNumber);
+            continue;
+        }
+
         int keyCode = parseKey(keyStr);
         if (keyCode == ERR) {
             ErrorHandler::instance().report(ErrorLevel::WARNING, 
@@ -1,6 +1,7 @@
 #include "../include/editor.hpp"
 #include <ncurses.h>
 #include "../include/syntax.hpp"
+#include "../include/bufferManager.hpp"
 #include <algorithm>
 
 namespace fs = std::filesystem;
@@ -220,5 +221,6 @@ void editor::file::file_selection_menu()
   curs_set(1);
   erase();
   refresh();
+  BufferManager::instance().getWindowManager().invalidate_layout();
   endwin();
 }
\ No newline at end of file
@@ -1,140 +1,406 @@
 #include "../include/editor.hpp"
 #include "../include/errorHandler.hpp" 
-#include <regex>
+#include "../include/incrementalSearch.hpp"
+#include "../include/projectSearch.hpp"
+#include "../include/bufferManager.hpp"
+#include "../include/screen.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <functional>
 
 void editor::find::find_all_occurrence(const std::string& pattern_str)
 {
-    found_occurrences.clear();      // Clear any previous search results
+    // A search from the top, on every core; the results land in found_occurrences in row order
+    IncrementalSearch& search = IncrementalSearch::instance();
+    search.start(buffer, pattern_str, 0, 0);
+    search.finish(buffer);
+}
+
+void editor::find::follow_edits()
+{
+    if (IncrementalSearch::instance().follow(buffer))
+    {
+        // The current match is the last one at or before the cursor
+        auto at = std::make_pair((int)pointed_row, (int)pointed_col);
+        size_t after = found_occurrences.partition_point([&](const SearchMatch& occ) { return std::make_pair(occ.row, occ.col) <= at; });
+        current_occurrence_index = (int)after - 1;
+    }
+}
 
-    // OPTION 1: Try Regex Search
-    try {
-        // Compile the regex pattern
-        std::regex pattern(pattern_str);
+std::vector<std::vector<editor::SearchMatch>> editor::find::visible_occurrences(size_t first_row, size_t rows)
+{
+    std::vector<std::vector<SearchMatch>> visible(rows);
+    if (mode != Mode::find)
+    {
+        return visible;
+    }
+    follow_edits();
 
-        for (int row = 0; row < buffer.getSize(); ++row)
+    // Only the matches of the rows in the window, whatever the total
+    IncrementalSearch& search = IncrementalSearch::instance();
+    auto show = [&](const SearchMatch& occ)
+    {
+        if (occ.end_row == occ.row)
         {
-            const std::string& buffer_row = buffer[row]; 
-            
-            // Use iterator to find all regex matches in the line
-            auto begin = std::sregex_iterator(buffer_row.begin(), buffer_row.end(), pattern);
-            auto end = std::sregex_iterator();
+            visible[occ.row - first_row].push_back(occ);
+            return;
+        }
 
-            for (std::sregex_iterator i = begin; i != end; ++i)
+        // A match over several rows: the part of it in each row of the window, its line breaks included
+        for (int row = std::max(occ.row, (int)first_row); row <= occ.end_row && row < (int)(first_row + rows); ++row)
+        {
+            int from = row == occ.row ? occ.col : 0;
+            int to = row == occ.end_row ? occ.end_col : (int)buffer[row].size() + 1;
+            if (to > from)
             {
-                std::smatch match = *i;
-                // Store row, column (position), and the specific length of this match
-                found_occurrences.push_back({ row, static_cast<int>(match.position()), static_cast<int>(match.length()) });
+                visible[row - first_row].push_back({row, from, to - from, row, to});
             }
         }
+    };
+    for (size_t i = 0; i < rows && !found_occurrences.empty(); ++i)
+    {
+        std::pair<size_t, size_t> range = search.in_row(first_row + i);
+        if (i == 0 && range.first > 0 && found_occurrences[range.first - 1].row < (int)first_row &&
+            found_occurrences[range.first - 1].end_row >= (int)first_row)
+        {
+            show(found_occurrences[range.first - 1]);   // started above the window
+        }
+        for (size_t m = range.first; m < range.second; ++m)
+        {
+            show(found_occurrences[m]);
+        }
     }
-    // OPTION 2: Fallback to Literal Search if Regex fails (e.g., user typed "[")
-    catch (const std::regex_error& e) {
-        
-        int word_len = pattern_str.length();
+    return visible;
+}
 
-        for (int row = 0; row < buffer.getSize(); ++row)
+void editor::find::style_searched_word(const std::vector<SearchMatch>& matches, std::vector<color>& colors)
+{
+    for (const auto& occ : matches)
+    {
+        // Ensure at least one character is highlighted, even for empty regex matches
+        size_t from = occ.col;
+        size_t to = std::min(colors.size(), (size_t)(occ.col + std::max(occ.length, 1)));
+        for (size_t i = from; i < to; ++i)
         {
-            std::string& buffer_row = buffer[row];
+            colors[i] = highlightedTextColor;
+        }
+    }
+}
 
-            // Standard string find (not regex)
-            size_t found_pos = buffer_row.find(pattern_str);
+// Runs the search until it is complete or interrupted; once complete, the results are put in row order
+static bool advance(IncrementalSearch::clock::time_point deadline, const std::function<bool()>& interrupted)
+{
+    IncrementalSearch& search = IncrementalSearch::instance();
+    if (!search.run(buffer, deadline, interrupted))
+    {
+        return false;
+    }
+    search.finish(buffer);
+    return true;
+}
 
-            while (found_pos != std::string::npos)
-            {
-                // Store the occurrence position with the fixed length
-                found_occurrences.push_back({ row, static_cast<int>(found_pos), word_len });
+// The first match after the cursor (or the last one before it), from the index once it is complete
+// and from the text itself while the rest of the buffer is being counted
+static void move_from_cursor(bool forward)
+{
+    editor::find::follow_edits();
+    IncrementalSearch& search = IncrementalSearch::instance();
+    const editor::SearchMatches& found = editor::found_occurrences;
+    editor::SearchMatch match;
+    if (search.complete())
+    {
+        if (found.empty()) return;
 
-                // Search for the next occurrence in the same row
-                found_pos = buffer_row.find(pattern_str, found_pos + word_len); // Move past this match
-            }
+        auto at = std::make_pair((int)pointed_row, (int)pointed_col);
+        size_t index;
+        if (forward)
+        {
+            index = found.partition_point([&](const editor::SearchMatch& occ) { return std::make_pair(occ.row, occ.col) <= at; });
+            index = index == found.size() ? 0 : index;
+        }
+        else
+        {
+            index = found.partition_point([&](const editor::SearchMatch& occ) { return std::make_pair(occ.row, occ.col) < at; });
+            index = (index + found.size() - 1) % found.size();
         }
+        editor::current_occurrence_index = (int)index;
+        match = found[index];
     }
+    else if (!search.scan_from(buffer, pointed_row, pointed_col, forward, match))
+    {
+        return;
+    }
+
+    editor::movement::move2X(match.col);
+
+    bool center_view = true;
+    editor::movement::move2Y(match.row, center_view);
 }
 
-void editor::find::highlight_searched_word()
+void editor::find::go_to_previous_occurrence()
 {
-    if (mode != Mode::find)
+    move_from_cursor(false);
+}
+
+void editor::find::go_to_next_occurrence()
+{
+    move_from_cursor(true);
+}
+
+bool editor::find::search_in_background()
+{
+    IncrementalSearch& search = IncrementalSearch::instance();
+    if (mode != Mode::find || search.complete())
     {
-        return;
+        return false;
     }
-    // Get visible start and end rows
-    int visible_start_row = starting_row;
-    int visible_end_row = std::min(static_cast<int>(starting_row + max_row), buffer.getSize() - 1);
+    return !advance(IncrementalSearch::clock::now() + std::chrono::milliseconds(8), editor::system::input_pending);
+}
 
-    for (const auto& occ : found_occurrences)
+void editor::find::complete_search()
+{
+    // Edits first: the search they leave to run is then run to its end
+    follow_edits();
+    advance(IncrementalSearch::clock::time_point::max(), nullptr);
+}
+
+std::string editor::find::search_status()
+{
+    if (!IncrementalSearch::instance().complete())
     {
-        // Unpack the struct
-        int row = occ.row;
-        int col = occ.col;
-        int len = occ.length; // Use the specific length of this match
+        return std::to_string(found_occurrences.size()) + " matches so far";
+    }
+
+    // "match k of N" while the cursor is on one
+    auto at = std::make_pair((int)pointed_row, (int)pointed_col);
+    size_t match = found_occurrences.partition_point([&](const SearchMatch& occ) { return std::make_pair(occ.row, occ.col) < at; });
+    if (match < found_occurrences.size() && found_occurrences[match].row == at.first && found_occurrences[match].col == at.second)
+    {
+        return "match " + std::to_string(match + 1) + " of " + std::to_string(found_occurrences.size());
+    }
+    return std::to_string(found_occurrences.size()) + " matches";
+}
 
-        // Highlight only occurrences within the visible range
-        if (row >= visible_start_row && row <= visible_end_row)
+void editor::find::find()
+{
+    IncrementalSearch& search = IncrementalSearch::instance();
+    Mode previous_mode = mode;
+    size_t origin_row = pointed_row, origin_col = pointed_col;
+    size_t origin_starting_row = starting_row, origin_starting_col = starting_col;
+
+    // Each slice of the search leaves time to draw the frame within the frame interval
+    const auto slice = std::chrono::milliseconds(8);
+
+    auto back_to_origin = [&]()
+    {
+        pointed_row = origin_row;
+        pointed_col = origin_col;
+        starting_row = origin_starting_row;
+        starting_col = origin_starting_col;
+        cursor.setX(pointed_col - starting_col);
+        cursor.setY(pointed_row - starting_row);
+    };
+
+    // Show the matches found so far, with the cursor on the nearest one
+    auto show = [&]()
+    {
+        SearchMatch nearest;
+        if (search.nearest(nearest))
+        {
+            movement::move2X(nearest.col);
+            movement::move2Y(nearest.row, true);
+        }
+        else
+        {
+            back_to_origin();
+        }
+        Screen::getScreen().update();
+    };
+
+    auto on_edit = [&](const std::string& term)
+    {
+        if (term.empty())
+        {
+            search.clear();
+        }
+        else
         {
-            // Highlight the found word in the visible row using its specific length
-            editor::visual::highlight_row_portion(row,
-                                      (col + span + 1),
-                                      (col + len + span));
+            search.start(buffer, term, origin_row, origin_col);
+            advance(IncrementalSearch::clock::now() + slice, editor::system::input_pending);
         }
+        show();
+    };
+
+    // Between keystrokes: go on with the search, until the next key
+    auto on_idle = [&]()
+    {
+        bool complete = advance(IncrementalSearch::clock::now() + slice, editor::system::input_pending);
+        show();
+        return !complete;
+    };
+
+    // Matches are only drawn in find mode
+    mode = Mode::find;
+    std::string search_term = editor::system::text_form("Search: ", on_edit, on_idle);
+
+    // Only as far as the nearest match: the rest is counted in the background, between keys
+    SearchMatch nearest;
+    if (!search_term.empty())
+    {
+        advance(IncrementalSearch::clock::time_point::max(), [&]() { return search.nearest(nearest); });
     }
+    if (search_term.empty() || !search.nearest(nearest))
+    {
+        search.clear();
+        back_to_origin();
+        mode = previous_mode;
+        if (!search_term.empty())
+        {
+            // Use ErrorHandler to report the issue
+            ErrorHandler::instance().report(ErrorLevel::WARNING, "Pattern not found: " + search_term);
+        }
+        return;
+    }
+
+    // Move the cursor to the occurrence nearest to where the search started
+    movement::move2X(nearest.col);
+    movement::move2Y(nearest.row, true);
+    current_occurrence_index = -1;
+    editor::system::change2find();
 }
 
-void editor::find::go_to_previous_occurrence()
+// The buffer the lines found by a project search go to: its first row says what was searched,
+// and each row after it shows the result at the same place in `project_results`
+static const std::string results_name = "Search results";
+static std::vector<ProjectSearch::Result> project_results;
+static std::string project_term;
+static std::string project_root;
+static bool project_searching = false;
+
+static std::string project_header(bool done)
 {
-    if (found_occurrences.empty()) return;
+    ProjectSearch& search = ProjectSearch::instance();
+    std::string header = "\"" + project_term + "\" in " + project_root + ": " + std::to_string(project_results.size()) + " lines in " +
+                         std::to_string(search.matched_files()) + " files";
+    if (!done)
+    {
+        return header + ", searching...";
+    }
+    return header + " (" + std::to_string(search.files()) + " files searched, " + std::to_string(search.binary_files()) +
+           " binary skipped, " + std::to_string((long)search.elapsed_ms()) + " ms)";
+}
 
-    // Move to the previous occurrence
-    current_occurrence_index = (current_occurrence_index - 1 + found_occurrences.size()) % found_occurrences.size();
-    
-    // Access via struct members
-    int row = found_occurrences[current_occurrence_index].row;
-    int col = found_occurrences[current_occurrence_index].col;
+void editor::find::project_search()
+{
+    std::string term = editor::system::text_form("Search in project: ");
+    if (term.empty())
+    {
+        return;
+    }
 
-    movement::move2X(col);
+    // The results go to their own buffer, made again for each search
+    BufferManager& manager = BufferManager::instance();
+    manager.syncBufferFromSystemVars();
+    if (!manager.get_buffer_by_name(results_name))
+    {
+        try
+        {
+            manager.create_buffer(results_name);
+        }
+        catch (const std::exception& e)
+        {
+            ErrorHandler::instance().report(ErrorLevel::ERROR, e.what());
+            return;
+        }
+    }
+    BufferManager::BufferStructure* results = manager.get_buffer_by_name(results_name);
+    manager.set_active_buffer(results - &manager.get_buffer(0));
+    results->read_only = true;
+    results->tBuffer = textBuffer();
+    results->mode = Mode::normal;
+    results->pointed_file.clear();
+    results->language = nullptr;
+    manager.syncSystemVarsFromBuffer();
+    editor::system::restore();
 
-    bool center_view = true;
-    movement::move2Y(row, center_view);
+    project_term = term;
+    project_root = std::filesystem::current_path().string();
+    project_results.clear();
+    project_searching = true;
+    ProjectSearch::instance().start(term, project_root);
+    buffer.set_row(0, project_header(false));
 }
 
-void editor::find::go_to_next_occurrence()
+bool editor::find::project_search_in_background()
 {
-    if (found_occurrences.empty()) return;
+    if (!project_searching)
+    {
+        return false;
+    }
 
-    // Move to the next occurrence
-    current_occurrence_index = (current_occurrence_index + 1) % found_occurrences.size();
-    
-    // Access via struct members
-    int row = found_occurrences[current_occurrence_index].row;
-    int col = found_occurrences[current_occurrence_index].col;
+    // The buffer was closed: nobody is waiting for the rest
+    BufferManager& manager = BufferManager::instance();
+    BufferManager::BufferStructure* results = manager.get_buffer_by_name(results_name);
+    if (!results)
+    {
+        ProjectSearch::instance().cancel();
+        project_searching = false;
+        return false;
+    }
 
-    movement::move2X(col);
+    std::vector<ProjectSearch::Result> found;
+    bool done = ProjectSearch::instance().take(found);
+    if (found.empty() && !done)
+    {
+        return true;
+    }
 
-    bool center_view = true;
-    movement::move2Y(row, center_view);
+    // The rows of the active buffer are the global ones
+    textBuffer& rows = results == &manager.get_active_buffer() ? buffer : results->tBuffer;
+    for (ProjectSearch::Result& result : found)
+    {
+        rows.push_back(std::move(result.text));
+        result.text.clear();
+        project_results.push_back(std::move(result));
+    }
+    rows.set_row(0, project_header(done));
+    project_searching = !done;
+    return project_searching;
 }
 
-void editor::find::find()
+void editor::find::open_project_result()
 {
-    std::string search_term = editor::system::text_form("Search: ");
-    if (search_term.empty())
+    BufferManager& manager = BufferManager::instance();
+    if (manager.get_current_buffer_name() != results_name || pointed_row == 0 || pointed_row > project_results.size())
     {
         return;
     }
-    current_occurrence_index = -1;
+    ProjectSearch::Result target = project_results[pointed_row - 1];
 
-    // Find all occurrences (Regex first, then Literal)
-    find_all_occurrence(search_term);
-
-    // If any occurrences were found, move the cursor to the first one
-    if (!found_occurrences.empty())
+    // In the first other buffer, or a new one
+    manager.syncBufferFromSystemVars();
+    int index = -1;
+    for (int i = 0; i < manager.getBufferCount() && index < 0; ++i)
     {
-        // Highlight occurrences in the visible rows
-        go_to_next_occurrence();
-        editor::system::change2find();
+        if (manager.get_buffer(i).name != results_name) index = i;
     }
-    else 
+    if (index < 0)
     {
-        // Use ErrorHandler to report the issue
-        ErrorHandler::instance().report(ErrorLevel::WARNING, "Pattern not found: " + search_term);
+        editor::system::new_buffer();
+        index = manager.get_active_buffer_index();
+        if (manager.get_buffer(index).name == results_name) return;
     }
-}
\ No newline at end of file
+    manager.set_active_buffer(index);
+    manager.syncSystemVarsFromBuffer();
+
+    std::string path = (std::filesystem::path(project_root) / *target.path).string();
+    if (pointed_file != path)
+    {
+        editor::file::read(path);
+        if (pointed_file != path) return;   // kept the unsaved changes, or could not read it
+    }
+    size_t row = std::min<size_t>(target.line, buffer.getSize() - 1);
+    movement::move2X(std::min<size_t>(target.col, buffer[row].size()));
+    movement::move2Y(row, true);
+    wclear(pointed_window);
+}
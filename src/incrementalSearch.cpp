@@ -0,0 +1,578 @@
+#include "../include/incrementalSearch.hpp"
+#include "../include/editorStats.hpp"
+#include "../include/trigramIndex.hpp"
+#include <algorithm>
+#include <climits>
+
+void SearchPattern::compile(const std::string& pattern)
+{
+    text = pattern;
+
+    // OPTION 1: Linear-time regex search (no backtracking, so no blow-up on patterns like (a*)*b)
+    RegexMatcher::Status status = matcher.compile(pattern);
+    if (status == RegexMatcher::Status::COMPILED) {
+        kind = Kind::REGEX;
+        return;
+    }
+
+    // OPTION 2: Backreferences and lookarounds need a backtracking engine
+    if (status == RegexMatcher::Status::UNSUPPORTED) {
+        try {
+            backtracking = std::regex(pattern);
+            kind = Kind::BACKTRACKING;
+            return;
+        } catch (const std::regex_error&) {
+        }
+    }
+
+    // OPTION 3: Fallback to literal search if the term is not a valid regex (e.g., user typed "[")
+    kind = Kind::LITERAL;
+    finder.assign(pattern);
+}
+
+void SearchPattern::matches(const std::string& row, int row_index, std::vector<editor::SearchMatch>& out)
+{
+    switch (kind) {
+        case Kind::REGEX:
+            matcher.for_each(row, [&](size_t start, size_t end) {
+                out.push_back({row_index, (int)start, (int)(end - start), row_index, (int)end});
+            });
+            break;
+        case Kind::BACKTRACKING:
+            for (auto it = std::sregex_iterator(row.begin(), row.end(), backtracking); it != std::sregex_iterator(); ++it) {
+                out.push_back({row_index, (int)it->position(), (int)it->length(), row_index, (int)(it->position() + it->length())});
+            }
+            break;
+        case Kind::LITERAL: {
+            size_t step = std::max<size_t>(text.size(), 1);
+            for (size_t at = finder.find(row); at != std::string::npos; at = finder.find(row, at + step)) {
+                out.push_back({row_index, (int)at, (int)text.size(), row_index, (int)(at + text.size())});
+            }
+            break;
+        }
+    }
+}
+
+// A match found through the rows as one text
+static editor::SearchMatch spanning(const std::deque<std::string>& lines, const RegexMatcher::Position& start, const RegexMatcher::Position& end)
+{
+    int length = (int)(end.col - start.col);
+    for (size_t row = start.row; row < end.row; ++row) {
+        length += (int)lines[row].size() + 1;
+    }
+    return {(int)start.row, (int)start.col, length, (int)end.row, (int)end.col};
+}
+
+void SearchPattern::matches_across(const std::deque<std::string>& lines, RegexMatcher::Position& from, size_t until,
+                                   std::vector<editor::SearchMatch>& out)
+{
+    RegexMatcher::Position start, end;
+    while (from.row < until && matcher.search_rows(lines, from, until, start, end)) {
+        if (start.row >= until) {
+            from = start;   // the next call finds it again
+            break;
+        }
+        out.push_back(spanning(lines, start, end));
+    }
+}
+
+bool SearchPattern::is_literal() const
+{
+    return kind == Kind::LITERAL || (kind == Kind::REGEX && matcher.is_literal());
+}
+
+std::string SearchPattern::required() const
+{
+    switch (kind) {
+        case Kind::REGEX: return matcher.required_prefix();
+        case Kind::LITERAL: return text;
+        default: return "";
+    }
+}
+
+std::vector<std::string> SearchPattern::literals() const
+{
+    switch (kind) {
+        case Kind::REGEX: return matcher.required_literals();
+        case Kind::LITERAL: {
+            std::string lowered = text;
+            std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+            return {lowered};
+        }
+        default: return {};
+    }
+}
+
+bool SearchPattern::narrows(const SearchPattern& previous) const
+{
+    // Every match of this term contains the previous text, so its rows matched before
+    return previous.is_literal() && required().find(previous.required()) != std::string::npos;
+}
+
+std::shared_ptr<SearchPattern> IncrementalSearch::compiled(const std::string& term)
+{
+    std::shared_ptr<SearchPattern>& entry = patterns.get(term);
+    if (!entry) {
+        entry = std::make_shared<SearchPattern>();
+        entry->compile(term);
+    }
+    return entry;
+}
+
+void IncrementalSearch::start(const textBuffer& text, const std::string& term, size_t row, size_t col)
+{
+    std::shared_ptr<SearchPattern> next = compiled(term);
+    bool narrowing = pattern && text.getId() == text_id && text.getVersion() == scan_version &&
+                     row == origin_row && col == origin_col && next->narrows(*pattern);
+
+    if (next->multiline()) {
+        // Read as one text from the start of the cursor row: neither the rows of the last term nor the index apply
+        candidates.clear();
+        next_step = 0;
+    } else if (narrowing) {
+        // The rows that matched, then the ones the last scan did not get to
+        std::vector<int> left(matched_rows);
+        left.insert(left.end(), candidates.begin() + next_candidate, candidates.end());
+        candidates.swap(left);
+    } else if (TrigramIndex::instance().candidates(text, next->literals(), candidates)) {
+        // Only the rows the index cannot rule out, in scan order
+        std::rotate(candidates.begin(), std::lower_bound(candidates.begin(), candidates.end(), (int)row), candidates.end());
+        next_step = text.get_buffer().size();
+    } else {
+        candidates.clear();
+        next_step = 0;
+    }
+    next_candidate = 0;
+
+    pattern = next;
+    text_id = text.getId();
+    version = text.getVersion();
+    scan_version = version;
+    origin_row = row;
+    origin_col = col;
+    rows = text.get_buffer().size();
+    done = false;
+    resume = {row, 0};
+    wrapped = false;
+
+    matched_rows.clear();
+    editor::found_occurrences.clear();
+    nearest_index = -1;
+    wrap_index = SIZE_MAX;
+}
+
+void IncrementalSearch::clear()
+{
+    pattern.reset();
+    candidates.clear();
+    matched_rows.clear();
+    editor::found_occurrences.clear();
+    nearest_index = -1;
+    wrap_index = SIZE_MAX;
+    done = true;
+}
+
+void IncrementalSearch::merge(const SearchPool::Chunk& chunk)
+{
+    editor::SearchMatches& found = editor::found_occurrences;
+    size_t first = found.size();
+    found.append(chunk.matches);
+
+    for (size_t i = first; i < found.size(); ++i) {
+        const editor::SearchMatch& match = chunk.matches[i - first];
+        if (matched_rows.empty() || matched_rows.back() != match.row) {
+            matched_rows.push_back(match.row);
+        }
+        if ((size_t)match.row < origin_row && wrap_index == SIZE_MAX) {
+            wrap_index = i;
+        }
+
+        // The nearest is the first match after the cursor, in scan order
+        if (nearest_index < 0 && ((size_t)match.row != origin_row || (size_t)match.col > origin_col)) {
+            nearest_index = (long)i;
+        }
+    }
+}
+
+bool IncrementalSearch::next_batch(const textBuffer& text)
+{
+    const auto& lines = text.get_buffer();
+    size_t chunks = SearchPool::instance().threads() * BATCH_CHUNKS;
+    batch.resize(chunks);
+
+    size_t used = 0;
+    while (used < chunks) {
+        SearchPool::Chunk& chunk = batch[used];
+        chunk.rows.clear();
+        chunk.matches.clear();
+        size_t bytes = 0;
+        while (chunk.rows.size() < CHUNK_ROWS && bytes < CHUNK_BYTES) {
+            int row;
+            if (next_candidate < candidates.size()) {
+                row = candidates[next_candidate++];
+            } else if (next_step < rows) {
+                row = (int)((origin_row + next_step++) % rows);
+            } else {
+                break;
+            }
+            chunk.rows.push_back(row);
+            bytes += lines[row].size();
+        }
+        if (chunk.rows.empty()) {
+            break;
+        }
+        ++used;
+    }
+    batch.resize(used);
+    return used > 0;
+}
+
+bool IncrementalSearch::run(const textBuffer& text, clock::time_point deadline, const std::function<bool()>& interrupted)
+{
+    if (done) {
+        return true;
+    }
+    if (text.getId() != text_id || text.getVersion() != version) {
+        // The text changed under the search: start it over
+        start(text, pattern->text, std::min(origin_row, text.get_buffer().size() - 1), origin_col);
+    }
+    if (pattern->multiline()) {
+        return stream(text, deadline, interrupted);
+    }
+
+    size_t checked = 0;
+    while (true) {
+        if (!next_batch(text)) {
+            done = true;
+            break;
+        }
+        SearchPool::instance().search(text.get_buffer(), pattern, batch);
+        for (const SearchPool::Chunk& chunk : batch) {
+            checked += chunk.rows.size();
+            merge(chunk);
+        }
+        if (clock::now() >= deadline || (interrupted && interrupted())) {
+            break;
+        }
+    }
+    EditorStats::instance().rows_searched += checked;
+    return done;
+}
+
+bool IncrementalSearch::stream(const textBuffer& text, clock::time_point deadline, const std::function<bool()>& interrupted)
+{
+    // From the origin row to the end of the text, then from the top to the origin row
+    const auto& lines = text.get_buffer();
+    batch.resize(1);
+    SearchPool::Chunk& chunk = batch[0];
+    size_t checked = 0;
+    while (true) {
+        size_t until = wrapped ? origin_row : rows;
+        if (resume.row >= until) {
+            if (wrapped || origin_row == 0) {
+                done = true;
+                stitch(text);
+                break;
+            }
+            wrapped = true;
+            resume = {0, 0};
+            continue;
+        }
+        size_t first = resume.row;
+        chunk.matches.clear();
+        pattern->matches_across(lines, resume, std::min(until, first + CHUNK_ROWS), chunk.matches);
+        checked += std::min(resume.row, rows) - first;
+        merge(chunk);
+        if (clock::now() >= deadline || (interrupted && interrupted())) {
+            break;
+        }
+    }
+    EditorStats::instance().rows_searched += checked;
+    return done;
+}
+
+void IncrementalSearch::stitch(const textBuffer& text)
+{
+    editor::SearchMatches& found = editor::found_occurrences;
+    if (wrap_index == SIZE_MAX) {
+        return;
+    }
+    const editor::SearchMatch last = found.back();
+    if ((size_t)last.end_row < origin_row || ((size_t)last.end_row == origin_row && last.end_col == 0)) {
+        return;
+    }
+
+    // The last match above the origin row runs into it: search on from its end until the
+    // search comes to where the one from the origin row went on after a match of its own
+    auto before = [](const editor::SearchMatch& match, const RegexMatcher::Position& at) {
+        return (size_t)match.row < at.row || ((size_t)match.row == at.row && (size_t)match.col < at.col);
+    };
+    auto after = [&](const editor::SearchMatch& match) {
+        bool empty = match.row == match.end_row && match.col == match.end_col;
+        if (!empty) return RegexMatcher::Position{(size_t)match.end_row, (size_t)match.end_col};
+        if ((size_t)match.end_col < text.get_buffer()[match.end_row].size()) return RegexMatcher::Position{(size_t)match.end_row, (size_t)match.end_col + 1};
+        return RegexMatcher::Position{(size_t)match.end_row + 1, 0};
+    };
+    RegexMatcher::Position from{(size_t)last.end_row, (size_t)last.end_col};
+    std::vector<editor::SearchMatch> again;
+    size_t kept = 0;
+    while (true) {
+        bool agreed = false;
+        for (; kept < wrap_index && before(found[kept], from); ++kept) {
+            RegexMatcher::Position next = after(found[kept]);
+            agreed = next.row == from.row && next.col == from.col;
+        }
+        if (agreed) {
+            break;
+        }
+        RegexMatcher::Position start, end;
+        if (!pattern->matcher.search_rows(text.get_buffer(), from, rows, start, end)) {
+            kept = wrap_index;   // none after it: the rest of the old matches are gone
+            break;
+        }
+        again.push_back(spanning(text.get_buffer(), start, end));
+    }
+
+    found.erase(0, kept);
+    found.insert(0, again);
+    wrap_index = again.size() + wrap_index - kept;
+    nearest_index = -1;
+    for (size_t i = 0; i < wrap_index && nearest_index < 0; ++i) {
+        if ((size_t)found[i].row != origin_row || (size_t)found[i].col > origin_col) nearest_index = (long)i;
+    }
+}
+
+int IncrementalSearch::finish(const textBuffer& text)
+{
+    run(text, clock::time_point::max());
+
+    // Scan order put the rows above the origin last: rotate them first
+    editor::SearchMatches& found = editor::found_occurrences;
+    if (nearest_index < 0 && !found.empty()) {
+        nearest_index = 0;   // only matches at or before the cursor on its own row
+    }
+    if (wrap_index != SIZE_MAX) {
+        size_t above = found.size() - wrap_index;
+        found.rotate(wrap_index);
+        if (nearest_index >= 0) {
+            nearest_index = (size_t)nearest_index < wrap_index ? nearest_index + above : nearest_index - wrap_index;
+        }
+        wrap_index = SIZE_MAX;
+    }
+    return (int)nearest_index;
+}
+
+bool IncrementalSearch::follow(const textBuffer& text)
+{
+    editor::SearchMatches& found = editor::found_occurrences;
+    if (!pattern || !done || wrap_index != SIZE_MAX) {
+        return false;   // no search, or one still in scan order
+    }
+    if (text.getId() != text_id) {
+        clear();
+        return true;
+    }
+    if (text.getVersion() == version) {
+        return false;
+    }
+
+    const auto& lines = text.get_buffer();
+    long rows_after = (long)rows;
+    bool replayable = text.edits_since(version, edits);
+    for (const BufferEdit& edit : edits) {
+        rows_after += edit.kind == BufferEdit::INSERT ? edit.count : edit.kind == BufferEdit::ERASE ? -edit.count : 0;
+        replayable = replayable && edit.kind != BufferEdit::RESET;
+    }
+    if (!replayable || rows_after != (long)lines.size()) {
+        // Nothing to go by: search it all again, from the top, in the slices run() is given
+        start(text, pattern->text, 0, 0);
+        return true;
+    }
+    if (pattern->multiline()) {
+        search_on(text);
+        return true;
+    }
+    version = text.getVersion();
+    rows = lines.size();
+
+    // Replay the edits on the matches, as the highlighter does with its cache:
+    // the rows below an edit move with their matches, and the rows changed or
+    // inserted are kept aside, where they end up, to be searched again
+    changed.clear();
+    for (const BufferEdit& edit : edits) {
+        switch (edit.kind) {
+            case BufferEdit::CHANGE:
+                changed.push_back(edit.row);
+                break;
+            case BufferEdit::INSERT:
+                found.insert_rows(edit.row, edit.count);
+                for (int& row : changed) {
+                    if (row >= edit.row) row += edit.count;
+                }
+                for (int k = 0; k < edit.count; ++k) changed.push_back(edit.row + k);
+                break;
+            case BufferEdit::ERASE:
+                found.erase_rows(edit.row, edit.count);
+                changed.erase(std::remove_if(changed.begin(), changed.end(), [&](int row) {
+                    return row >= edit.row && row < edit.row + edit.count;
+                }), changed.end());
+                for (int& row : changed) {
+                    if (row >= edit.row + edit.count) row -= edit.count;
+                }
+                break;
+            case BufferEdit::RESET:
+                break;
+        }
+    }
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    std::vector<editor::SearchMatch> fresh;
+    for (int row : changed) {
+        if (row < 0 || (size_t)row >= lines.size()) continue;
+        fresh.clear();
+        pattern->matches(lines[row], row, fresh);
+        found.replace_row(row, fresh);
+    }
+    EditorStats::instance().rows_searched += changed.size();
+    return true;
+}
+
+void IncrementalSearch::search_on(const textBuffer& text)
+{
+    // The matches that start before the first edited row stay, but for the last of
+    // them, which may run into it: the search goes on from its start, as if it had
+    // just come to it, in the slices run() is given
+    editor::SearchMatches& found = editor::found_occurrences;
+    int first_row = INT_MAX;
+    for (const BufferEdit& edit : edits) first_row = std::min(first_row, edit.row);
+    size_t kept = found.partition_point([&](const editor::SearchMatch& match) { return match.row < first_row; });
+    resume = {0, 0};
+    if (kept > 0) {
+        editor::SearchMatch last = found[--kept];
+        resume = {(size_t)last.row, (size_t)last.col};
+    }
+    found.erase(kept, found.size());
+
+    version = text.getVersion();
+    scan_version = version;
+    rows = text.get_buffer().size();
+    origin_row = 0;
+    origin_col = 0;
+    wrapped = false;
+    done = false;
+    matched_rows.clear();
+    nearest_index = found.empty() ? -1 : 0;
+    wrap_index = SIZE_MAX;
+}
+
+bool IncrementalSearch::scan_from(const textBuffer& text, size_t row, size_t col, bool forward, editor::SearchMatch& match)
+{
+    const auto& lines = text.get_buffer();
+    if (!pattern || lines.empty()) {
+        return false;
+    }
+    row = std::min(row, lines.size() - 1);
+    if (pattern->multiline()) {
+        return scan_across(text, row, col, forward, match);
+    }
+
+    // The cursor row twice: after the cursor first, before it once everything else was seen
+    std::vector<editor::SearchMatch> row_matches;
+    size_t searched = 0;
+    bool found = false;
+    for (size_t k = 0; k <= lines.size() && !found; ++k) {
+        size_t at = forward ? (row + k) % lines.size() : (row + lines.size() - k % lines.size()) % lines.size();
+        row_matches.clear();
+        pattern->matches(lines[at], (int)at, row_matches);
+        ++searched;
+        if (forward) {
+            for (const editor::SearchMatch& candidate : row_matches) {
+                if (k > 0 || (size_t)candidate.col > col) {
+                    match = candidate;
+                    found = true;
+                    break;
+                }
+            }
+        } else {
+            for (auto candidate = row_matches.rbegin(); candidate != row_matches.rend(); ++candidate) {
+                if (k > 0 || (size_t)candidate->col < col) {
+                    match = *candidate;
+                    found = true;
+                    break;
+                }
+            }
+        }
+    }
+    EditorStats::instance().rows_searched += searched;
+    return found;
+}
+
+bool IncrementalSearch::scan_across(const textBuffer& text, size_t row, size_t col, bool forward, editor::SearchMatch& match)
+{
+    // Through the rows as one text. After the position: from its row down, then from the top.
+    // Before it: from the top, the last match before it, or else the last match of the text.
+    const auto& lines = text.get_buffer();
+    std::vector<editor::SearchMatch> found;
+    RegexMatcher::Position from{forward ? row : 0, 0};
+    editor::SearchMatch last{};
+    bool any = false, before = false;
+    while (from.row < lines.size()) {
+        size_t first = from.row;
+        found.clear();
+        pattern->matches_across(lines, from, std::min(lines.size(), first + CHUNK_ROWS), found);
+        EditorStats::instance().rows_searched += std::min(from.row, lines.size()) - first;
+        for (const editor::SearchMatch& candidate : found) {
+            bool past = (size_t)candidate.row > row || ((size_t)candidate.row == row && (size_t)candidate.col > col);
+            bool short_of = (size_t)candidate.row < row || ((size_t)candidate.row == row && (size_t)candidate.col < col);
+            if (forward ? past : !short_of && before) {
+                if (forward) match = candidate;
+                return true;
+            }
+            if (short_of) {
+                match = candidate;
+                before = true;
+            }
+            last = candidate;
+            any = true;
+        }
+    }
+    if (!forward) {
+        if (!before && any) match = last;
+        return any;
+    }
+    from = {0, 0};
+    found.clear();
+    pattern->matches_across(lines, from, row + 1, found);
+    if (!found.empty()) match = found.front();
+    return !found.empty();
+}
+
+size_t IncrementalSearch::scan_key(int row) const
+{
+    // Until a match above the origin comes in, the scan order is the row order
+    return wrap_index == SIZE_MAX ? (size_t)row : ((size_t)row + rows - origin_row) % rows;
+}
+
+std::pair<size_t, size_t> IncrementalSearch::in_row(int row) const
+{
+    const editor::SearchMatches& found = editor::found_occurrences;
+    size_t key = scan_key(row);
+    size_t first = found.partition_point([&](const editor::SearchMatch& match) { return scan_key(match.row) < key; });
+    size_t last = found.partition_point([&](const editor::SearchMatch& match) { return scan_key(match.row) <= key; });
+    return {first, last};
+}
+
+bool IncrementalSearch::nearest(editor::SearchMatch& match) const
+{
+    const editor::SearchMatches& found = editor::found_occurrences;
+    if (nearest_index >= 0 && (size_t)nearest_index < found.size()) {
+        match = found[nearest_index];
+        return true;
+    }
+    if (done && !found.empty()) {
+        match = found[0];
+        return true;
+    }
+    return false;
+}
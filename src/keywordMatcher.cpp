@@ -0,0 +1,79 @@
+#include "../include/keywordMatcher.hpp"
+#include <algorithm>
+#include <cstring>
+
+void KeywordMatcher::add(const std::string& word, int group)
+{
+    if (!word.empty()) {
+        patterns.push_back({word, (uint32_t)word.length(), group});
+    }
+}
+
+void KeywordMatcher::build()
+{
+    // Bytes used by the keywords get a class of their own, all others share class 0
+    std::memset(byte_class, 0, sizeof(byte_class));
+    classes = 1;
+    for (const Pattern& p : patterns) {
+        for (unsigned char c : p.word) {
+            if (byte_class[c] == 0) byte_class[c] = classes++;
+        }
+    }
+
+    // 1. Trie: missing edges stay NONE for now
+    next.assign(classes, NONE);
+    std::vector<std::vector<uint32_t>> ends(1);
+    for (uint32_t id = 0; id < patterns.size(); ++id) {
+        uint32_t state = 0;
+        for (unsigned char c : patterns[id].word) {
+            uint32_t& edge = next[state * classes + byte_class[c]];
+            if (edge == NONE) {
+                edge = ends.size();
+                ends.emplace_back();
+                next.resize(next.size() + classes, NONE);
+            }
+            state = next[state * classes + byte_class[c]];
+        }
+        ends[state].push_back(id);
+    }
+
+    // 2. Breadth first: failure links, then the missing edges borrowed from them
+    size_t states = ends.size();
+    std::vector<uint32_t> fail(states, 0);
+    dictionary.assign(states, NONE);
+    std::vector<uint32_t> queue;
+    queue.reserve(states);
+
+    for (uint32_t c = 0; c < classes; ++c) {
+        uint32_t& edge = next[c];
+        if (edge == NONE) {
+            edge = 0;
+        } else {
+            queue.push_back(edge);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t u = queue[head];
+        uint32_t f = fail[u];
+        dictionary[u] = !ends[f].empty() ? f : dictionary[f];
+
+        for (uint32_t c = 0; c < classes; ++c) {
+            uint32_t& edge = next[u * classes + c];
+            if (edge == NONE) {
+                edge = next[f * classes + c];
+            } else {
+                fail[edge] = next[f * classes + c];
+                queue.push_back(edge);
+            }
+        }
+    }
+
+    // 3. Flatten the keywords ending at each state
+    output_begin.assign(states + 1, 0);
+    outputs.clear();
+    for (size_t s = 0; s < states; ++s) {
+        output_begin[s] = outputs.size();
+        outputs.insert(outputs.end(), ends[s].begin(), ends[s].end());
+    }
+    output_begin[states] = outputs.size();
+}
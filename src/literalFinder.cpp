@@ -0,0 +1,119 @@
+#include "../include/literalFinder.hpp"
+#include <cstdint>
+#include <cstring>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+static bool is_letter(unsigned char byte)
+{
+    return (byte | 0x20) >= 'a' && (byte | 0x20) <= 'z';
+}
+
+void LiteralFinder::assign(const std::string& needle, bool fold)
+{
+    folded = needle;
+    masks.assign(needle.size(), 0);
+    ignore_case = false;
+    if (!fold) {
+        return;
+    }
+    for (size_t i = 0; i < needle.size(); ++i) {
+        if (is_letter((unsigned char)needle[i])) {
+            folded[i] |= 0x20;
+            masks[i] = 0x20;
+            ignore_case = true;
+        }
+    }
+}
+
+bool LiteralFinder::same(const char* text) const
+{
+    if (!ignore_case) {
+        return std::memcmp(text, folded.data(), folded.size()) == 0;
+    }
+    for (size_t i = 0; i < folded.size(); ++i) {
+        if ((text[i] | masks[i]) != folded[i]) return false;
+    }
+    return true;
+}
+
+size_t LiteralFinder::find(const char* text, size_t size, size_t from) const
+{
+    const size_t length = folded.size();
+    if (from > size || size - from < length) {
+        return std::string::npos;
+    }
+    if (length == 0) {
+        return from;
+    }
+
+    // A byte ORed with its mask equals the needle's byte: the same byte, or the other case of a letter
+    const size_t last = length - 1;
+    const char first_byte = folded[0], first_mask = masks[0];
+    const char last_byte = folded[last], last_mask = masks[last];
+    size_t i = from;
+
+#if defined(__AVX2__)
+    {
+        const __m256i first = _mm256_set1_epi8(first_byte), first_fold = _mm256_set1_epi8(first_mask);
+        const __m256i final = _mm256_set1_epi8(last_byte), final_fold = _mm256_set1_epi8(last_mask);
+        for (; i + last + 32 <= size; i += 32) {
+            __m256i starts = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(text + i)), first_fold);
+            __m256i ends = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(text + i + last)), final_fold);
+            uint32_t hits = (uint32_t)_mm256_movemask_epi8(
+                _mm256_and_si256(_mm256_cmpeq_epi8(starts, first), _mm256_cmpeq_epi8(ends, final)));
+            while (hits) {
+                size_t at = i + __builtin_ctz(hits);
+                if (same(text + at)) return at;
+                hits &= hits - 1;
+            }
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    {
+        const __m128i first = _mm_set1_epi8(first_byte), first_fold = _mm_set1_epi8(first_mask);
+        const __m128i final = _mm_set1_epi8(last_byte), final_fold = _mm_set1_epi8(last_mask);
+        for (; i + last + 16 <= size; i += 16) {
+            __m128i starts = _mm_or_si128(_mm_loadu_si128((const __m128i*)(text + i)), first_fold);
+            __m128i ends = _mm_or_si128(_mm_loadu_si128((const __m128i*)(text + i + last)), final_fold);
+            uint32_t hits = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(starts, first), _mm_cmpeq_epi8(ends, final)));
+            while (hits) {
+                size_t at = i + __builtin_ctz(hits);
+                if (same(text + at)) return at;
+                hits &= hits - 1;
+            }
+        }
+    }
+#endif
+
+    // What is left, or the whole text without vector instructions
+    if (!ignore_case) {
+        while (i + last < size) {
+            const char* at = (const char*)std::memchr(text + i, first_byte, size - last - i);
+            if (!at) return std::string::npos;
+            i = at - text;
+            if (text[i + last] == last_byte && same(at)) return i;
+            ++i;
+        }
+        return std::string::npos;
+    }
+    for (; i + last < size; ++i) {
+        if ((text[i] | first_mask) == first_byte && (text[i + last] | last_mask) == last_byte && same(text + i)) {
+            return i;
+        }
+    }
+    return std::string::npos;
+}
+
+const char* LiteralFinder::instruction_set()
+{
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
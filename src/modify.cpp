@@ -1,6 +1,9 @@
 #include "../include/editor.hpp"
 #include "../include/clipboardManager.hpp"
 #include <ncurses.h>
+#include <algorithm>
+#include <cstring>
+#include <thread>
 
 // Helper function used in older versions
 static void reverse_insert(int row, int col)
@@ -218,6 +221,145 @@ void editor::modify::paste_in_visual()
   editor::system::change2normal();
 }
 
+// In a row: `length` bytes at `col` give way to the `size` bytes of `text`
+struct Splice
+{
+  size_t col;
+  size_t length;
+  const char* text;
+  size_t size;
+};
+
+// Applies the splices of a row, left to right, in one pass over the row. It is done in place
+// when every splice shrinks the row or every one grows it, and through a copy otherwise.
+static void splice_row(std::string& row, const std::vector<Splice>& splices)
+{
+  long delta = 0;
+  bool shrinks = true, grows = true;
+  for (const Splice& splice : splices)
+  {
+    delta += (long)splice.size - (long)splice.length;
+    shrinks = shrinks && delta <= 0;
+    grows = grows && delta >= 0;
+  }
+
+  if (shrinks)
+  {
+    // What is written never passes what is left to read
+    char* data = &row[0];
+    size_t read = 0, write = 0;
+    for (const Splice& splice : splices)
+    {
+      std::memmove(data + write, data + read, splice.col - read);
+      write += splice.col - read;
+      std::memcpy(data + write, splice.text, splice.size);
+      write += splice.size;
+      read = splice.col + splice.length;
+    }
+    std::memmove(data + write, data + read, row.size() - read);
+    row.resize(write + row.size() - read);
+  }
+  else if (grows)
+  {
+    // The same from the end, once the row has room
+    size_t read = row.size();
+    row.resize(row.size() + delta);
+    char* data = &row[0];
+    size_t write = row.size();
+    for (auto splice = splices.rbegin(); splice != splices.rend(); ++splice)
+    {
+      size_t tail = read - (splice->col + splice->length);
+      write -= tail;
+      std::memmove(data + write, data + splice->col + splice->length, tail);
+      write -= splice->size;
+      std::memcpy(data + write, splice->text, splice->size);
+      read = splice->col;
+    }
+  }
+  else
+  {
+    std::string spliced;
+    spliced.reserve(row.size() + delta);
+    size_t read = 0;
+    for (const Splice& splice : splices)
+    {
+      spliced.append(row, read, splice.col - read);
+      spliced.append(splice.text, splice.size);
+      read = splice.col + splice.length;
+    }
+    spliced.append(row, read, std::string::npos);
+    row.swap(spliced);
+  }
+}
+
+// Replaces the matches of rows [first, last) of `texts`, the rows whose matches start at `starts[i]` in
+// found_occurrences. The replaced texts are kept in `replaced`, the matches `saved_at` says, and where
+// each replacement lands in `landed`.
+static void replace_in_rows(std::vector<std::string>& texts, const std::vector<size_t>& starts, size_t first, size_t last,
+                            const std::string& replace_term, std::string& replaced, const std::vector<size_t>& saved_at,
+                            std::vector<editor::SearchMatch>& landed)
+{
+  std::vector<Splice> splices;
+  auto next = editor::found_occurrences.iterator_at(starts[first]);
+  for (size_t i = first; i < last; ++i)
+  {
+    std::string& row = texts[i];
+    long shift = 0;
+    splices.clear();
+    for (size_t m = starts[i]; m < starts[i + 1]; ++m, ++next)
+    {
+      const editor::SearchMatch occ = *next;
+      std::memcpy(&replaced[saved_at[m]], row.data() + occ.col, occ.length);
+      splices.push_back({(size_t)occ.col, (size_t)occ.length, replace_term.data(), replace_term.size()});
+      landed[m] = {occ.row, (int)(occ.col + shift), occ.length};
+      shift += (long)replace_term.size() - occ.length;
+    }
+    splice_row(row, splices);
+  }
+}
+
+// Replaces matches that span rows: the rows a chain of matches joins become one row, and
+// every row is moved once, whatever the number of rows taken away
+static void replace_across_rows(const std::string& replace_term, editor::Replacement& replacement)
+{
+  const editor::SearchMatches& found = editor::found_occurrences;
+  std::vector<RowRun> runs;
+  size_t saved = 0;
+  int removed = 0;
+  for (size_t m = 0; m < found.size(); )
+  {
+    // From the row of a match to the end of the last match that starts where the one before it ends
+    int first = found[m].row;
+    int row = first;
+    size_t col = 0;
+    std::string text;
+    for (; m < found.size() && found[m].row == row; ++m)
+    {
+      const editor::SearchMatch& occ = found[m];
+      text.append(buffer[row], col, occ.col - col);
+      replacement.matches[m] = {first - removed, (int)text.size(), occ.length, first - removed, (int)(text.size() + replace_term.size())};
+      text += replace_term;
+      for (int r = occ.row; r <= occ.end_row; ++r)
+      {
+        size_t from = r == occ.row ? occ.col : 0;
+        size_t to = r == occ.end_row ? occ.end_col : buffer[r].size();
+        std::memcpy(&replacement.replaced[saved], buffer[r].data() + from, to - from);
+        saved += to - from;
+        if (r < occ.end_row) replacement.replaced[saved++] = '\n';
+      }
+      row = occ.end_row;
+      col = occ.end_col;
+    }
+    text.append(buffer[row], col, std::string::npos);
+    runs.push_back({first, row - first + 1, {}});
+    runs.back().rows.push_back(std::move(text));
+    removed += row - first;
+  }
+  buffer.replace_rows(runs);
+  replacement.across_rows = true;
+  status = Status::unsaved;
+}
+
 void editor::modify::replace()
 {
   std::string replace_term = editor::system::text_form("Replace with: ");
@@ -225,51 +367,120 @@ void editor::modify::replace()
       return;
   }
 
-  int replace_len = replace_term.length();
-  
-  bool first_action_pushed = false;
+  editor::modify::replace_all(replace_term);
+
+  // The replaced rows are searched again the next time the results are used
+  editor::system::change2normal();
+}
+
+void editor::modify::replace_all(const std::string& replace_term)
+{
+  // Every match, even those not counted yet
+  editor::find::complete_search();
+  if (found_occurrences.empty()) {
+      return;
+  }
 
-  for (auto& occ : found_occurrences)
+  // The rows with matches, where their matches start, and where each replaced text is kept
+  std::vector<int> rows;
+  std::vector<size_t> starts;
+  std::vector<size_t> saved_at(found_occurrences.size());
+  size_t saved = 0;
+  size_t m = 0;
+  bool across_rows = false;
+  for (const SearchMatch& occ : found_occurrences)
   {
-    int row = occ.row;
-    int col = occ.col;
-    int match_len = occ.length; 
+    if (rows.empty() || occ.row != rows.back())
+    {
+      rows.push_back(occ.row);
+      starts.push_back(m);
+    }
+    saved_at[m++] = saved;
+    saved += occ.length;
+    across_rows = across_rows || occ.end_row != occ.row;
+  }
+  starts.push_back(found_occurrences.size());
 
+  auto replacement = std::make_shared<Replacement>();
+  replacement->replaced.resize(saved);
+  replacement->matches.resize(found_occurrences.size());
+  replacement->length = replace_term.size();
+  if (across_rows)
+  {
+    replace_across_rows(replace_term, *replacement);
     if (!is_undoing) {
-        bool chain_delete = first_action_pushed; 
-        editor::action_history.push({
-            ActionType::DELETE_SELECTION, 
-            row, col, 0, 
-            buffer[row].substr(col, match_len), 
-            chain_delete
-        });
-        
-        first_action_pushed = true; 
-
-        editor::action_history.push({
-            ActionType::PASTE, 
-            row, col, 0, 
-            replace_term, 
-            true
-        });
+        editor::action_history.push({ActionType::REPLACE_ALL, rows.front(), found_occurrences.front().col, 0, "", false, replacement});
     }
+    return;
+  }
 
-    buffer[row].replace(col, match_len, replace_term); 
+  // Each row is changed once, in place, the rows split among the cores
+  std::vector<std::string> texts(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i)
+  {
+    texts[i] = std::move(buffer[rows[i]]);
+  }
+  size_t threads = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), rows.size() / 4096 + 1);
+  size_t per_thread = (rows.size() + threads - 1) / threads;
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; ++t)
+  {
+    workers.emplace_back(replace_in_rows, std::ref(texts), std::cref(starts), std::min(rows.size(), t * per_thread),
+                         std::min(rows.size(), (t + 1) * per_thread), std::cref(replace_term),
+                         std::ref(replacement->replaced), std::cref(saved_at), std::ref(replacement->matches));
+  }
+  replace_in_rows(texts, starts, 0, std::min(rows.size(), per_thread), replace_term, replacement->replaced, saved_at, replacement->matches);
+  for (std::thread& worker : workers) worker.join();
 
-    if (replace_len != match_len)
+  for (size_t i = 0; i < rows.size(); ++i)
+  {
+    buffer.set_row(rows[i], std::move(texts[i]));
+  }
+  status = Status::unsaved;
+
+  // A single undo step for the whole replacement
+  if (!is_undoing) {
+      editor::action_history.push({ActionType::REPLACE_ALL, rows.front(), found_occurrences.front().col, 0, "", false, replacement});
+  }
+}
+
+// Puts back the texts a replace-all replaced
+static void undo_replace_all(const editor::Replacement& replacement)
+{
+  const std::vector<editor::SearchMatch>& matches = replacement.matches;
+  std::vector<Splice> splices;
+  std::vector<RowRun> runs;
+  size_t saved = 0;
+  for (size_t m = 0; m < matches.size(); )
+  {
+    int row = matches[m].row;
+    splices.clear();
+    for (; m < matches.size() && matches[m].row == row; ++m)
+    {
+      splices.push_back({(size_t)matches[m].col, (size_t)replacement.length, replacement.replaced.data() + saved, (size_t)matches[m].length});
+      saved += matches[m].length;
+    }
+    std::string text = std::move(buffer[row]);
+    splice_row(text, splices);
+    if (replacement.across_rows)
     {
-      int shift = replace_len - match_len;
-      for (auto& occ_update : found_occurrences)
+      // The line breaks put back split the row into the rows it was
+      RowRun run{row, 1, {}};
+      for (size_t from = 0, end; ; from = end + 1)
       {
-        if (occ_update.row == row && occ_update.col > col)
-        {
-          occ_update.col += shift;
-        }
+        end = text.find('\n', from);
+        run.rows.push_back(text.substr(from, end == std::string::npos ? std::string::npos : end - from));
+        if (end == std::string::npos) break;
       }
+      runs.push_back(std::move(run));
+      continue;
     }
+    buffer.set_row(row, std::move(text));
+  }
+  if (!runs.empty())
+  {
+    buffer.replace_rows(runs);
   }
-
-  editor::system::change2normal();
 }
 
 void editor::modify::delete_selection(int start_row, int end_row, int start_col, int end_col)
@@ -381,7 +592,7 @@ void editor::modify::undo()
   
   while (keep_undoing && !editor::action_history.empty())
   {
-      Action last_action = editor::action_history.top();
+      Action last_action = std::move(editor::action_history.top());
       editor::action_history.pop();
       
       keep_undoing = last_action.is_chained;
@@ -413,7 +624,7 @@ void editor::modify::undo()
         break;
       case ActionType::DELETE_ROW:
         if (buffer.is_void()) {
-           if (last_action.row == 0) buffer[0] = last_action.text;
+           if (last_action.row == 0) buffer.set_row(0, last_action.text);
            else buffer.new_row(last_action.text, last_action.row);
         } else {
             buffer.new_row(last_action.text, last_action.row);
@@ -442,6 +653,9 @@ void editor::modify::undo()
         editor::system::change2normal();
         break;
       }
+      case ActionType::REPLACE_ALL:
+        undo_replace_all(*last_action.replacement);
+        break;
       default:
         break;
       }
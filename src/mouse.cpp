@@ -2,6 +2,7 @@
 #include "../include/globals/mvimResources.h"
 #include "../include/editor.hpp"
 #include "../include/bufferManager.hpp"
+#include "../include/softWrap.hpp"
 
 // Definitions for scroll wheel buttons if not present in older ncurses versions
 #if !defined(BUTTON4_PRESSED)
@@ -26,6 +27,18 @@ namespace Mouse {
 
     // Helper to sync column after vertical/horizontal movement
     void sync_cursor_column() {
+        // Wrapped rows: the view is scrolled first, then the point under the
+        // mouse is looked up in the wrap index
+        if (soft_wrap) {
+            int row, col;
+            SoftWrap::instance().follow_cursor();
+            SoftWrap::instance().hit(last_mouse_y, last_mouse_x, row, col);
+            pointed_row = row;
+            pointed_col = col;
+            SoftWrap::instance().follow_cursor();
+            return;
+        }
+
         int target_col = 0;
         
         // FIX: If in margin, snap to 'starting_col' (visible left edge), NOT 0.
@@ -203,6 +216,14 @@ namespace Mouse {
             return;
         }
 
+        // Wrapped rows: one screen line is not one buffer row
+        if (soft_wrap) {
+            int target_row, target_col;
+            SoftWrap::instance().hit(y, x, target_row, target_col);
+            process_mouse_action(event.bstate, target_row, target_col);
+            return;
+        }
+
         // 2. Calculate target Buffer Row
         int target_row = y + starting_row;
         if (target_row < 0) target_row = 0;
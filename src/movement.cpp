@@ -1,4 +1,5 @@
 #include "../include/editor.hpp"
+#include "../include/bracketIndex.hpp"
 
 void editor::movement::move2Y(int y, bool center_view) {
     // Set the cursor to the new occurrence
@@ -113,8 +114,7 @@ void editor::movement::move_left()
 
 void editor::movement::move_right()
 {
-  if ((cursor.getX() <= (buffer[pointed_row].length() - 1 - starting_col)) &&
-      !buffer[pointed_row].empty())
+  if (pointed_col < buffer[pointed_row].length())
   {
     if(cursor.getX() >= max_col - span - 2) starting_col++;
     else cursor.move_right();
@@ -293,3 +293,24 @@ void editor::movement::move_to_beginning_of_file()
   starting_col = pointed_col = 0;
   cursor.set(0, 0);
 }
+
+void editor::movement::jump_to_matching_bracket()
+{
+  BracketIndex& brackets = BracketIndex::instance();
+  size_t col;
+  BracketPair pair;
+  if (!brackets.next_on_row(buffer, pointed_row, pointed_col, col) ||
+      !brackets.match(buffer, pointed_row, col, pair))
+  {
+    return;
+  }
+
+  bool on_open = pair.open_row == pointed_row && pair.open_col == col;
+  size_t row = on_open ? pair.close_row : pair.open_row;
+  size_t target_col = on_open ? pair.close_col : pair.open_col;
+
+  // Only recenter when the other bracket is off the screen
+  bool visible = row >= starting_row && row < starting_row + max_row;
+  move2X(target_col);
+  move2Y(row, !visible);
+}
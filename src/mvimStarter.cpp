@@ -4,6 +4,9 @@
 #include <string>
 #include "../include/bufferManager.hpp"
 #include "../include/mouse.hpp"  
+#include "../include/benchmark.hpp"
+#include "../include/softWrap.hpp"
+#include "../include/trigramIndex.hpp"
 
 // Define constants and global variables
 const char* mvim_logo =
@@ -34,8 +37,6 @@ mvimStarter::mvimStarter() :
 
   // Load config NOW, after the screen is ready to display errors
   _command.loadConfig(".mvimrc"); 
-
-  mvimService.enableService("highlighting", editor::visual::highlight_keywords);
 }
 
 mvimStarter::mvimStarter(std::string filename, bool benchmark)
@@ -82,63 +83,47 @@ void mvimStarter::run()
 
   cursor.restore(span);
   
+  bool searching = false;
+  bool indexing = false;
+  bool projecting = false;
   while (true)
   {
-    // Set a timeout (50ms) to allow continuous actions (like mouse scrolling)
-    // and status bar updates.
-    wtimeout(pointed_window, 50);
+    // Wait for input up to 50ms when idle (continuous actions like mouse
+    // scrolling and status bar updates), or until the next frame is due.
+    // Not at all while a search is still being counted, and only a few ms
+    // while the search index needs rows or a project search is finding lines.
+    wtimeout(pointed_window, scheduler.wait_timeout(searching ? 0 : indexing || projecting ? 5 : 50));
 
     int input = wgetch(pointed_window);
 
     if (input != ERR)
     {
-      // Cancella il contenuto della finestra attualmente puntata
-      werase(pointed_window);  
-
-      if (input == KEY_MOUSE) 
+      // Apply the whole burst of queued input before drawing anything
+      do
       {
-          Mouse::handle_event();
+        if (input == KEY_MOUSE) 
+        {
+            Mouse::handle_event();
+        }
+        else 
+        {
+            // Esegue il comando dell'utente (tastiera)
+            _command.execute(input);
+        }
+        scheduler.input_applied();
       }
-      else 
-      {
-          // Esegue il comando dell'utente (tastiera)
-          _command.execute(input);
-      }
-  
-      // Aggiorna le variabili dello stato attuale
-      updateVar();
-
-      // Aggiorna il contenuto dello schermo
-      screen.update();
-
-      // Reimposta il colore di sfondo della finestra principale
-      wbkgd(pointed_window, COLOR_PAIR(get_pair(bgColor, cursorColor)));
-
-      // Esegue i servizi necessari
-      mvimService.run();
-
-      // Ripristina la posizione del cursore
-      cursor.restore(span);
-
-      // Pulisce e aggiorna tutte le finestre gestite da BufferManager
-      const auto& buffers = BufferManager::instance().get_all_buffers();
-      for (const auto& buffer : buffers) {
-          if (buffer->window == pointed_window) continue;
-
-          // Cancella ogni finestra per evitare residui di testo
-          werase(buffer->window);
-
-          // Stampa il contenuto del buffer nella finestra
-          print_bufferStructure(buffer);
+      while ((input = scheduler.poll(pointed_window)) != ERR);
+    }
 
-          // Aggiorna la finestra per mostrare i nuovi contenuti
-          wrefresh(buffer->window);
+    if (scheduler.has_pending())
+    {
+      // Render once for the burst, no more often than the target frame rate
+      if (scheduler.frame_due())
+      {
+        render_frame();
+        scheduler.frame_rendered();
+        Mouse::reset_dragging();
       }
-
-      // Aggiorna la finestra attualmente puntata
-      wrefresh(pointed_window);
-
-      Mouse::reset_dragging();
     }
     else 
     {
@@ -147,49 +132,53 @@ void mvimStarter::run()
       // 1. Handle continuous mouse behavior (e.g. scrolling while dragging at edge)
       Mouse::behavior_timer();
 
-      // 2. Handle status bar updates (clearing messages)
+      // 2. Count the matches of the last search, a slice at a time until a key comes,
+      // give the search index the next rows of the document, and show the lines
+      // the project search found
+      searching = editor::find::search_in_background();
+      indexing = TrigramIndex::instance().schedule(buffer);
+      projecting = editor::find::project_search_in_background();
+
+      // 3. Handle status bar updates (clearing messages)
       screen.draw_status_bar();
       
-      // 3. Update state and refresh
-      updateVar();
-      
-      // We must check if behavior_timer changed anything visually (like scrolling)
-      // Since behavior_timer calls move_up/down which modifies state, we should
-      // probably update the screen if drag is active.
-      // However, to be safe and simple, we can refresh the pointed window.
-      // If we are scrolling, we need a full update() actually.
-      
-      // A safe optimization: only full update if dragging is active (assumed from mouse module)
-      // or we can just rely on standard ncurses flow. 
-      // Given the structure, let's just refresh the window to show cursor moves 
-      // or screen updates triggered by move_up/down in behavior_timer.
-      
-      // Note: move_up/down modify global variables but don't draw. 
-      // We need to call screen.update() if we actually scrolled.
-      // Since we don't return a flag here, we can just call update() inside this block 
-      // if we want to be sure, or rely on the next input. 
-      // BUT, for animation, we MUST update here.
-      
-      werase(pointed_window);
-      screen.update(); 
-      wbkgd(pointed_window, COLOR_PAIR(get_pair(bgColor, cursorColor)));
-      mvimService.run();
-      cursor.restore(span);
-      wrefresh(pointed_window);
+      // 4. Update state and refresh: behavior_timer may have scrolled, and
+      // move_up/down modify global variables but don't draw.
+      render_frame();
     }
   }
 }
 
-void mvimStarter::print_bufferStructure(BufferManager::BufferStructure* buffer){
-  if (buffer != nullptr) {
-    screen.print_buffer(
-        buffer->tBuffer.get_buffer(),  
-        buffer->window,                        
-        buffer->starting_row,          
-        buffer->starting_col,          
-        buffer->max_col                
-    );
+void mvimStarter::render_frame()
+{
+  // Aggiorna le variabili dello stato attuale
+  updateVar();
+
+  // Con le righe a capo lo scroll segue la riga visiva del cursore
+  if (soft_wrap)
+  {
+    SoftWrap::instance().follow_cursor();
   }
+
+  // Aggiorna il contenuto dello schermo: ogni riga viene riscritta per intero,
+  // quindi non serve cancellare la finestra (e lo scroll resta hardware)
+  screen.update();
+
+  // Reimposta il colore di sfondo della finestra principale
+  wbkgd(pointed_window, COLOR_PAIR(get_pair(bgColor, cursorColor)));
+
+  // Esegue i servizi necessari
+  mvimService.run();
+
+  // Ripristina la posizione del cursore
+  cursor.restore(span);
+
+  // Ridisegna solo le finestre inattive che sono cambiate
+  screen.refresh_all_buffers();
+
+  // Accoda la finestra puntata e invia tutto al terminale in un solo passo
+  wnoutrefresh(pointed_window);
+  doupdate();
 }
 
 // Show the initial welcome screen
@@ -256,6 +245,10 @@ void mvimStarter::setDefaults()
 
 void mvimStarter::startBenchmark(std::string filename)
 {
+  // Draw in memory: benchmarks run without a terminal
+  CellGrid grid(50, 160);
+  screen.set_surface(&grid);
+
   auto start_time = std::chrono::high_resolution_clock::now();    // Start timing
 
   editor::file::read(filename);    // Load file content
@@ -263,6 +256,26 @@ void mvimStarter::startBenchmark(std::string filename)
   std::chrono::duration<double, std::milli> load_time = end_time - start_time;    // Get load time in milliseconds
 
   std::cout << "Time taken to load the file: " << load_time.count() << " ms" << std::endl;
+
+  benchmark::render(grid);
+  benchmark::soft_wrap(grid);
+  benchmark::keywords();
+  benchmark::background_highlight(grid);
+  benchmark::language_loading();
+  benchmark::brackets();
+  benchmark::long_lines(grid);
+  benchmark::regex_search();
+  benchmark::incremental_search();
+  benchmark::parallel_search();
+  benchmark::literal_search();
+  benchmark::search_edits();
+  benchmark::search_highlight();
+  benchmark::search_from_cursor();
+  benchmark::replace_all();
+  benchmark::search_index();
+  benchmark::multiline_search();
+  benchmark::project_search();
+
   std::cout << "Benchmarking mode: Exiting mvimStarter after loading." << std::endl;
   exit(0);    // Exit the program after showing benchmark results
 }
\ No newline at end of file
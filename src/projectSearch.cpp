@@ -0,0 +1,428 @@
+#include "../include/projectSearch.hpp"
+#include "../include/incrementalSearch.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Matches a glob against the whole of a path: `*` and `?` stay within a name, `**` does not
+static bool glob_match(const char* p, const char* pe, const char* s, const char* se)
+{
+    while (p < pe) {
+        char c = *p;
+        if (c == '*') {
+            if (p + 1 < pe && p[1] == '*') {
+                // `**/` stands for any number of directories, `**` anywhere else for anything
+                const char* rest = p + 2;
+                bool directories = rest < pe && *rest == '/';
+                if (directories) ++rest;
+                for (const char* at = s;; ++at) {
+                    if ((!directories || at == s || at[-1] == '/') && glob_match(rest, pe, at, se)) return true;
+                    if (at == se) return false;
+                }
+            }
+            ++p;
+            for (const char* at = s;; ++at) {
+                if (glob_match(p, pe, at, se)) return true;
+                if (at == se || *at == '/') return false;
+            }
+        }
+        if (s == se) {
+            return false;
+        }
+        if (c == '?') {
+            if (*s == '/') return false;
+        } else if (c == '[') {
+            // A class: `[a-z]`, `[!0-9]`; one never closed is a plain '['
+            const char* q = p + 1;
+            bool negated = q < pe && (*q == '!' || *q == '^');
+            if (negated) ++q;
+            bool found = false;
+            const char* first = q;
+            for (; q < pe && (*q != ']' || q == first); ++q) {
+                if (q + 2 < pe && q[1] == '-' && q[2] != ']') {
+                    found |= (unsigned char)*s >= (unsigned char)*q && (unsigned char)*s <= (unsigned char)q[2];
+                    q += 2;
+                } else {
+                    found |= *s == *q;
+                }
+            }
+            if (q < pe) {
+                if (found == negated || *s == '/') return false;
+                p = q;
+            } else if (*s != '[') {
+                return false;
+            }
+        } else {
+            if (c == '\\' && p + 1 < pe) c = *++p;
+            if (*s != c) return false;
+        }
+        ++p;
+        ++s;
+    }
+    return s == se;
+}
+
+GitIgnore::GitIgnore(const std::string& text, const std::string& directory, std::shared_ptr<const GitIgnore> parent)
+    : directory(directory.empty() ? "" : directory + "/"), parent(std::move(parent))
+{
+    size_t at = 0;
+    while (at < text.size()) {
+        size_t end = std::min(text.find('\n', at), text.size());
+        std::string line = text.substr(at, end - at);
+        at = end + 1;
+
+        // Trailing spaces (unless escaped) and a carriage return do not count
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        while (!line.empty() && line.back() == ' ' && (line.size() < 2 || line[line.size() - 2] != '\\')) line.pop_back();
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        Rule rule;
+        if (line[0] == '!') {
+            rule.negated = true;
+            line.erase(0, 1);
+        } else if (line[0] == '\\' && line.size() > 1 && (line[1] == '#' || line[1] == '!')) {
+            line.erase(0, 1);
+        }
+        if (!line.empty() && line.back() == '/') {
+            rule.directory_only = true;
+            line.pop_back();
+        }
+        rule.anchored = line.find('/') != std::string::npos;
+        if (!line.empty() && line[0] == '/') line.erase(0, 1);
+        if (line.empty()) {
+            continue;
+        }
+        rule.glob = line;
+        rules.push_back(std::move(rule));
+    }
+}
+
+bool GitIgnore::ignores(const std::string& path, bool is_directory) const
+{
+    const char* name = path.c_str();
+    if (const char* slash = std::strrchr(name, '/')) name = slash + 1;
+    const char* end = path.c_str() + path.size();
+
+    // From the deepest file up, the last pattern that matches decides
+    for (const GitIgnore* level = this; level; level = level->parent.get()) {
+        if (path.compare(0, level->directory.size(), level->directory) != 0) continue;
+        const char* below = path.c_str() + level->directory.size();
+        for (auto rule = level->rules.rbegin(); rule != level->rules.rend(); ++rule) {
+            if (rule->directory_only && !is_directory) continue;
+            const char* pattern = rule->glob.c_str();
+            if (glob_match(pattern, pattern + rule->glob.size(), rule->anchored ? below : name, end)) {
+                return !rule->negated;
+            }
+        }
+    }
+    return false;
+}
+
+ProjectSearch::ProjectSearch()
+    : count(std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+ProjectSearch::~ProjectSearch()
+{
+    stop();
+}
+
+void ProjectSearch::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        entries.clear();
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+}
+
+void ProjectSearch::start(const std::string& term, const std::string& directory)
+{
+    stop();
+    auto pattern = std::make_shared<SearchPattern>();
+    pattern->compile(term);
+    prototype = pattern;
+    root = directory;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = false;
+        found.clear();
+        entries.push_back({"", true, nullptr});
+        busy = 0;
+        running = count;
+    }
+    searched = 0;
+    matched = 0;
+    binary = 0;
+    duration_ms = 0;
+    started = clock::now();
+    for (size_t i = 0; i < count; ++i) workers.emplace_back(&ProjectSearch::run, this);
+}
+
+void ProjectSearch::cancel()
+{
+    stop();
+    std::lock_guard<std::mutex> guard(lock);
+    found.clear();
+}
+
+bool ProjectSearch::take(std::vector<Result>& out)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (out.empty()) {
+        out.swap(found);
+    } else {
+        std::move(found.begin(), found.end(), std::back_inserter(out));
+    }
+    found.clear();
+    return running == 0;
+}
+
+void ProjectSearch::wait()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    finished.wait(guard, [&]() { return running == 0; });
+}
+
+void ProjectSearch::run()
+{
+    SearchPattern pattern = *prototype;
+    std::vector<char> scratch;
+    std::vector<Entry> listed;
+    std::vector<Result> results;
+
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        // Nothing left once no entry is waiting and no other worker can list more
+        wake.wait(guard, [&]() { return stopping || !entries.empty() || busy == 0; });
+        if (stopping || entries.empty()) {
+            break;
+        }
+        Entry entry = std::move(entries.back());
+        entries.pop_back();
+        ++busy;
+        guard.unlock();
+
+        listed.clear();
+        results.clear();
+        if (entry.directory) {
+            list(entry, listed);
+        } else {
+            search_file(entry.path, pattern, scratch, results);
+        }
+
+        guard.lock();
+        --busy;
+        std::move(listed.begin(), listed.end(), std::back_inserter(entries));
+        std::move(results.begin(), results.end(), std::back_inserter(found));
+        if (!listed.empty() || (busy == 0 && entries.empty())) {
+            wake.notify_all();
+        }
+    }
+
+    if (--running == 0) {
+        if (!stopping) {
+            duration_ms = std::chrono::duration<double, std::milli>(clock::now() - started).count();
+        }
+        finished.notify_all();
+    }
+}
+
+// The whole of a small file
+static bool read_all(int fd, size_t size, std::vector<char>& bytes)
+{
+    bytes.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = ::read(fd, bytes.data() + done, size - done);
+        if (got <= 0) break;
+        done += got;
+    }
+    bytes.resize(done);
+    return done > 0;
+}
+
+void ProjectSearch::list(const Entry& directory, std::vector<Entry>& out)
+{
+    std::string path = directory.path.empty() ? root : root + "/" + directory.path;
+    DIR* listing = opendir(path.c_str());
+    if (!listing) {
+        return;
+    }
+
+    // The rules of this directory come on top of those above it
+    std::shared_ptr<const GitIgnore> ignore = directory.ignore;
+    int rules = openat(dirfd(listing), ".gitignore", O_RDONLY | O_CLOEXEC);
+    if (rules >= 0) {
+        struct stat info;
+        std::vector<char> text;
+        if (fstat(rules, &info) == 0 && S_ISREG(info.st_mode) && read_all(rules, info.st_size, text)) {
+            ignore = std::make_shared<GitIgnore>(std::string(text.begin(), text.end()), directory.path, ignore);
+        }
+        close(rules);
+    }
+
+    std::string prefix = directory.path.empty() ? "" : directory.path + "/";
+    while (dirent* item = readdir(listing)) {
+        const char* name = item->d_name;
+        if (std::strcmp(name, ".") == 0 || std::strcmp(name, "..") == 0 || std::strcmp(name, ".git") == 0) {
+            continue;
+        }
+
+        // Symbolic links are not followed, and only regular files are read
+        bool is_directory = item->d_type == DT_DIR, is_file = item->d_type == DT_REG;
+        if (item->d_type == DT_UNKNOWN) {
+            struct stat info;
+            if (fstatat(dirfd(listing), name, &info, AT_SYMLINK_NOFOLLOW) != 0) continue;
+            is_directory = S_ISDIR(info.st_mode);
+            is_file = S_ISREG(info.st_mode);
+        }
+        if (!is_directory && !is_file) {
+            continue;
+        }
+
+        std::string relative = prefix + name;
+        if (ignore && ignore->ignores(relative, is_directory)) {
+            continue;
+        }
+        out.push_back({std::move(relative), is_directory, is_directory ? ignore : nullptr});
+    }
+    closedir(listing);
+}
+
+void ProjectSearch::search_file(std::string& path, SearchPattern& pattern, std::vector<char>& scratch, std::vector<Result>& out)
+{
+    int fd = open((root + "/" + path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return;
+    }
+
+    // Mapping a file costs more than reading it, up to a few pages
+    size_t size = info.st_size;
+    void* mapped = MAP_FAILED;
+    const char* text = nullptr;
+    if (size >= MAP_BYTES) {
+        mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            text = (const char*)mapped;
+        }
+    }
+    if (!text && read_all(fd, size, scratch)) {
+        text = scratch.data();
+        size = scratch.size();
+    }
+    close(fd);
+
+    if (text) {
+        if (std::memchr(text, 0, std::min(size, BINARY_PROBE))) {
+            ++binary;
+        } else {
+            size_t before = out.size();
+            search_text(text, size, pattern, std::make_shared<const std::string>(std::move(path)), out);
+            ++searched;
+            if (out.size() > before) ++matched;
+        }
+    }
+    if (mapped != MAP_FAILED) {
+        munmap(mapped, info.st_size);
+    }
+}
+
+void ProjectSearch::search_text(const char* text, size_t size, SearchPattern& pattern, const std::shared_ptr<const std::string>& path,
+                                std::vector<Result>& out)
+{
+    std::vector<editor::SearchMatch> matches;
+    auto add = [&](size_t line, size_t col, const char* begin, const char* end) {
+        char numbers[48];   // two numbers of 20 digits at most, and a colon
+        char* at = std::to_chars(numbers, numbers + 20, line + 1).ptr;
+        *at++ = ':';
+        at = std::to_chars(at, at + 20, col + 1).ptr;
+        size_t length = std::min<size_t>(end - begin, MAX_TEXT);
+        std::string row;
+        row.reserve(path->size() + (at - numbers) + 3 + length);
+        row.append(*path).append(1, ':').append(numbers, at).append(": ").append(begin, length);
+        out.push_back({path, line, col, std::move(row)});
+    };
+    const char* end = text + size;
+
+    // Through the lines as one text, for terms that name the line break
+    if (pattern.multiline()) {
+        std::deque<std::string> rows;
+        for (const char* at = text;;) {
+            const char* stop = (const char*)std::memchr(at, '\n', end - at);
+            stop = stop ? stop : end;
+            rows.emplace_back(at, stop);
+            if (stop == end) break;
+            at = stop + 1;
+        }
+        RegexMatcher::Position from{0, 0};
+        pattern.matches_across(rows, from, rows.size(), matches);
+        for (size_t i = 0; i < matches.size(); ++i) {
+            if (i > 0 && matches[i].row == matches[i - 1].row) continue;
+            const std::string& row = rows[matches[i].row];
+            add(matches[i].row, matches[i].col, row.data(), row.data() + row.size());
+        }
+        return;
+    }
+
+    // Only the lines holding the longest text every match contains are handed to the matcher,
+    // and a term that is that text itself needs no matcher at all
+    bool plain = pattern.is_literal() && !pattern.required().empty();
+    std::string needle = plain ? pattern.required() : "";
+    for (const std::string& literal : plain ? std::vector<std::string>() : pattern.literals()) {
+        if (literal.size() > needle.size()) needle = literal;
+    }
+    LiteralFinder finder;
+    finder.assign(needle, !plain);
+
+    std::string row;
+    size_t line = 0;
+    const char* counted = text;   // the line breaks before it are counted in `line`
+    for (const char* at = text; at < end;) {
+        const char* begin = at;
+        size_t hit = 0;
+        if (!needle.empty()) {
+            hit = finder.find(text, size, at - text);
+            if (hit == std::string::npos) break;
+            const char* before = (const char*)memrchr(at, '\n', text + hit - at);
+            begin = before ? before + 1 : at;
+        }
+        const char* stop = (const char*)std::memchr(begin, '\n', end - begin);
+        stop = stop ? stop : end;
+
+        size_t col = std::string::npos;
+        if (plain) {
+            col = text + hit - begin;
+        } else {
+            row.assign(begin, stop);
+            matches.clear();
+            pattern.matches(row, 0, matches);
+            if (!matches.empty()) col = matches.front().col;
+        }
+        if (col != std::string::npos) {
+            line += std::count(counted, begin, '\n');
+            counted = begin;
+            add(line, col, begin, stop);
+        }
+        if (stop == end) break;
+        at = stop + 1;
+    }
+}
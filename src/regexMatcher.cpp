@@ -0,0 +1,966 @@
+#include "../include/regexMatcher.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    constexpr size_t MAX_INSTS = 100000;   // counted repetitions are unrolled, so they are bounded
+    constexpr int MAX_REPEAT = 1000;
+
+    std::bitset<256> byte_range(int lo, int hi)
+    {
+        std::bitset<256> set;
+        for (int b = lo; b <= hi; ++b) set.set(b);
+        return set;
+    }
+}
+
+bool RegexMatcher::is_word(int byte)
+{
+    return (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') || (byte >= '0' && byte <= '9') || byte == '_';
+}
+
+int RegexMatcher::add_node(Node node)
+{
+    nodes.push_back(std::move(node));
+    return (int)nodes.size() - 1;
+}
+
+int RegexMatcher::add_set(const std::bitset<256>& set)
+{
+    sets.push_back(set);
+    return (int)sets.size() - 1;
+}
+
+// Recursive descent over the pattern; every method returns a node, or -1 once status is set
+struct RegexMatcher::Parser {
+    RegexMatcher& matcher;
+    const std::string& pattern;
+    size_t i = 0;
+    Status status = Status::COMPILED;
+    std::string message;
+
+    bool done() const { return i >= pattern.size(); }
+
+    int fail(Status why, const std::string& text)
+    {
+        if (status == Status::COMPILED) {
+            status = why;
+            message = text;
+        }
+        return -1;
+    }
+
+    bool error(Status why, const std::string& text)
+    {
+        fail(why, text);
+        return false;
+    }
+
+    int node(Node::Kind kind)
+    {
+        Node n;
+        n.kind = kind;
+        return matcher.add_node(n);
+    }
+
+    int set_node(const std::bitset<256>& set)
+    {
+        Node n;
+        n.kind = Node::SET;
+        n.set = matcher.add_set(set);
+        return matcher.add_node(n);
+    }
+
+    int assert_node(Assertion assertion)
+    {
+        Node n;
+        n.kind = Node::ASSERT;
+        n.assertion = assertion;
+        return matcher.add_node(n);
+    }
+
+    int alternation()
+    {
+        Node n;
+        n.kind = Node::ALTERNATE;
+        n.children.push_back(concatenation());
+        while (status == Status::COMPILED && !done() && pattern[i] == '|') {
+            ++i;
+            n.children.push_back(concatenation());
+        }
+        if (status != Status::COMPILED) return -1;
+        return n.children.size() == 1 ? n.children[0] : matcher.add_node(n);
+    }
+
+    int concatenation()
+    {
+        Node n;
+        n.kind = Node::CONCAT;
+        while (status == Status::COMPILED && !done() && pattern[i] != '|' && pattern[i] != ')') {
+            int item = repetition();
+            if (item < 0) return -1;
+            n.children.push_back(item);
+        }
+        if (n.children.empty()) return node(Node::EMPTY);
+        return n.children.size() == 1 ? n.children[0] : matcher.add_node(n);
+    }
+
+    // {n}, {n,} or {n,m} at i; anything else is a literal '{'
+    bool bounds(int& min, int& max)
+    {
+        size_t j = i + 1;
+        auto number = [&](int& value) {
+            size_t first = j;
+            long long n = 0;
+            while (j < pattern.size() && isdigit((unsigned char)pattern[j])) {
+                n = std::min<long long>(n * 10 + (pattern[j++] - '0'), INT32_MAX);
+            }
+            value = (int)n;
+            return j > first;
+        };
+        if (!number(min)) return false;
+        max = min;
+        if (j < pattern.size() && pattern[j] == ',') {
+            ++j;
+            if (!number(max)) max = -1;
+        }
+        if (j >= pattern.size() || pattern[j] != '}') return false;
+        i = j + 1;
+        if ((max >= 0 && max < min) || min > MAX_REPEAT || max > MAX_REPEAT) {
+            fail(Status::SYNTAX_ERROR, "Invalid repetition count");
+        }
+        return true;
+    }
+
+    int repetition()
+    {
+        int item = atom();
+        if (item < 0 || done()) return item;
+
+        int min, max;
+        char c = pattern[i];
+        if (c == '*' || c == '+' || c == '?') {
+            min = c == '+' ? 1 : 0;
+            max = c == '?' ? 1 : -1;
+            ++i;
+        } else if (c != '{' || !bounds(min, max)) {
+            return item;
+        }
+        if (status != Status::COMPILED) return -1;
+        if (matcher.nodes[item].kind == Node::ASSERT) {
+            return fail(Status::SYNTAX_ERROR, "Nothing to repeat");
+        }
+
+        Node n;
+        n.kind = Node::REPEAT;
+        n.min = min;
+        n.max = max;
+        n.children.push_back(item);
+        if (!done() && pattern[i] == '?') {
+            n.greedy = false;
+            ++i;
+        }
+        return matcher.add_node(n);
+    }
+
+    int atom()
+    {
+        char c = pattern[i++];
+        switch (c) {
+            case '(': {
+                if (pattern.compare(i, 2, "?:") == 0) {
+                    i += 2;
+                } else if (!done() && pattern[i] == '?') {
+                    return fail(Status::UNSUPPORTED, "Lookarounds are not supported");
+                }
+                int inner = alternation();
+                if (inner < 0) return -1;
+                if (done() || pattern[i] != ')') return fail(Status::SYNTAX_ERROR, "Missing )");
+                ++i;
+                if (matcher.nodes[inner].kind == Node::ASSERT) {
+                    // A group around an assertion can be repeated, the bare assertion cannot
+                    Node group;
+                    group.kind = Node::CONCAT;
+                    group.children.push_back(inner);
+                    return matcher.add_node(group);
+                }
+                return inner;
+            }
+            case '[':
+                return char_class();
+            case '.': {
+                std::bitset<256> any;
+                any.set();
+                any.reset('\n');
+                any.reset('\r');
+                return set_node(any);
+            }
+            case '^':
+                return assert_node(BEGIN_TEXT);
+            case '$':
+                return assert_node(END_TEXT);
+            case '*': case '+': case '?':
+                return fail(Status::SYNTAX_ERROR, "Nothing to repeat");
+            case '{': {
+                int min, max;
+                --i;
+                if (bounds(min, max)) return fail(Status::SYNTAX_ERROR, "Nothing to repeat");
+                ++i;
+                break;
+            }
+            case '\\':
+                return escape();
+        }
+        std::bitset<256> one;
+        one.set((unsigned char)c);
+        return set_node(one);
+    }
+
+    int escape()
+    {
+        if (done()) return fail(Status::SYNTAX_ERROR, "Trailing backslash");
+        char c = pattern[i];
+        if (c == 'b' || c == 'B') {
+            ++i;
+            return assert_node(c == 'b' ? WORD_BOUNDARY : NOT_WORD_BOUNDARY);
+        }
+        if (c >= '1' && c <= '9') {
+            return fail(Status::UNSUPPORTED, "Backreferences are not supported");
+        }
+        std::bitset<256> set;
+        int byte;
+        if (!escaped(set, byte)) return -1;
+        if (byte >= 0) set.set(byte);
+        return set_node(set);
+    }
+
+    // The escape after a backslash: a class (\d, \w, \s...) into `set`, or one byte
+    bool escaped(std::bitset<256>& set, int& byte)
+    {
+        char c = pattern[i++];
+        byte = -1;
+        switch (c) {
+            case 'd': case 'D':
+                set = byte_range('0', '9');
+                break;
+            case 'w': case 'W':
+                set = byte_range('a', 'z') | byte_range('A', 'Z') | byte_range('0', '9');
+                set.set('_');
+                break;
+            case 's': case 'S':
+                for (char space : std::string(" \t\n\r\f\v")) set.set((unsigned char)space);
+                break;
+            case 'n': byte = '\n'; matcher.multiline = true; return true;
+            case 't': byte = '\t'; return true;
+            case 'r': byte = '\r'; return true;
+            case 'f': byte = '\f'; return true;
+            case 'v': byte = '\v'; return true;
+            case '0': byte = 0; return true;
+            case 'b': byte = '\b'; return true;   // in a class; \b outside is an assertion
+            case 'x': {
+                if (i + 2 > pattern.size() || !isxdigit((unsigned char)pattern[i]) || !isxdigit((unsigned char)pattern[i + 1])) {
+                    return error(Status::SYNTAX_ERROR, "Invalid \\x escape");
+                }
+                byte = std::stoi(pattern.substr(i, 2), nullptr, 16);
+                i += 2;
+                return true;
+            }
+            case 'c': {
+                if (done() || !isalpha((unsigned char)pattern[i])) {
+                    return error(Status::SYNTAX_ERROR, "Invalid \\c escape");
+                }
+                byte = pattern[i++] % 32;
+                return true;
+            }
+            case 'u':
+                return error(Status::UNSUPPORTED, "\\u escapes are not supported");
+            default:
+                byte = (unsigned char)c;
+                return true;
+        }
+        if (isupper((unsigned char)c)) set.flip();
+        return true;
+    }
+
+    int char_class()
+    {
+        std::bitset<256> set;
+        bool negate = !done() && pattern[i] == '^';
+        if (negate) ++i;
+
+        // One member at i: a byte, or a class escape (byte -1)
+        auto member = [&](std::bitset<256>& item, int& byte) {
+            if (pattern[i] != '\\') {
+                byte = (unsigned char)pattern[i++];
+                return true;
+            }
+            ++i;
+            if (done()) return error(Status::SYNTAX_ERROR, "Missing ]");
+            return escaped(item, byte);
+        };
+
+        while (true) {
+            if (done()) return fail(Status::SYNTAX_ERROR, "Missing ]");
+            if (pattern[i] == ']') {
+                ++i;
+                break;
+            }
+            std::bitset<256> item;
+            int lo;
+            if (!member(item, lo)) return -1;
+            if (lo >= 0 && i + 1 < pattern.size() && pattern[i] == '-' && pattern[i + 1] != ']') {
+                ++i;
+                std::bitset<256> ignored;
+                int hi;
+                if (!member(ignored, hi)) return -1;
+                if (hi < lo) return fail(Status::SYNTAX_ERROR, "Invalid range in []");
+                set |= byte_range(lo, hi);
+            } else if (lo >= 0) {
+                set.set(lo);
+            } else {
+                set |= item;
+            }
+        }
+        if (negate) set.flip();
+        return set_node(set);
+    }
+};
+
+RegexMatcher::Status RegexMatcher::compile(const std::string& pattern)
+{
+    nodes.clear();
+    sets.clear();
+    prefix.clear();
+    literals.clear();
+    finder.assign("");
+    folded = false;
+    literal = false;
+    multiline = false;
+    ready = false;
+    message.clear();
+
+    Parser parser{*this, pattern};
+    int root = parser.alternation();
+    if (parser.status == Status::COMPILED && !parser.done()) {
+        parser.fail(Status::SYNTAX_ERROR, "Unmatched )");
+    }
+    if (parser.status != Status::COMPILED) {
+        message = parser.message;
+        return parser.status;
+    }
+
+    find_prefix(root);
+    if (multiline) {
+        // Rows read one after the other need the automaton; the finder only skips within a row
+        literal = false;
+        std::string needle = finder.needle().substr(0, finder.needle().find('\n'));
+        finder.assign(needle, folded);
+        if (!folded) prefix = needle;
+    }
+    std::string run;
+    find_literals(root, run);
+    if (!run.empty()) literals.push_back(run);
+    if (!literal && (!build(forward, root, false) || !build(backward, root, true))) {
+        return Status::UNSUPPORTED;
+    }
+    ready = true;
+    return Status::COMPILED;
+}
+
+void RegexMatcher::find_prefix(int root)
+{
+    // A byte, or a letter in both cases ([Ff]) stored in lower case
+    auto element = [&](int id, char& byte, bool& pair) {
+        const Node& node = nodes[id];
+        if (node.kind != Node::SET) return false;
+        const std::bitset<256>& set = sets[node.set];
+        if (set.count() == 1) {
+            for (int b = 0; b < 256; ++b) {
+                if (set[b]) byte = (char)b;
+            }
+            pair = false;
+            return true;
+        }
+        for (int b = 'a'; set.count() == 2 && b <= 'z'; ++b) {
+            if (set[b] && set[b ^ 0x20]) {
+                byte = (char)b;
+                pair = true;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    const Node& node = nodes[root];
+    if (node.kind == Node::EMPTY) {
+        literal = true;
+        return;
+    }
+    std::vector<int> parts = node.kind == Node::CONCAT ? node.children : std::vector<int>{root};
+
+    // The letters all match in their own case or all in both; the first one decides
+    std::string needle;
+    int fold = -1;
+    size_t k = 0;
+    for (char byte = 0; k < parts.size(); ++k) {
+        bool pair;
+        if (!element(parts[k], byte, pair)) break;
+        bool letter = ((byte | 0x20) >= 'a' && (byte | 0x20) <= 'z');
+        if (letter && fold < 0) {
+            fold = pair;
+        } else if (letter && fold != (int)pair) {
+            break;
+        }
+        needle += byte;
+    }
+    literal = k == parts.size();
+    folded = fold == 1;
+    finder.assign(needle, folded);
+    if (!folded) {
+        prefix = needle;
+    }
+}
+
+void RegexMatcher::find_literals(int id, std::string& run)
+{
+    auto flush = [&](std::string& text) {
+        if (!text.empty()) literals.push_back(text);
+        text.clear();
+    };
+
+    const Node& node = nodes[id];
+    switch (node.kind) {
+        case Node::SET: {
+            // A byte, or a letter in both cases; a newline ends the text as rows do
+            const std::bitset<256>& set = sets[node.set];
+            int byte = -1;
+            for (int b = 0; b < 256 && set.count() <= 2; ++b) {
+                if (set[b] && (set.count() == 1 || (std::isalpha(b) && set[b ^ 0x20]))) {
+                    byte = std::tolower(b);
+                    break;
+                }
+            }
+            if (byte < 0 || byte == '\n') {
+                flush(run);
+            } else {
+                run += (char)byte;
+            }
+            break;
+        }
+        case Node::EMPTY:
+        case Node::ASSERT:
+            break;   // takes no text: what is on both sides is contiguous
+        case Node::CONCAT:
+            for (int child : node.children) find_literals(child, run);
+            break;
+        case Node::REPEAT:
+            if (node.min == 1 && node.max == 1) {
+                find_literals(node.children[0], run);
+                break;
+            }
+            flush(run);
+            if (node.min >= 1) {
+                // Each repetition holds the literals of the body, but not next to what is around it
+                std::string inner;
+                find_literals(node.children[0], inner);
+                flush(inner);
+            }
+            break;
+        case Node::ALTERNATE:
+            flush(run);
+            break;
+    }
+}
+
+bool RegexMatcher::emit(Dfa& dfa, int id, bool reversed, Fragment& fragment)
+{
+    std::vector<Inst>& insts = dfa.insts;
+    if (insts.size() > MAX_INSTS) {
+        message = "Pattern is too large";
+        return false;
+    }
+
+    auto add = [&](Inst::Op op) {
+        Inst inst;
+        inst.op = op;
+        insts.push_back(inst);
+        return (int)insts.size() - 1;
+    };
+    auto patch = [&](const std::vector<int>& holes, int target) {
+        for (int hole : holes) {
+            (hole & 1 ? insts[hole / 2].out1 : insts[hole / 2].out) = target;
+        }
+    };
+    // Appends b to a (a.start < 0: a is empty so far)
+    auto chain = [&](Fragment& a, Fragment& b) {
+        if (a.start < 0) {
+            a = std::move(b);
+            return;
+        }
+        patch(a.holes, b.start);
+        a.holes = std::move(b.holes);
+    };
+    // A split that takes `body` or skips it, by priority
+    auto optional = [&](Fragment& body, bool greedy) {
+        int pc = add(Inst::SPLIT);
+        (greedy ? insts[pc].out : insts[pc].out1) = body.start;
+        body.holes.push_back(greedy ? pc * 2 + 1 : pc * 2);
+        body.start = pc;
+        return pc;
+    };
+
+    const Node& node = nodes[id];
+    switch (node.kind) {
+        case Node::EMPTY:
+        case Node::SET:
+        case Node::ASSERT: {
+            int pc = add(node.kind == Node::SET ? Inst::SET : node.kind == Node::ASSERT ? Inst::ASSERT : Inst::EMPTY);
+            insts[pc].set = node.set;
+            insts[pc].assertion = node.assertion;
+            if (reversed && node.kind == Node::ASSERT) {
+                // Read backwards, the start of the text is at the end
+                if (node.assertion == BEGIN_TEXT) insts[pc].assertion = END_TEXT;
+                if (node.assertion == END_TEXT) insts[pc].assertion = BEGIN_TEXT;
+            }
+            fragment = {pc, {pc * 2}};
+            return true;
+        }
+        case Node::CONCAT: {
+            fragment = {-1, {}};
+            size_t count = node.children.size();
+            for (size_t k = 0; k < count; ++k) {
+                Fragment part;
+                if (!emit(dfa, node.children[reversed ? count - 1 - k : k], reversed, part)) return false;
+                chain(fragment, part);
+            }
+            return true;
+        }
+        case Node::ALTERNATE: {
+            std::vector<Fragment> choices(node.children.size());
+            for (size_t k = 0; k < choices.size(); ++k) {
+                if (!emit(dfa, node.children[k], reversed, choices[k])) return false;
+            }
+            fragment = std::move(choices.back());
+            for (size_t k = choices.size() - 1; k-- > 0;) {
+                int pc = add(Inst::SPLIT);
+                insts[pc].out = choices[k].start;
+                insts[pc].out1 = fragment.start;
+                fragment.holes.insert(fragment.holes.end(), choices[k].holes.begin(), choices[k].holes.end());
+                fragment.start = pc;
+            }
+            return true;
+        }
+        case Node::REPEAT: {
+            // x{min,max}: min copies of x, then a loop, or (max - min) nested optional copies
+            int child = node.children[0];
+            fragment = {-1, {}};
+            for (int k = 0; k < node.min; ++k) {
+                Fragment copy;
+                if (!emit(dfa, child, reversed, copy)) return false;
+                chain(fragment, copy);
+            }
+            if (node.max < 0) {
+                Fragment body;
+                if (!emit(dfa, child, reversed, body)) return false;
+                std::vector<int> back = std::move(body.holes);
+                body.holes.clear();
+                int pc = optional(body, node.greedy);
+                patch(back, pc);
+                chain(fragment, body);
+            } else if (node.max > node.min) {
+                Fragment tail{-1, {}};
+                for (int k = node.max - node.min; k-- > 0;) {
+                    Fragment body;
+                    if (!emit(dfa, child, reversed, body)) return false;
+                    if (tail.start >= 0) {
+                        patch(body.holes, tail.start);
+                        body.holes = std::move(tail.holes);
+                    }
+                    optional(body, node.greedy);
+                    tail = std::move(body);
+                }
+                chain(fragment, tail);
+            }
+            if (fragment.start < 0) {
+                int pc = add(Inst::EMPTY);
+                fragment = {pc, {pc * 2}};
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool RegexMatcher::build(Dfa& dfa, int root, bool reversed)
+{
+    dfa.insts.clear();
+    Fragment body;
+    if (!emit(dfa, root, reversed, body)) {
+        return false;
+    }
+    Inst match;
+    match.op = Inst::MATCH;
+    dfa.insts.push_back(match);
+    for (int hole : body.holes) {
+        (hole & 1 ? dfa.insts[hole / 2].out1 : dfa.insts[hole / 2].out) = (int)dfa.insts.size() - 1;
+    }
+
+    dfa.start_pc = body.start;
+    dfa.longest = reversed;
+    if (!reversed) {
+        // Unanchored: a lazy `.*` ahead of the pattern, so earlier starts come first
+        std::bitset<256> any;
+        any.set();
+        int loop_pc = (int)dfa.insts.size();
+        Inst loop, skip;
+        loop.op = Inst::SPLIT;
+        loop.out = body.start;
+        loop.out1 = loop_pc + 1;
+        skip.op = Inst::SET;
+        skip.set = add_set(any);
+        skip.out = loop_pc;
+        dfa.insts.push_back(loop);
+        dfa.insts.push_back(skip);
+        dfa.start_pc = loop_pc;
+    }
+
+    // Bytes that every set of the program, \b, and the line ends of ^ and $ treat the same share a class
+    std::vector<const std::bitset<256>*> used;
+    for (const Inst& inst : dfa.insts) {
+        if (inst.op == Inst::SET) used.push_back(&sets[inst.set]);
+    }
+    dfa.representative.assign(1, 0);
+    for (int b = 1; b < 256; ++b) {
+        bool split = is_word(b) != is_word(b - 1) || b == '\n' || b == '\n' + 1;
+        for (size_t k = 0; k < used.size() && !split; ++k) {
+            split = (*used[k])[b] != (*used[k])[b - 1];
+        }
+        if (split) dfa.representative.push_back((uint8_t)b);
+        dfa.byte_class[b] = (uint16_t)(dfa.representative.size() - 1);
+    }
+    dfa.stride = dfa.representative.size() + 1;
+    dfa.seen.assign(dfa.insts.size(), 0);
+    dfa.generation = 0;
+    dfa.clear();
+    return true;
+}
+
+void RegexMatcher::Dfa::clear()
+{
+    states.clear();
+    next.clear();
+    index.clear();
+    std::fill(std::begin(starts), std::end(starts), -1);
+    resets++;
+    dead = add({}, 0);
+}
+
+int32_t RegexMatcher::Dfa::add(const std::vector<int>& pcs, uint8_t flags)
+{
+    std::string key(1, (char)flags);
+    key.append(reinterpret_cast<const char*>(pcs.data()), pcs.size() * sizeof(int));
+    auto found = index.find(key);
+    if (found != index.end()) {
+        return found->second;
+    }
+    if (states.size() >= MAX_STATES) {
+        clear();
+    }
+    states.push_back({pcs, flags});
+    next.resize(next.size() + stride, UNKNOWN);
+    int32_t id = (int32_t)states.size() - 1;
+    index.emplace(std::move(key), id);
+    return id;
+}
+
+int32_t RegexMatcher::Dfa::start(uint8_t flags)
+{
+    if (starts[flags] < 0) {
+        int32_t state = add({start_pc}, flags);
+        starts[flags] = state;
+    }
+    return starts[flags];
+}
+
+bool RegexMatcher::Dfa::is_start(int32_t state) const
+{
+    return state == starts[0] || state == starts[1] || state == starts[2] || state == starts[3];
+}
+
+void RegexMatcher::Dfa::follow(int pc, uint8_t flags, int byte)
+{
+    bool after_word = flags & AFTER_WORD;
+    bool before_word = byte >= 0 && is_word(byte);
+
+    stack.push_back(pc);
+    while (!stack.empty()) {
+        int at = stack.back();
+        stack.pop_back();
+        if (seen[at] == generation) continue;
+        seen[at] = generation;
+
+        const Inst& inst = insts[at];
+        switch (inst.op) {
+            case Inst::SPLIT:
+                stack.push_back(inst.out1);
+                stack.push_back(inst.out);
+                break;
+            case Inst::EMPTY:
+                stack.push_back(inst.out);
+                break;
+            case Inst::ASSERT: {
+                bool holds = false;
+                switch (inst.assertion) {
+                    case BEGIN_TEXT: holds = flags & AT_BEGIN; break;
+                    case END_TEXT: holds = byte < 0 || byte == '\n'; break;
+                    case WORD_BOUNDARY: holds = after_word != before_word; break;
+                    case NOT_WORD_BOUNDARY: holds = after_word == before_word; break;
+                }
+                if (holds) stack.push_back(inst.out);
+                break;
+            }
+            case Inst::SET:
+            case Inst::MATCH:
+                list.push_back(at);
+                break;
+        }
+    }
+}
+
+int32_t RegexMatcher::Dfa::step(int32_t state, size_t cls, const std::vector<std::bitset<256>>& sets)
+{
+    int byte = cls + 1 == stride ? -1 : representative[cls];
+    auto next_generation = [&]() {
+        if (++generation == 0) {
+            std::fill(seen.begin(), seen.end(), 0);
+            generation = 1;
+        }
+    };
+
+    // The threads' empty moves, now that the next byte is known
+    next_generation();
+    list.clear();
+    uint8_t flags = states[state].flags;
+    for (int pc : states[state].pcs) {
+        follow(pc, flags, byte);
+    }
+
+    bool matched = false;
+    moved.clear();
+    next_generation();
+    for (int pc : list) {
+        const Inst& inst = insts[pc];
+        if (inst.op == Inst::MATCH) {
+            matched = true;
+            if (!longest) break;   // the threads after it have lower priority
+            continue;
+        }
+        if (byte >= 0 && sets[inst.set][byte] && seen[inst.out] != generation) {
+            seen[inst.out] = generation;
+            moved.push_back(inst.out);
+        }
+    }
+
+    // After a line break, as at the start of the text, ^ holds
+    uint8_t target_flags = moved.empty() ? 0 : byte == '\n' ? AT_BEGIN : byte >= 0 && is_word(byte) ? AFTER_WORD : 0;
+    size_t before = resets;
+    int32_t target = add(moved, target_flags);
+    int32_t value = target | (matched ? MATCH_BIT : 0);
+    if (resets == before) {
+        next[state * stride + cls] = value;
+    }
+    return value;
+}
+
+bool RegexMatcher::search(const std::string& text, size_t from, size_t& start, size_t& end)
+{
+    if (!ready || from > text.size()) {
+        return false;
+    }
+    if (literal) {
+        size_t at = finder.find(text, from);
+        if (at == std::string::npos) return false;
+        start = at;
+        end = at + finder.needle().size();
+        return true;
+    }
+
+    const size_t size = text.size();
+    auto after_word = [&](size_t pos) { return pos > 0 && is_word((unsigned char)text[pos - 1]); };
+
+    // Forward, from `from`: where the leftmost match ends
+    int32_t state = forward.start((from == 0 ? Dfa::AT_BEGIN : 0) | (after_word(from) ? Dfa::AFTER_WORD : 0));
+    bool found = false;
+    size_t match_end = 0;
+    size_t i = from;
+    for (; i < size; ++i) {
+        if (!finder.needle().empty() && forward.is_start(state)) {
+            // Nothing started yet: no match can start before the prefix
+            size_t at = finder.find(text, i);
+            if (at == std::string::npos) return false;
+            if (at != i) {
+                i = at;
+                state = forward.start(after_word(i) ? Dfa::AFTER_WORD : 0);
+            }
+        }
+        int32_t value = forward.move(state, forward.byte_class[(unsigned char)text[i]], sets);
+        if (value & Dfa::MATCH_BIT) {
+            found = true;
+            match_end = i;
+        }
+        state = value & ~Dfa::MATCH_BIT;
+        if (state == forward.dead) break;
+    }
+    if (i == size && forward.move(state, forward.stride - 1, sets) & Dfa::MATCH_BIT) {
+        found = true;
+        match_end = size;
+    }
+    if (!found) {
+        return false;
+    }
+
+    // Backward from there, with the reversed pattern: the earliest start not before `from`
+    state = backward.start((match_end == size ? Dfa::AT_BEGIN : 0) |
+                           (match_end < size && is_word((unsigned char)text[match_end]) ? Dfa::AFTER_WORD : 0));
+    size_t match_start = match_end;
+    size_t j = match_end;
+    for (; j > from; --j) {
+        int32_t value = backward.move(state, backward.byte_class[(unsigned char)text[j - 1]], sets);
+        if (value & Dfa::MATCH_BIT) match_start = j;
+        state = value & ~Dfa::MATCH_BIT;
+        if (state == backward.dead) break;
+    }
+    if (j == from) {
+        size_t cls = from == 0 ? backward.stride - 1 : backward.byte_class[(unsigned char)text[from - 1]];
+        if (backward.move(state, cls, sets) & Dfa::MATCH_BIT) match_start = from;
+    }
+
+    start = match_start;
+    end = match_end;
+    return true;
+}
+
+bool RegexMatcher::search_rows(const std::deque<std::string>& rows, Position& from, size_t until, Position& start, Position& end)
+{
+    if (!ready || from.row >= rows.size()) {
+        from = {rows.size(), 0};
+        return false;
+    }
+    const size_t last = rows.size() - 1;
+    from.col = std::min(from.col, rows[from.row].size());
+
+    auto after_word = [&](size_t row, size_t col) { return col > 0 && is_word((unsigned char)rows[row][col - 1]); };
+    auto flags_at = [&](size_t row, size_t col) {
+        return (col == 0 ? Dfa::AT_BEGIN : 0) | (after_word(row, col) ? Dfa::AFTER_WORD : 0);
+    };
+
+    // Forward, row after row: where the leftmost match ends
+    size_t row = from.row, col = from.col;
+    int32_t state = forward.start(flags_at(row, col));
+    bool found = false;
+    Position match_end{0, 0};
+    while (true) {
+        const std::string& line = rows[row];
+        const size_t size = line.size();
+        bool skipped = false;
+        for (; col < size; ++col) {
+            if (!found && forward.is_start(state)) {
+                // Nothing started yet: stop at `until`, and skip to the prefix within the row
+                if (row >= until) {
+                    from = {row, col};
+                    return false;
+                }
+                if (!finder.needle().empty()) {
+                    size_t at = finder.find(line, col);
+                    if (at == std::string::npos) {
+                        skipped = true;
+                        break;
+                    }
+                    if (at != col) {
+                        col = at;
+                        state = forward.start(after_word(row, col) ? Dfa::AFTER_WORD : 0);
+                    }
+                }
+            }
+            int32_t value = forward.move(state, forward.byte_class[(unsigned char)line[col]], sets);
+            if (value & Dfa::MATCH_BIT) {
+                found = true;
+                match_end = {row, col};
+            }
+            state = value & ~Dfa::MATCH_BIT;
+            if (state == forward.dead) break;
+        }
+        if (state == forward.dead) break;
+        if (skipped) {
+            // No match starts in the rest of the row, nor at its line break
+            if (row == last) break;
+            ++row;
+            col = 0;
+            state = forward.start(Dfa::AT_BEGIN);
+            continue;
+        }
+
+        // The line break, or the end of the text
+        if (!found && forward.is_start(state) && row >= until) {
+            from = {row, col};
+            return false;
+        }
+        int32_t value = forward.move(state, row < last ? forward.byte_class[(unsigned char)'\n'] : forward.stride - 1, sets);
+        if (value & Dfa::MATCH_BIT) {
+            found = true;
+            match_end = {row, size};
+        }
+        state = value & ~Dfa::MATCH_BIT;
+        if (state == forward.dead || row == last) break;
+        ++row;
+        col = 0;
+    }
+    if (!found) {
+        from = {rows.size(), 0};
+        return false;
+    }
+
+    // Backward from there, with the reversed pattern: the earliest start not before `from`
+    const std::string& end_line = rows[match_end.row];
+    state = backward.start((match_end.col == end_line.size() ? Dfa::AT_BEGIN : 0) |
+                           (match_end.col < end_line.size() && is_word((unsigned char)end_line[match_end.col]) ? Dfa::AFTER_WORD : 0));
+    Position match_start = match_end;
+    row = match_end.row;
+    col = match_end.col;
+    bool stopped = false;
+    while (row > from.row || col > from.col) {
+        size_t cls = col > 0 ? backward.byte_class[(unsigned char)rows[row][col - 1]] : backward.byte_class[(unsigned char)'\n'];
+        int32_t value = backward.move(state, cls, sets);
+        if (value & Dfa::MATCH_BIT) match_start = {row, col};
+        state = value & ~Dfa::MATCH_BIT;
+        if (col > 0) {
+            --col;
+        } else {
+            --row;
+            col = rows[row].size();
+        }
+        if (state == backward.dead) {
+            stopped = true;
+            break;
+        }
+    }
+    if (!stopped) {
+        size_t cls = row == 0 && col == 0 ? backward.stride - 1
+                     : col > 0           ? backward.byte_class[(unsigned char)rows[row][col - 1]]
+                                         : backward.byte_class[(unsigned char)'\n'];
+        if (backward.move(state, cls, sets) & Dfa::MATCH_BIT) match_start = from;
+    }
+
+    // The next search goes on from the end, a byte further after an empty match
+    start = match_start;
+    end = match_end;
+    from = match_end;
+    if (match_start.row == match_end.row && match_start.col == match_end.col) {
+        if (from.col < rows[from.row].size()) {
+            ++from.col;
+        } else {
+            from = {from.row + 1, 0};
+        }
+    }
+    return true;
+}
@@ -1,9 +1,70 @@
 #include "../include/screen.hpp"
 #include "../include/globals/mvimResources.h"
 #include "../include/bufferManager.hpp"
+#include "../include/editor.hpp"
+#include "../include/syntax.hpp"
+#include "../include/editorStats.hpp"
+#include "../include/softWrap.hpp"
+#include "../include/syntaxState.hpp"
+#include "../include/backgroundHighlighter.hpp"
 #include <ncurses.h>
+#include <chrono>
 #include <string>
 
+// Columns styled on each side of the window when a long row is only styled around it
+static constexpr size_t CLIP_MARGIN = 256;
+
+// Style signature of a row drawn plain because the frame ran out of time:
+// it never matches a styled row, so the next frame styles it
+static constexpr uint64_t DEFERRED_STYLE = 1;
+
+// FNV-1a step, used to fingerprint the search matches drawn on a row
+static uint64_t fnv_mix(uint64_t hash, uint64_t value)
+{
+  return (hash ^ value) * 1099511628211ULL;
+}
+
+static uint64_t overlay_signature(const std::vector<editor::SearchMatch>& matches)
+{
+  uint64_t hash = 1469598103934665603ULL;
+  for (const auto& occ : matches)
+  {
+    hash = fnv_mix(hash, (uint64_t)occ.col << 32 | (uint32_t)occ.length);
+  }
+  return hash;
+}
+
+// Build the cells of a row: the line number gutter followed by the visible text,
+// padded with blanks to the full width so no erase is needed before printing it
+static void build_row(RenderCache::Line& line, const std::string& text, const std::vector<color>* colors)
+{
+  line.cells.clear();
+
+  // The wrapped part of a row gets no line number
+  char number[32];
+  int number_len = line.continuation ? 0 : snprintf(number, sizeof(number), "%zu", line.row + 1);
+  for (int c = 0; c < span + 1; ++c)
+  {
+    chtype ch = c < number_len ? number[c] : ' ';
+    line.cells.push_back(ch | COLOR_PAIR(numberRowsColor));
+  }
+
+  // if text.length() <= starting_col the string is not visible
+  if (text.length() > line.starting_col)
+  {
+    size_t len = std::min(text.length() - line.starting_col, line.width);
+    for (size_t c = line.starting_col; c < line.starting_col + len; ++c)
+    {
+      unsigned char ch = text[c];
+      if (ch < ' ') ch = ' ';   // keep one cell per character (tabs, control codes)
+      color pair = colors ? (*colors)[c] : textColor;
+      line.cells.push_back(ch | COLOR_PAIR(pair));
+    }
+  }
+
+  line.cells.resize(span + 1 + line.width, ' ' | COLOR_PAIR(textColor));
+}
+
 Screen::~Screen()
 {
 }
@@ -52,53 +113,161 @@ void Screen::draw_rectangle(int y1, int x1, int y2, int x2)
 
 void Screen::print_buffer()
 {
-  for (int i = 0; (i + starting_row) < buffer.getSize() && i < max_row; i++)
+  Surface& target = surface();
+  RenderCache& cache = render_caches[headless ? (const void*)headless : (const void*)pointed_window];
+  size_t rows = std::min<size_t>(max_row, target.rows());
+
+  SoftWrap& wrap = SoftWrap::instance();
+  if (soft_wrap) wrap.sync(buffer, max_col);
+  size_t top = soft_wrap ? wrap.line_of(starting_row) : starting_row;
+
+  // Small vertical scroll: shift the rows already on the window, so only the
+  // newly exposed ones are built, and let ncurses move them with the terminal
+  // scroll region (idlok) instead of repainting them.
+  long delta = (long)top - (long)cache.top_row;
+  if (cache.drawn && delta != 0 && (size_t)std::labs(delta) <= rows / 2 &&
+      starting_col == cache.left_col && soft_wrap == cache.wrapped)
   {
-    wattron(pointed_window, COLOR_PAIR(numberRowsColor));
-    mvwprintw(pointed_window, i, 0, "%zu", i + starting_row + 1);
-    wattroff(pointed_window, COLOR_PAIR(numberRowsColor));
-    
-    std::string curr_row = buffer[i + starting_row];
+    target.scroll_rows(rows, delta);
+    cache.shift_rows(delta, rows);
+    EditorStats::instance().rows_scrolled += rows - std::labs(delta);
+  }
+  cache.drawn = true;
+  cache.wrapped = soft_wrap;
+  cache.top_row = top;
+  cache.left_col = starting_col;
+
+  const Language* lang = SyntaxHighlighter::instance().getCurrentLanguage();
+  std::vector<std::vector<editor::SearchMatch>> matches = editor::find::visible_occurrences(starting_row, rows);
+  std::vector<color> colors;
+  bool in_comment = SyntaxStateCache::instance().state_before(buffer, starting_row);
+  BackgroundHighlighter& highlighter = BackgroundHighlighter::instance();
+  size_t y = 0;
+
+  // Rows styled in the frame stop when the budget is spent: the rest are
+  // drawn plain, and styled by the next frames (or the background thread)
+  auto budget_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(highlight_budget_ms);
+  bool over_budget = false;
+
+  for (size_t row = starting_row; row < (size_t)buffer.getSize() && y < rows; row++)
+  {
+    const std::string& curr_row = buffer[row];
+    uint64_t style = lang ? ((uint64_t)(uintptr_t)lang << 1 | in_comment) : 0;
+    uint64_t overlay = overlay_signature(matches[row - starting_row]);
+    bool too_long = lang && curr_row.length() > max_highlight_length;
+    bool deferred = false;
+
+    // A wrapped row takes several screen lines, all styled from one pass
+    size_t segments = soft_wrap ? wrap.height(curr_row.length()) : 1;
+    bool styled = false;
+    bool end_state = in_comment;
+    // Rows too long to highlight and without a match skip the colors altogether
+    bool plain = too_long && matches[row - starting_row].empty();
+
+    for (size_t segment = 0; segment < segments && y < rows; segment++, y++)
+    {
+      size_t first_col = soft_wrap ? segment * max_col : starting_col;
+      RenderCache::Line& line = cache.slot(y);
+      if (!RenderCache::matches(line, row, curr_row, first_col, max_col, style, overlay, segment > 0))
+      {
+        if (!styled)
+        {
+          end_state = in_comment;
+          if (too_long)
+          {
+            // Drawn plain but for its search matches; only its comment state is followed
+            if (!plain)
+            {
+              colors.assign(curr_row.length(), textColor);
+            }
+            end_state = SyntaxStateCache::instance().state_before(buffer, row + 1);
+            if (long_row_notice != buffer.getId())
+            {
+              long_row_notice = buffer.getId();
+              set_status_message("[INFO] Rows over " + std::to_string(max_highlight_length) +
+                                 " characters are shown without highlighting", 2);
+            }
+          }
+          // Rows styled ahead by the background thread are only copied
+          else if (!highlighter.lookup(buffer, row, in_comment, colors, end_state))
+          {
+            colors.assign(curr_row.length(), textColor);
+            if (over_budget)
+            {
+              end_state = SyntaxStateCache::instance().state_before(buffer, row + 1);
+              deferred = true;
+              EditorStats::instance().rows_deferred++;
+            }
+            else
+            {
+              // Scrolled sideways along a long row: only style around the window
+              size_t from = 0;
+              size_t to = curr_row.length();
+              if (!soft_wrap)
+              {
+                from = starting_col > CLIP_MARGIN ? starting_col - CLIP_MARGIN : 0;
+                to = std::min(to, starting_col + max_col + CLIP_MARGIN);
+              }
+              editor::visual::style_keywords(curr_row, colors, end_state, from, to);
+              if (from == 0 && to == curr_row.length())
+              {
+                highlighter.store(buffer, row, in_comment, colors, end_state);
+              }
+              over_budget = std::chrono::steady_clock::now() > budget_end;
+            }
+          }
+          if (!plain)
+          {
+            editor::find::style_searched_word(matches[row - starting_row], colors);
+          }
+          styled = true;
+        }
 
-    // if curr_row.length() <= starting_col the string is not visible
-    if(curr_row.length() > starting_col){ 
-      std::string row2print = curr_row.substr(starting_col, max_col);
-      wattron(pointed_window, COLOR_PAIR(textColor));
-      mvwprintw(pointed_window, i, span + 1, "%s", row2print.c_str());
-      wattroff(pointed_window, COLOR_PAIR(textColor));
-    } 
+        line.valid = true;
+        line.row = row;
+        line.starting_col = first_col;
+        line.width = max_col;
+        line.style = deferred ? DEFERRED_STYLE : style;
+        line.overlay = overlay;
+        line.end_state = end_state;
+        line.continuation = segment > 0;
+        line.text = curr_row;
+        build_row(line, curr_row, plain ? nullptr : &colors);
+        EditorStats::instance().rows_built++;
+      }
+
+      end_state = line.end_state;
+      target.put(y, 0, line.cells.data(), line.cells.size());
+    }
+
+    in_comment = end_state;
   }
+
+  // Clear the rows past the end of the buffer
+  target.clear_below(y);
 }
 
 void Screen::draw_status_bar()
 {
-  int height, width;
-  getmaxyx(stdscr, height, width);
-  int row = height - 1;
+  // The status bar is the last row of stdscr, or of the headless surface
+  NcursesSurface background(stdscr);
+  Surface& target = headless ? *headless : background;
+  int width = target.cols();
+  int row = target.rows() - 1;
+  if (row < 0) return;
 
   // Check if we have a valid, recent message (< 3 seconds old)
   auto now = std::chrono::steady_clock::now();
   auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - message_timestamp).count();
-  
+
+  std::string status_text;
+  chtype attrs;
+
   // -- ERROR MESSAGE MODE --
   if (!status_message.empty() && elapsed < 1) 
   {
-    attron(COLOR_PAIR(message_color_pair)); // Use the specific color for the message
-    
-    // Clear the line first
-    move(row, 0);
-    clrtoeol(); 
-    
-    // Print message
-    mvprintw(row, 0, "%s", status_message.c_str());
-    
-    // Fill the rest of the bar with space to look consistent
-    if (status_message.length() < width) {
-        std::string padding(width - status_message.length(), ' ');
-        printw("%s", padding.c_str());
-    }
-
-    attroff(COLOR_PAIR(message_color_pair));
+    status_text = status_message;
+    attrs = COLOR_PAIR(message_color_pair); // Use the specific color for the message
   } 
   // -- STANDARD STATUS BAR MODE --
   else 
@@ -121,20 +290,28 @@ void Screen::draw_status_bar()
     std::string filename = pointed_file.empty() ? "[No Name]" : pointed_file;
     std::string cursor_pos = std::to_string(pointed_row + 1) + ":" + std::to_string(pointed_col + 1);
     
-    std::string status_text = mode_str + " | " + filename + " | " + cursor_pos;
-
-    // Pad the rest of the line with spaces
-    if (status_text.length() < width) {
-      status_text.append(width - status_text.length(), ' ');
+    status_text = mode_str + " | " + filename + " | " + cursor_pos;
+    if (mode == Mode::find)
+    {
+      status_text += " | " + editor::find::search_status();
     }
+    attrs = A_REVERSE; // Invert colors for status bar
+  }
+
+  // Pad the rest of the line with spaces so the whole bar is drawn
+  status_text.resize(width, ' ');
 
-    // Draw on stdscr (background window)
-    attron(A_REVERSE); // Invert colors for status bar
-    mvprintw(row, 0, "%s", status_text.c_str());
-    attroff(A_REVERSE);
+  std::vector<chtype> cells(width);
+  for (int i = 0; i < width; ++i)
+  {
+    cells[i] = (unsigned char)status_text[i] | attrs;
   }
+  target.put(row, 0, cells.data(), width);
 
-  refresh(); // Refresh stdscr to render the bar
+  if (!headless)
+  {
+    wnoutrefresh(stdscr); // Queue stdscr, flushed with the windows by doupdate()
+  }
 }
 
 void Screen::print_buffer(WINDOW* window)
@@ -184,56 +361,79 @@ void Screen::print_buffer(
   WINDOW* window,
   size_t starting_row,
   size_t starting_col,
-  size_t max_col
+  size_t max_col,
+  size_t max_row
   )
 {
+  NcursesSurface target(window);
+  RenderCache& cache = render_caches[window];
+  size_t y = 0;
+
+  for (size_t row = starting_row; row < buffer.size() && y < max_row; row++)
+  {
+    const std::string& curr_row = buffer[row];
+    size_t segments = (soft_wrap && max_col > 0) ? curr_row.length() / max_col + 1 : 1;
 
-    for (int i = 0; (i + starting_row) < buffer.size() && i < max_row; i++)
+    for (size_t segment = 0; segment < segments && y < max_row; segment++, y++)
     {
-        wattron(window, COLOR_PAIR(numberRowsColor));
-        mvwprintw(window, i, 0, "%zu", i + starting_row + 1);
-        wattroff(window, COLOR_PAIR(numberRowsColor));
-
-        std::string curr_row = buffer[i + starting_row];
-
-        // Se la riga corrente è troppo corta, non è visibile
-        if(curr_row.length() > starting_col) { 
-            std::string row2print = curr_row.substr(starting_col, max_col);
-            wattron(window, COLOR_PAIR(textColor));
-            mvwprintw(window, i, span + 1, "%s", row2print.c_str());
-            wattroff(window, COLOR_PAIR(textColor));
-        }
+      size_t first_col = soft_wrap ? segment * max_col : starting_col;
+      RenderCache::Line& line = cache.slot(y);
+      if (!RenderCache::matches(line, row, curr_row, first_col, max_col, 0, 0, segment > 0))
+      {
+        line.valid = true;
+        line.row = row;
+        line.starting_col = first_col;
+        line.width = max_col;
+        line.style = 0;
+        line.overlay = 0;
+        line.end_state = 0;
+        line.continuation = segment > 0;
+        line.text = curr_row;
+        build_row(line, curr_row, nullptr);
+      }
+
+      target.put(y, 0, line.cells.data(), line.cells.size());
     }
+  }
 }
 
 
 void Screen::refresh_all_buffers() {
-    // Ottieni tutte le finestre dei buffer dal BufferManager
-    const auto& windows = BufferManager::instance().get_bufferWindows();
-    for (const auto& pair : windows) {
-        WINDOW* window = pair.second;
-        
-        // Evita di stampare nella finestra 'pointed_window'
-        if (window == pointed_window) continue;
-
-        // Pulisci ciascuna finestra
-        werase(window);
-
-        // Ottieni il buffer associato alla finestra corrente
-        BufferManager::BufferStructure* buffer = BufferManager::instance().get_buffer_by_name(pair.first);
-        if (buffer != nullptr) {
-            // Usa la funzione print_buffer per stampare il contenuto del buffer
-            print_buffer(
-                buffer->tBuffer.get_buffer(),  // Contenuto del buffer
-                window,                        // La finestra da stampare
-                buffer->starting_row,          // Riga iniziale
-                buffer->starting_col,          // Colonna iniziale
-                buffer->max_col                // Numero massimo di colonne visibili
-            );
+    auto& bufferManager = BufferManager::instance();
+    unsigned long layout = bufferManager.getWindowManager().get_layout_generation();
+
+    for (BufferManager::BufferStructure* buffer : bufferManager.get_all_buffers()) {
+        // The active window is drawn every frame: forget what it showed as inactive
+        if (buffer->window == pointed_window) {
+            buffer->last_render.valid = false;
+            continue;
         }
 
-        // Rinfresca la finestra per aggiornare il contenuto
-        wrefresh(window);
+        BufferManager::BufferStructure::RenderStamp stamp;
+        stamp.valid = true;
+        stamp.document_id = buffer->tBuffer.getId();
+        stamp.document_version = buffer->tBuffer.getVersion();
+        stamp.layout = layout;
+        stamp.starting_row = buffer->starting_row;
+        stamp.starting_col = buffer->starting_col;
+        stamp.max_row = buffer->max_row;
+        stamp.max_col = buffer->max_col;
+
+        // Nothing that is shown in the window changed: skip it entirely
+        if (stamp == buffer->last_render) continue;
+
+        werase(buffer->window);
+        print_buffer(
+            buffer->tBuffer.get_buffer(),
+            buffer->window,
+            buffer->starting_row,
+            buffer->starting_col,
+            buffer->max_col,
+            buffer->max_row
+        );
+        wnoutrefresh(buffer->window);
+
+        buffer->last_render = stamp;
     }
 }
 
@@ -245,4 +445,30 @@ void Screen::set_status_message(const std::string& msg, int color_pair)
     
     // Force an immediate update of the status bar so the user sees the error instantly
     draw_status_bar();
-}
\ No newline at end of file
+    if (!headless) doupdate();
+}
+
+void Screen::set_surface(Surface* surface)
+{
+  headless = surface;
+}
+
+Surface& Screen::surface()
+{
+  if (headless) return *headless;
+
+  window_surface.set_window(pointed_window);
+  return window_surface;
+}
+
+void Screen::invalidate_render_cache(WINDOW* window)
+{
+  if (window == nullptr)
+  {
+    render_caches.clear();
+  }
+  else
+  {
+    render_caches.erase(window);
+  }
+}
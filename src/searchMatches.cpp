@@ -0,0 +1,190 @@
+#include "../include/searchMatches.hpp"
+#include <algorithm>
+
+using editor::SearchMatch;
+using editor::SearchMatches;
+
+void SearchMatches::clear()
+{
+    blocks.clear();
+    starts.clear();
+    count = 0;
+}
+
+std::pair<size_t, size_t> SearchMatches::locate(size_t index) const
+{
+    size_t block = std::upper_bound(starts.begin(), starts.end(), index) - starts.begin() - 1;
+    return {block, index - starts[block]};
+}
+
+void SearchMatches::recount(size_t from)
+{
+    from = std::min(from, blocks.size());
+    starts.resize(blocks.size());
+    size_t at = from == 0 ? 0 : starts[from - 1] + blocks[from - 1].matches.size();
+    for (size_t b = from; b < blocks.size(); ++b) {
+        starts[b] = at;
+        at += blocks[b].matches.size();
+    }
+    count = at;
+}
+
+SearchMatch SearchMatches::operator[](size_t index) const
+{
+    std::pair<size_t, size_t> at = locate(index);
+    return blocks[at.first].at(at.second);
+}
+
+void SearchMatches::append(const std::vector<SearchMatch>& matches)
+{
+    for (const SearchMatch& match : matches) {
+        if (blocks.empty() || blocks.back().matches.size() >= BLOCK) {
+            starts.push_back(count);
+            blocks.emplace_back();
+            blocks.back().matches.reserve(BLOCK);
+        }
+        Block& block = blocks.back();
+        block.matches.push_back({match.row - block.shift, match.col, match.length, match.end_row - block.shift, match.end_col});
+        ++count;
+    }
+}
+
+void SearchMatches::insert(size_t index, const std::vector<SearchMatch>& matches)
+{
+    if (matches.empty()) {
+        return;
+    }
+    if (index >= count) {
+        append(matches);
+        return;
+    }
+
+    std::pair<size_t, size_t> at = locate(index);
+    Block& block = blocks[at.first];
+    std::vector<SearchMatch> shifted(matches);
+    for (SearchMatch& match : shifted) {
+        match.row -= block.shift;
+        match.end_row -= block.shift;
+    }
+    block.matches.insert(block.matches.begin() + at.second, shifted.begin(), shifted.end());
+
+    // A block grown past twice the size is cut in blocks of the size
+    if (block.matches.size() > 2 * BLOCK) {
+        std::vector<Block> parts;
+        for (size_t from = 0; from < block.matches.size(); from += BLOCK) {
+            parts.emplace_back();
+            parts.back().shift = block.shift;
+            parts.back().matches.assign(block.matches.begin() + from, block.matches.begin() + std::min(from + BLOCK, block.matches.size()));
+        }
+        blocks.erase(blocks.begin() + at.first);
+        blocks.insert(blocks.begin() + at.first, std::make_move_iterator(parts.begin()), std::make_move_iterator(parts.end()));
+    }
+    recount(at.first);
+}
+
+void SearchMatches::erase(size_t first, size_t last)
+{
+    last = std::min(last, count);
+    if (first >= last) {
+        return;
+    }
+    std::pair<size_t, size_t> at = locate(first);
+    size_t block = at.first;
+    size_t left = last - first;
+    while (left > 0) {
+        std::vector<SearchMatch>& matches = blocks[block].matches;
+        size_t taken = std::min(left, matches.size() - at.second);
+        matches.erase(matches.begin() + at.second, matches.begin() + at.second + taken);
+        left -= taken;
+        if (matches.empty()) {
+            blocks.erase(blocks.begin() + block);
+        } else {
+            ++block;
+        }
+        at.second = 0;
+    }
+    recount(at.first);
+}
+
+void SearchMatches::rotate(size_t middle)
+{
+    if (middle == 0 || middle >= count) {
+        return;
+    }
+    std::pair<size_t, size_t> at = locate(middle);
+    size_t first = at.first;
+    if (at.second > 0) {
+        // Split the block `middle` falls in, so the rotation moves whole blocks
+        Block tail;
+        tail.shift = blocks[first].shift;
+        tail.matches.assign(blocks[first].matches.begin() + at.second, blocks[first].matches.end());
+        blocks[first].matches.resize(at.second);
+        blocks.insert(blocks.begin() + first + 1, std::move(tail));
+        ++first;
+    }
+    std::rotate(blocks.begin(), blocks.begin() + first, blocks.end());
+    recount(0);
+}
+
+std::pair<size_t, size_t> SearchMatches::in_row(int row) const
+{
+    size_t first = partition_point([&](const SearchMatch& match) { return match.row < row; });
+    size_t last = partition_point([&](const SearchMatch& match) { return match.row <= row; });
+    return {first, last};
+}
+
+void SearchMatches::replace_row(int row, const std::vector<SearchMatch>& matches)
+{
+    std::pair<size_t, size_t> range = in_row(row);
+    if (range.second - range.first == matches.size() && !matches.empty()) {
+        // As many matches as before: overwritten in place
+        std::pair<size_t, size_t> at = locate(range.first);
+        for (const SearchMatch& match : matches) {
+            if (at.second == blocks[at.first].matches.size()) {
+                ++at.first;
+                at.second = 0;
+            }
+            Block& block = blocks[at.first];
+            block.matches[at.second++] = {match.row - block.shift, match.col, match.length, match.end_row - block.shift, match.end_col};
+        }
+        return;
+    }
+    erase(range.first, range.second);
+    insert(range.first, matches);
+}
+
+void SearchMatches::shift_rows(int row, int delta)
+{
+    size_t first = partition_point([&](const SearchMatch& match) { return match.row < row; });
+    if (first == count || delta == 0) {
+        return;
+    }
+
+    // The block the first moved match is in moves from it on, the blocks after it as a whole
+    std::pair<size_t, size_t> at = locate(first);
+    Block& block = blocks[at.first];
+    if (at.second == 0) {
+        block.shift += delta;
+    } else {
+        for (size_t i = at.second; i < block.matches.size(); ++i) {
+            block.matches[i].row += delta;
+            block.matches[i].end_row += delta;
+        }
+    }
+    for (size_t b = at.first + 1; b < blocks.size(); ++b) {
+        blocks[b].shift += delta;
+    }
+}
+
+void SearchMatches::insert_rows(int row, int rows)
+{
+    shift_rows(row, rows);
+}
+
+void SearchMatches::erase_rows(int row, int rows)
+{
+    size_t first = partition_point([&](const SearchMatch& match) { return match.row < row; });
+    size_t last = partition_point([&](const SearchMatch& match) { return match.row < row + rows; });
+    erase(first, last);
+    shift_rows(row + rows, -rows);
+}
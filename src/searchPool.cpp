@@ -0,0 +1,115 @@
+#include "../include/searchPool.hpp"
+#include "../include/incrementalSearch.hpp"
+#include <algorithm>
+
+SearchPool::SearchPool()
+    : count(std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+SearchPool::~SearchPool()
+{
+    stop();
+}
+
+void SearchPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    workers.clear();
+    stopping = false;
+}
+
+void SearchPool::resize(size_t threads)
+{
+    stop();
+    count = std::max<size_t>(threads, 1);
+}
+
+size_t SearchPool::take(const std::deque<std::string>& lines, SearchPattern& pattern, std::vector<Chunk>& chunks, std::atomic<size_t>& next)
+{
+    size_t taken = 0;
+    for (size_t i = next.fetch_add(1); i < chunks.size(); i = next.fetch_add(1)) {
+        Chunk& chunk = chunks[i];
+        for (int row : chunk.rows) {
+            pattern.matches(lines[row], row, chunk.matches);
+        }
+        ++taken;
+    }
+    return taken;
+}
+
+void SearchPool::search(const std::deque<std::string>& text, const std::shared_ptr<SearchPattern>& pattern, std::vector<Chunk>& work)
+{
+    if (count == 1 || work.size() < 2) {
+        std::atomic<size_t> first{0};
+        take(text, *pattern, work, first);
+        return;
+    }
+
+    std::unique_lock<std::mutex> guard(lock);
+    if (source != pattern) {
+        // Copied here, before this thread searches with it again
+        source = pattern;
+        prototype = std::make_shared<const SearchPattern>(*pattern);
+    }
+    lines = &text;
+    chunks = &work;
+    next = 0;
+    done = 0;
+    open = true;
+    ++generation;
+    while (workers.size() + 1 < count) {
+        workers.emplace_back(&SearchPool::run, this);
+    }
+    guard.unlock();
+    wake.notify_all();
+
+    size_t taken = take(text, *pattern, work, next);
+
+    // Workers still inside read `next` and the chunks: wait for them to leave
+    guard.lock();
+    done += taken;
+    finished.wait(guard, [&]() { return done == work.size() && working == 0; });
+    open = false;
+    chunks = nullptr;
+    lines = nullptr;
+}
+
+void SearchPool::run()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    unsigned long seen = 0;
+    std::shared_ptr<const SearchPattern> copied_from;
+    std::unique_ptr<SearchPattern> pattern;
+
+    while (true) {
+        wake.wait(guard, [&]() { return stopping || (open && generation != seen); });
+        if (stopping) {
+            return;
+        }
+        seen = generation;
+        ++working;
+        const std::deque<std::string>& text = *lines;
+        std::vector<Chunk>& work = *chunks;
+        std::shared_ptr<const SearchPattern> latest = prototype;
+        guard.unlock();
+
+        if (copied_from != latest) {
+            copied_from = latest;
+            pattern = std::make_unique<SearchPattern>(*latest);
+        }
+        size_t taken = take(text, *pattern, work, next);
+
+        guard.lock();
+        done += taken;
+        --working;
+        if (working == 0 && done == work.size()) {
+            finished.notify_one();
+        }
+    }
+}
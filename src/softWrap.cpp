@@ -0,0 +1,138 @@
+#include "../include/softWrap.hpp"
+#include "../include/globals/mvimResources.h"
+#include <algorithm>
+
+void SoftWrap::rebuild(const textBuffer& text)
+{
+    const auto& rows = text.get_buffer();
+    std::vector<uint32_t> heights(rows.size());
+    for (size_t r = 0; r < rows.size(); ++r) {
+        heights[r] = height(rows[r].length());
+    }
+    lines.assign(heights);
+}
+
+void SoftWrap::sync(const textBuffer& text, size_t text_width)
+{
+    text_width = std::max<size_t>(text_width, 1);
+    bool same_layout = built && document == text.getId() && width == text_width;
+
+    if (same_layout && version == text.getVersion()) {
+        return;
+    }
+
+    const auto& rows = text.get_buffer();
+    bool incremental = same_layout && text.edits_since(version, edits) &&
+                       edits.size() <= rows.size() / 8 + 64;
+
+    width = text_width;
+    document = text.getId();
+    version = text.getVersion();
+    built = true;
+
+    if (!incremental) {
+        rebuild(text);
+        return;
+    }
+
+    // Replay the structure of the edits, then weigh the touched rows once
+    // against the current text (rows named by old edits may have moved since)
+    std::vector<size_t> dirty;
+    for (const BufferEdit& edit : edits) {
+        switch (edit.kind) {
+            case BufferEdit::CHANGE:
+                dirty.push_back(edit.row);
+                break;
+            case BufferEdit::INSERT:
+                for (size_t& r : dirty) {
+                    if (r >= (size_t)edit.row) r += edit.count;
+                }
+                lines.insert(edit.row, edit.count, 1);
+                for (int i = 0; i < edit.count; ++i) dirty.push_back(edit.row + i);
+                break;
+            case BufferEdit::ERASE:
+                dirty.erase(std::remove_if(dirty.begin(), dirty.end(), [&](size_t r) {
+                    return r >= (size_t)edit.row && r < (size_t)(edit.row + edit.count);
+                }), dirty.end());
+                for (size_t& r : dirty) {
+                    if (r >= (size_t)(edit.row + edit.count)) r -= edit.count;
+                }
+                lines.erase(edit.row, edit.count);
+                break;
+            case BufferEdit::RESET:
+                rebuild(text);
+                return;
+        }
+    }
+
+    if (lines.size() != rows.size()) {
+        rebuild(text);
+        return;
+    }
+
+    std::sort(dirty.begin(), dirty.end());
+    dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+    for (size_t r : dirty) {
+        if (r < rows.size()) lines.set(r, height(rows[r].length()));
+    }
+}
+
+void SoftWrap::follow_cursor()
+{
+    sync(buffer, max_col);
+    starting_col = 0;
+
+    uint64_t rows = std::max<size_t>(max_row, 1);
+    uint64_t margin = std::min<uint64_t>(SCROLL_START_THRESHOLD, (rows - 1) / 2);
+    uint64_t top = line_of(starting_row);
+    uint64_t cursor_line = line_of(pointed_row) + pointed_col / width;
+
+    if (cursor_line < top || (top > 0 && cursor_line < top + margin)) {
+        // Cursor above the margin: the new top row starts at or before the wanted line
+        uint64_t wanted = cursor_line > margin ? cursor_line - margin : 0;
+        starting_row = row_at(wanted);
+    } else if (cursor_line >= top + rows ||
+               (cursor_line + margin >= top + rows && top + rows < total_lines())) {
+        // Cursor below the margin: start at the first row not above the wanted line
+        uint64_t wanted = cursor_line + margin + 1 - rows;
+        size_t row = row_at(wanted);
+        if (line_of(row) < wanted) row++;
+        starting_row = std::min(row, pointed_row);
+    }
+
+    uint64_t y = cursor_line - line_of(starting_row);
+    cursor.setY(std::min<uint64_t>(y, rows - 1));
+    cursor.setX(pointed_col % width);
+}
+
+void SoftWrap::hit(int y, int x, int& row, int& col)
+{
+    sync(buffer, max_col);
+    if (buffer.getSize() == 0) {
+        row = col = 0;
+        return;
+    }
+
+    uint64_t line = line_of(starting_row) + std::max(y, 0);
+    size_t r = std::min<size_t>(row_at(line), buffer.getSize() - 1);
+    uint64_t segment = line > line_of(r) ? line - line_of(r) : 0;
+
+    int text_x = std::min(std::max(x - (span + 1), 0), (int)width - 1);
+    size_t c = segment * width + text_x;
+    size_t length = buffer[r].length();
+
+    row = r;
+    col = std::min(c, length);
+}
+
+bool SoftWrap::position(size_t row, size_t col, int& y, int& x) const
+{
+    uint64_t top = line_of(starting_row);
+    uint64_t line = line_of(row) + col / width;
+    if (line < top || line >= top + max_row) {
+        return false;
+    }
+    y = line - top;
+    x = col % width + span + 1;
+    return true;
+}
@@ -0,0 +1,86 @@
+#include "../include/surface.hpp"
+#include <algorithm>
+
+// --- NcursesSurface ---
+
+int NcursesSurface::rows() const {
+    return window ? getmaxy(window) : 0;
+}
+
+int NcursesSurface::cols() const {
+    return window ? getmaxx(window) : 0;
+}
+
+void NcursesSurface::put(int y, int x, const chtype* cells, int n) {
+    mvwaddchnstr(window, y, x, cells, n);
+}
+
+void NcursesSurface::clear_below(int y) {
+    if (y >= rows()) return;
+    wmove(window, y, 0);
+    wclrtobot(window);
+}
+
+void NcursesSurface::scroll_rows(int height, int delta) {
+    // Only a scrolling window can be scrolled: enable it just for the move,
+    // so writing in the bottom right corner never scrolls it by accident
+    wsetscrreg(window, 0, height - 1);
+    scrollok(window, TRUE);
+    wscrl(window, delta);
+    scrollok(window, FALSE);
+}
+
+void NcursesSurface::recolor(int y, int x, int n, attr_t attrs, short pair) {
+    mvwchgat(window, y, x, n, attrs, pair, NULL);
+}
+
+// --- CellGrid ---
+
+static const chtype blank = ' ';
+
+CellGrid::CellGrid(int rows, int cols)
+    : height(rows), width(cols), cells(rows * cols, blank) {}
+
+void CellGrid::put(int y, int x, const chtype* src, int n) {
+    if (y < 0 || y >= height || x < 0 || x >= width) return;
+    n = std::min(n, width - x);
+    std::copy(src, src + n, cells.begin() + y * width + x);
+}
+
+void CellGrid::clear_below(int y) {
+    if (y < 0 || y >= height) return;
+    std::fill(cells.begin() + y * width, cells.end(), blank);
+}
+
+void CellGrid::scroll_rows(int region, int delta) {
+    region = std::min(region, height);
+    auto first = cells.begin();
+    auto last = cells.begin() + region * width;
+    int shift = std::min(std::abs(delta), region) * width;
+
+    if (delta > 0) {
+        std::copy(first + shift, last, first);
+        std::fill(last - shift, last, blank);
+    } else if (delta < 0) {
+        std::copy_backward(first, last - shift, last);
+        std::fill(first, first + shift, blank);
+    }
+}
+
+void CellGrid::recolor(int y, int x, int n, attr_t attrs, short pair) {
+    if (y < 0 || y >= height || x < 0 || x >= width) return;
+    n = (n < 0) ? width - x : std::min(n, width - x);
+    for (int i = 0; i < n; ++i) {
+        chtype& cell = cells[y * width + x + i];
+        cell = (cell & A_CHARTEXT) | attrs | COLOR_PAIR(pair);
+    }
+}
+
+std::string CellGrid::row_text(int y) const {
+    std::string text;
+    for (int x = 0; x < width; ++x) {
+        text += (char)(at(y, x) & A_CHARTEXT);
+    }
+    text.erase(text.find_last_not_of(' ') + 1);
+    return text;
+}
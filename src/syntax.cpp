@@ -24,7 +24,6 @@ static std::string trim_val(const std::string& str) {
 }
 
 void SyntaxHighlighter::loadLanguages() {
-    languages.clear();
     
     // Define potential paths: local dev path first, then system install paths
     std::vector<std::string> searchPaths = {
@@ -50,28 +49,86 @@ void SyntaxHighlighter::loadLanguages() {
         return;
     }
 
-    // The rest of the function remains the same, using the found langPath
-    for (const auto& entry : fs::directory_iterator(langPath)) {
-        if (entry.path().extension() == ".mvimlang") {
-            parseLanguageFile(entry.path());
+    indexLanguages(langPath);
+}
+
+void SyntaxHighlighter::indexLanguages(const fs::path& dir) {
+    languageFiles.clear();
+    filesByExtension.clear();
+    pointed_language = nullptr;
+
+    std::error_code error;
+    for (const auto& entry : fs::directory_iterator(dir, error)) {
+        if (entry.path().extension() != ".mvimlang") continue;
+
+        LanguageFile file;
+        if (!readHeader(fs::absolute(entry.path()), file)) continue;
+
+        for (const auto& ext : file.extensions) {
+            filesByExtension.emplace(ext, languageFiles.size());
         }
+        languageFiles.push_back(std::move(file));
     }
 }
 
-void SyntaxHighlighter::parseLanguageFile(const fs::path& path) {
+bool SyntaxHighlighter::readHeader(const fs::path& path, LanguageFile& file) {
+    std::ifstream stream(path);
+    if (!stream.is_open()) {
+        ErrorHandler::instance().report(ErrorLevel::ERROR, "Failed to load language file: " + path.string());
+        return false;
+    }
+
+    file.path = path;
+    std::string line;
+    while (std::getline(stream, line) && (file.name.empty() || file.extensions.empty())) {
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t delimiterPos = line.find('=');
+        if (delimiterPos == std::string::npos) continue;
+
+        std::string key = trim_val(line.substr(0, delimiterPos));
+        std::string value = trim_val(line.substr(delimiterPos + 1));
+
+        if (key == "name") {
+            file.name = value;
+        } else if (key == "extensions") {
+            file.extensions = split(value);
+        }
+    }
+    return !file.name.empty() && !file.extensions.empty();
+}
+
+const Language* SyntaxHighlighter::compile(const LanguageFile& file) {
+    std::error_code error;
+    fs::file_time_type mtime = fs::last_write_time(file.path, error);
+
+    auto cached = compiled.find(file.path.string());
+    if (cached != compiled.end() && cached->second.mtime == mtime) {
+        return cached->second.language;
+    }
+
+    auto lang = std::make_unique<Language>();
+    if (!parseLanguageFile(file.path, *lang)) {
+        return nullptr;
+    }
+    compiledLanguages.push_back(std::move(lang));
+    compiled[file.path.string()] = {mtime, compiledLanguages.back().get()};
+    return compiledLanguages.back().get();
+}
+
+bool SyntaxHighlighter::parseLanguageFile(const fs::path& path, Language& lang) {
     std::ifstream file(path);
     if (!file.is_open()) {
         ErrorHandler::instance().report(ErrorLevel::ERROR, "Failed to load language file: " + path.string());
-        return;
+        return false;
     }
 
-    Language lang;
     std::string line;
     
     // Prepare groups (0 = keywords, 1 = preprocessor)
     // You can extend this logic to be more dynamic if needed
-    lang.syntaxGroups.push_back({{}, keyWordColor});
-    lang.syntaxGroups.push_back({{}, preprocessorColor});
+    lang.syntaxGroups.push_back({{}, &keyWordColor});
+    lang.syntaxGroups.push_back({{}, &preprocessorColor});
 
     while (std::getline(file, line)) {
         if (line.empty() || line[0] == '#') continue;
@@ -94,6 +151,20 @@ void SyntaxHighlighter::parseLanguageFile(const fs::path& path) {
             lang.multiLineCommentEnd = value;
         } else if (key == "brackets") {
             lang.brackets = value;
+        } else if (key == "strings") {
+            for (const std::string& delimiter : split(value)) lang.tokenRules.stringDelimiters += delimiter;
+        } else if (key == "escape") {
+            lang.tokenRules.escape = value.empty() ? '\0' : value[0];
+        } else if (key == "numbers") {
+            lang.tokenRules.numberStart = value;
+        } else if (key == "number_chars") {
+            lang.tokenRules.numberChars = value;
+        } else if (key == "identifier_start") {
+            lang.tokenRules.identifierStart = value;
+        } else if (key == "identifier_chars") {
+            lang.tokenRules.identifierChars = value;
+        } else if (key == "types") {
+            lang.tokenRules.typeStart = value;
         } else if (key == "keywords") {
             std::vector<std::string> words = split(value);
             lang.syntaxGroups[0].keywords.insert(lang.syntaxGroups[0].keywords.end(), words.begin(), words.end());
@@ -103,10 +174,18 @@ void SyntaxHighlighter::parseLanguageFile(const fs::path& path) {
         }
     }
 
-    if (!lang.name.empty() && !lang.extensions.empty()) {
-        languages.push_back(lang);
-        // ErrorHandler::instance().report(ErrorLevel::INFO, "Loaded language module: " + lang.name);
+    for (size_t group = 0; group < lang.syntaxGroups.size(); ++group) {
+        for (const std::string& keyword : lang.syntaxGroups[group].keywords) {
+            lang.keywordMatcher.add(keyword, group);
+        }
     }
+    lang.keywordMatcher.build();
+    lang.tokenRules.lineComment = lang.singleLineComment;
+    lang.tokenRules.blockStart = lang.multiLineCommentStart;
+    lang.tokenRules.blockEnd = lang.multiLineCommentEnd;
+    lang.lexer.build(lang.tokenRules);
+
+    return !lang.name.empty() && !lang.extensions.empty();
 }
 
 std::string SyntaxHighlighter::getExtension(const std::string& filename) {
@@ -117,19 +196,19 @@ std::string SyntaxHighlighter::getExtension(const std::string& filename) {
 
 void SyntaxHighlighter::setLanguageFromFile(const std::string& filename) {
     std::string ext = getExtension(filename);
-    currentLanguage = nullptr;
-
-    for (const auto& lang : languages) {
-        for (const auto& supportedExt : lang.extensions) {
-            if (supportedExt == ext) {
-                currentLanguage = &lang;
-                ErrorHandler::instance().report(ErrorLevel::INFO, "Active Language: " + lang.name);
-                return;
-            }
-        }
+    pointed_language = nullptr;
+
+    auto found = filesByExtension.find(ext);
+    if (found == filesByExtension.end()) {
+        return;
+    }
+
+    pointed_language = compile(languageFiles[found->second]);
+    if (pointed_language) {
+        ErrorHandler::instance().report(ErrorLevel::INFO, "Active Language: " + pointed_language->name);
     }
 }
 
 const Language* SyntaxHighlighter::getCurrentLanguage() const {
-    return currentLanguage;
+    return pointed_language;
 }
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "../include/syntaxState.hpp"
+#include "../include/editor.hpp"
+#include "../include/editorStats.hpp"
+#include "../include/syntax.hpp"
+#include <algorithm>
+
+void SyntaxStateCache::Document::reset(size_t rows)
+{
+    end_states.assign(rows, 0);
+    stale.clear();
+    valid = 0;
+}
+
+void SyntaxStateCache::Document::mark_stale(size_t row)
+{
+    if (row < end_states.size()) {
+        stale.insert(row);
+    }
+}
+
+void SyntaxStateCache::Document::sync(const textBuffer& text, std::vector<BufferEdit>& edits)
+{
+    const Language* lang = SyntaxHighlighter::instance().getCurrentLanguage();
+    size_t rows = text.get_buffer().size();
+
+    if (!built || language != lang || !text.edits_since(version, edits)) {
+        built = true;
+        version = text.getVersion();
+        language = lang;
+        reset(rows);
+        return;
+    }
+
+    if (version == text.getVersion()) {
+        return;
+    }
+    version = text.getVersion();
+
+    // Only mark what the edits touched; relex() works out how far it spreads
+    for (const BufferEdit& edit : edits) {
+        size_t row = edit.row;
+        size_t count = edit.count;
+        switch (edit.kind) {
+            case BufferEdit::CHANGE:
+                mark_stale(row);
+                break;
+            case BufferEdit::INSERT: {
+                std::set<size_t> shifted;
+                for (size_t r : stale) shifted.insert(r >= row ? r + count : r);
+                stale.swap(shifted);
+                end_states.insert(end_states.begin() + std::min(row, end_states.size()), count, 0);
+                if (valid > row) valid += count;
+                for (size_t r = row; r <= row + count; ++r) mark_stale(r);
+                break;
+            }
+            case BufferEdit::ERASE: {
+                std::set<size_t> shifted;
+                for (size_t r : stale) {
+                    if (r < row) shifted.insert(r);
+                    else if (r >= row + count) shifted.insert(r - count);
+                }
+                stale.swap(shifted);
+                size_t last = std::min(row + count, end_states.size());
+                if (row < last) end_states.erase(end_states.begin() + row, end_states.begin() + last);
+                if (valid > row) valid -= std::min(count, valid - row);
+                mark_stale(row);
+                break;
+            }
+            case BufferEdit::RESET:
+                reset(rows);
+                return;
+        }
+    }
+
+    if (end_states.size() != rows) {
+        reset(rows);
+    }
+}
+
+void SyntaxStateCache::Document::relex(const textBuffer& text, size_t row)
+{
+    // Rows above both the first stale row and `valid` hold correct states,
+    // so the lowest of the two is always the next row worth lexing
+    while (true) {
+        size_t r = stale.empty() ? valid : std::min(*stale.begin(), valid);
+        if (r >= row || r >= end_states.size()) {
+            break;
+        }
+
+        bool state = r > 0 && end_states[r - 1];
+        editor::visual::style_block_comments(*language, text.get_buffer()[r], nullptr, state);
+        EditorStats::instance().rows_lexed++;
+
+        bool changed = end_states[r] != state;
+        end_states[r] = state;
+        stale.erase(r);
+
+        if (r >= valid) {
+            valid = r + 1;
+        } else if (changed) {
+            mark_stale(r + 1);
+        }
+    }
+}
+
+bool SyntaxStateCache::state_before(const textBuffer& text, size_t row)
+{
+    Document& document = documents.get(text.getId());
+    document.sync(text, edits);
+    if (!document.language || row == 0) {
+        return false;
+    }
+
+    row = std::min(row, document.end_states.size());
+    document.relex(text, row);
+    return row > 0 && document.end_states[row - 1];
+}
@@ -2,7 +2,12 @@
 #include <string>
 #include "../include/editor.hpp"
 #include "../include/bufferManager.hpp"
+#include "../include/editorStats.hpp"
+#include "../include/softWrap.hpp"
+#include "../include/incrementalSearch.hpp"
 #include <algorithm>
+#include <poll.h>
+#include <unistd.h>
 
 // Function to prompt user for confirmation before exiting unsaved changes
 bool editor::system::confirm_exit()
@@ -155,6 +160,7 @@ void editor::system::helpMenu()
 
   // Cleanup
   delwin(menu_win);           // Delete the window
+  BufferManager::instance().getWindowManager().invalidate_layout();
   endwin();                   // End ncurses mode
 }
 
@@ -180,6 +186,12 @@ static void centerText(WINDOW* win, int starty, int width, const std::string& st
 }
 
 std::string editor::system::text_form(const std::string& label)
+{
+  return text_form(label, nullptr, nullptr);
+}
+
+std::string editor::system::text_form(const std::string& label, const std::function<void(const std::string&)>& on_edit,
+                                      const std::function<bool()>& on_idle)
 {
   int height, width;
   getmaxyx(stdscr, height, width);
@@ -200,11 +212,30 @@ std::string editor::system::text_form(const std::string& label)
   std::string input;
   int ch;
   bool exit_form = false;
+  bool working = false;    // on_idle has more to do
+
+  // The callbacks draw the buffer: put the form back on top of it
+  auto redraw_form = [&]()
+  {
+    touchwin(form_win);
+    wmove(form_win, 3, 4 + input.size());
+    wrefresh(form_win);
+  };
 
   while (1)
   {
+    // While there is work left, only peek at the keyboard between two slices of it
+    wtimeout(form_win, working ? 0 : -1);
     ch = wgetch(form_win);
 
+    if (ch == ERR)
+    {
+      working = on_idle && on_idle();
+      redraw_form();
+      continue;
+    }
+
+    size_t length = input.size();
     if (ch == 27)        // ESC key
     {
       exit_form = true;
@@ -230,16 +261,36 @@ std::string editor::system::text_form(const std::string& label)
       mvwaddch(form_win, 3, 4 + input.size() - 1, ch);        // Display character
       wrefresh(form_win);
     }
+
+    if (on_edit && input.size() != length)
+    {
+      on_edit(input);
+      working = true;
+      redraw_form();
+    }
   }
 
   delwin(form_win);
+
+  // The popup covered the buffer windows: they all have to be drawn again
+  BufferManager::instance().getWindowManager().invalidate_layout();
   
   // Refresh again to clear the popup artifacts and restore lines immediately
   //BufferManager::instance().getWindowManager().resize_windows();
 
+  if (exit_form && on_edit)
+  {
+    return "";
+  }
   return input;
 }
 
+bool editor::system::input_pending()
+{
+  struct pollfd keyboard = { STDIN_FILENO, POLLIN, 0 };
+  return poll(&keyboard, 1, 0) > 0;
+}
+
 void editor::system::change2command()
 {
   mode = Mode::command;
@@ -279,7 +330,7 @@ void editor::system::restore()
   visual_start_row  = pointed_row;
   visual_start_col  = cursor.getX();
   current_occurrence_index = -1;
-  found_occurrences.clear();
+  IncrementalSearch::instance().clear();
 }
 
 void editor::system::switch_to_next_buffer() {
@@ -401,4 +452,28 @@ void editor::system::resize(){
   // 6. Refresh
   wclear(stdscr);
   wrefresh(stdscr);
-}
\ No newline at end of file
+}
+void editor::system::show_stats()
+{
+  ErrorHandler::instance().report(ErrorLevel::INFO, EditorStats::instance().summary());
+}
+
+void editor::system::toggle_wrap()
+{
+  soft_wrap = !soft_wrap;
+
+  if (soft_wrap)
+  {
+    SoftWrap::instance().follow_cursor();
+  }
+  else
+  {
+    // Back to one screen line per row: the cursor line is its row again
+    editor::movement::move2X(pointed_col);
+    cursor.setY(pointed_row - starting_row);
+  }
+
+  // Every window changes its layout
+  BufferManager::instance().getWindowManager().invalidate_layout();
+  ErrorHandler::instance().report(ErrorLevel::INFO, soft_wrap ? "Soft wrap on" : "Soft wrap off");
+}
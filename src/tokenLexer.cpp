@@ -0,0 +1,211 @@
+#include "../include/tokenLexer.hpp"
+#include <array>
+#include <map>
+
+std::string TokenLexer::expand_set(const std::string& set)
+{
+    std::string chars;
+    for (size_t i = 0; i < set.size(); ++i) {
+        if (i + 2 < set.size() && set[i + 1] == '-') {
+            for (int c = (unsigned char)set[i]; c <= (unsigned char)set[i + 2]; ++c) {
+                chars += (char)c;
+            }
+            i += 2;
+        } else {
+            chars += set[i];
+        }
+    }
+    return chars;
+}
+
+void TokenLexer::build(const TokenRules& rules)
+{
+    next.clear();
+    token.clear();
+    back.clear();
+    block.clear();
+    classes = 0;
+    block_state = 0;
+    block_start.clear();
+    block_end.clear();
+
+    using ByteSet = std::array<bool, 256>;
+    auto make_set = [](const std::string& set) {
+        ByteSet members{};
+        for (unsigned char c : expand_set(set)) members[c] = true;
+        return members;
+    };
+
+    std::string strings;
+    for (char c : rules.stringDelimiters) {
+        if (c != ' ' && strings.find(c) == std::string::npos) strings += c;
+    }
+    ByteSet type_start = make_set(rules.typeStart);
+    ByteSet identifier_start = make_set(rules.identifierStart + rules.typeStart);
+    ByteSet identifier_chars = make_set(rules.identifierChars + rules.identifierStart + rules.typeStart);
+    ByteSet number_start = make_set(rules.numberStart);
+    ByteSet number_chars = make_set(rules.numberChars + rules.numberStart);
+    const std::string& line = rules.lineComment;
+    const std::string open = rules.blockEnd.empty() ? "" : rules.blockStart;
+    const std::string close = open.empty() ? "" : rules.blockEnd;
+
+    if (strings.empty() && rules.numberStart.empty() && rules.identifierStart.empty() && rules.typeStart.empty() &&
+        line.empty() && open.empty()) {
+        return;
+    }
+
+    // Between tokens, right after a string, inside an identifier, a type or a
+    // number, then two modes per string delimiter: inside, and after an escape;
+    // last the comments: to the end of the row, multi-line, and right after one
+    enum : uint8_t { START, CLOSE, IDENTIFIER, TYPE, NUMBER, FIRST_STRING };
+    if (FIRST_STRING + 2 * strings.size() + 3 > 255) {
+        return;
+    }
+    const uint8_t LINE = FIRST_STRING + 2 * strings.size();
+    const uint8_t BLOCK = LINE + 1;
+    const uint8_t BLOCK_CLOSED = LINE + 2;
+    auto in_code = [&](uint8_t mode) { return mode < FIRST_STRING || mode == BLOCK_CLOSED; };
+
+    auto from_start = [&](unsigned char c) -> uint8_t {
+        size_t k = strings.find((char)c);
+        if (k != std::string::npos) return FIRST_STRING + 2 * k;
+        if (type_start[c]) return TYPE;
+        if (identifier_start[c]) return IDENTIFIER;
+        if (number_start[c]) return NUMBER;
+        return START;
+    };
+
+    // The mode after a byte, comments aside
+    auto plain = [&](uint8_t mode, unsigned char c) -> uint8_t {
+        switch (mode) {
+            case IDENTIFIER: return identifier_chars[c] ? IDENTIFIER : from_start(c);
+            case TYPE: return identifier_chars[c] ? TYPE : from_start(c);
+            case NUMBER: return number_chars[c] ? NUMBER : from_start(c);
+            default: break;
+        }
+        if (mode >= FIRST_STRING && mode < LINE) {
+            uint8_t inside = FIRST_STRING + (mode - FIRST_STRING) / 2 * 2;
+            if (mode != inside) return inside;
+            size_t k = (inside - FIRST_STRING) / 2;
+            return (c == (unsigned char)strings[k]) ? CLOSE
+                 : (rules.escape && c == (unsigned char)rules.escape) ? inside + 1
+                 : inside;
+        }
+        return from_start(c);
+    };
+
+    auto starts_with = [](const std::string& text, const std::string& prefix) {
+        return text.size() > prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+    };
+
+    // A state is a mode and the part of a comment delimiter read so far: of an
+    // opening one for code and strings (a string may be the start of one, as
+    // """ in Python), of the closing one inside a multi-line comment, and of
+    // the multi-line opening one right after a line comment (--[[ in Lua)
+    using State = std::pair<uint8_t, std::string>;
+    auto step = [&](const State& state, unsigned char c) -> State {
+        uint8_t mode = state.first;
+        std::string read = state.second + (char)c;
+        if (mode == LINE) {
+            if (state.second.empty()) return {LINE, ""};
+            if (read == open) return {BLOCK, ""};
+            return {LINE, starts_with(open, read) ? read : ""};
+        }
+        if (mode == BLOCK) {
+            if (read == close) return {BLOCK_CLOSED, ""};
+            while (!read.empty() && close.compare(0, read.size(), read) != 0) read.erase(0, 1);
+            return {BLOCK, read};
+        }
+        uint8_t after = plain(mode, c);
+        for (const std::string& delimiter : {read, std::string(1, (char)c)}) {
+            if (delimiter.size() > 1 && state.second.empty()) continue;
+            if (delimiter.size() == 1 && !in_code(mode)) break;
+            if (!open.empty() && delimiter == open) return {BLOCK, ""};
+            if (!line.empty() && delimiter == line) return {LINE, starts_with(open, line) ? line : ""};
+            if (starts_with(open, delimiter) || starts_with(line, delimiter)) return {after, delimiter};
+        }
+        return {after, ""};
+    };
+
+    std::map<State, uint8_t> ids;
+    std::vector<State> states;
+    auto id_of = [&](const State& state) -> int {
+        auto found = ids.find(state);
+        if (found != ids.end()) return found->second;
+        if (states.size() >= 255) return -1;
+        ids.emplace(state, (uint8_t)states.size());
+        states.push_back(state);
+        return states.size() - 1;
+    };
+    id_of({START, ""});
+    if (!open.empty()) block_state = id_of({BLOCK, ""});
+
+    std::vector<std::array<uint8_t, 256>> table;
+    for (size_t s = 0; s < states.size(); ++s) {
+        table.emplace_back();
+        for (int b = 0; b < 256; ++b) {
+            int target = id_of(step(states[s], (unsigned char)b));
+            if (target < 0) {
+                block_state = 0;
+                return;
+            }
+            table[s][b] = target;
+        }
+    }
+
+    token.resize(states.size());
+    back.assign(states.size(), 0);
+    block.assign(states.size(), false);
+    for (size_t s = 0; s < states.size(); ++s) {
+        uint8_t mode = states[s].first;
+        token[s] = mode == START ? Token::TEXT
+                 : mode == IDENTIFIER ? Token::IDENTIFIER
+                 : mode == TYPE ? Token::TYPE
+                 : mode == NUMBER ? Token::NUMBER
+                 : mode >= LINE ? Token::COMMENT
+                 : Token::STRING;
+        if (mode == LINE) back[s] = line.size() - 1;
+        if (mode == BLOCK) back[s] = open.size() - 1;
+        block[s] = mode == BLOCK;
+    }
+    block_start = open;
+    block_end = close;
+
+    // Bytes with the same column in every state share a class
+    std::map<std::vector<uint8_t>, uint8_t> columns;
+    std::vector<std::vector<uint8_t>> by_class;
+    for (int b = 0; b < 256; ++b) {
+        std::vector<uint8_t> column(states.size());
+        for (size_t s = 0; s < states.size(); ++s) column[s] = table[s][b];
+        auto found = columns.find(column);
+        if (found == columns.end()) {
+            found = columns.emplace(column, (uint8_t)by_class.size()).first;
+            by_class.push_back(column);
+        }
+        byte_class[b] = found->second;
+    }
+
+    classes = by_class.size();
+    next.assign(states.size() * classes, START);
+    for (uint32_t c = 0; c < classes; ++c) {
+        for (size_t s = 0; s < states.size(); ++s) {
+            next[s * classes + c] = by_class[c][s];
+        }
+    }
+}
+
+bool TokenLexer::ends_in_comment(const std::string& text, bool in_comment) const
+{
+    if (next.empty() || block_start.empty()) {
+        return false;
+    }
+    // Without a delimiter that could change it, the state goes through the row as is
+    if (text.find(in_comment ? block_end : block_start) == std::string::npos) {
+        return in_comment;
+    }
+    uint8_t state = in_comment ? block_state : 0;
+    for (unsigned char c : text) {
+        state = next[state * classes + byte_class[c]];
+    }
+    return block[state];
+}
@@ -0,0 +1,343 @@
+#include "../include/trigramIndex.hpp"
+#include "../include/editorStats.hpp"
+#include "../include/globals/mvimResources.h"
+#include <algorithm>
+
+// The byte a trigram is made of: ASCII letters in lower case
+static uint8_t folded(unsigned char byte)
+{
+    return byte >= 'A' && byte <= 'Z' ? byte | 0x20 : byte;
+}
+
+TrigramIndex::~TrigramIndex()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void TrigramIndex::Document::reset(size_t rows)
+{
+    blocks.assign((rows + BLOCK_ROWS - 1) / BLOCK_ROWS, Block());
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        blocks[b].first = b * BLOCK_ROWS;
+        blocks[b].rows = std::min<size_t>(BLOCK_ROWS, rows - b * BLOCK_ROWS);
+    }
+    postings.clear();
+    unsorted.clear();
+    pending = blocks.size();
+    stale = 0;
+    entries = 0;
+    next = 0;
+    ++epoch;
+    started = clock::now();
+    build_ms = 0;
+}
+
+size_t TrigramIndex::Document::block_of(size_t row) const
+{
+    // The last block starting at or before the row: empty blocks before it share its first row
+    auto after = std::upper_bound(blocks.begin(), blocks.end(), row, [](size_t r, const Block& block) { return r < block.first; });
+    return after == blocks.begin() ? 0 : after - blocks.begin() - 1;
+}
+
+void TrigramIndex::Document::dirty(size_t block)
+{
+    Block& changed = blocks[block];
+    ++changed.generation;
+    if (changed.indexed) {
+        changed.indexed = false;
+        ++pending;
+        ++stale;
+    }
+    next = std::min(next, block);
+}
+
+TrigramIndex::Document* TrigramIndex::sync(const textBuffer& text)
+{
+    Document* document = documents.find(text.getId());
+    if (!document || document->version == text.getVersion()) {
+        return document;
+    }
+
+    size_t rows = text.get_buffer().size();
+    bool start_over = !text.edits_since(document->version, edits) || document->blocks.empty();
+    document->version = text.getVersion();
+    std::vector<Block>& blocks = document->blocks;
+
+    for (size_t i = 0; i < edits.size() && !start_over; ++i) {
+        const BufferEdit& edit = edits[i];
+        size_t row = edit.row;
+        size_t count = edit.count;
+        switch (edit.kind) {
+            case BufferEdit::CHANGE:
+                document->dirty(document->block_of(row));
+                break;
+            case BufferEdit::INSERT: {
+                size_t b = document->block_of(row);
+                blocks[b].rows += count;
+                document->dirty(b);
+                for (size_t later = b + 1; later < blocks.size(); ++later) blocks[later].first += count;
+                start_over = blocks[b].rows > MAX_BLOCK_ROWS;
+                break;
+            }
+            case BufferEdit::ERASE: {
+                size_t b = document->block_of(row);
+                size_t touched = b;
+                for (size_t at = row, left = count; left > 0 && b < blocks.size(); ++b) {
+                    size_t end = blocks[b].first + blocks[b].rows;
+                    if (end <= at) continue;
+                    size_t taken = std::min(left, end - at);
+                    blocks[b].rows -= taken;
+                    document->dirty(b);
+                    left -= taken;
+                    at = end;
+                }
+                for (size_t later = touched + 1; later < blocks.size(); ++later) {
+                    blocks[later].first = blocks[later - 1].first + blocks[later - 1].rows;
+                }
+                break;
+            }
+            case BufferEdit::RESET:
+                start_over = true;
+                break;
+        }
+    }
+
+    // Too many blocks left old entries in the lists, or the blocks lost track of the rows
+    if (start_over || document->stale > blocks.size() / 2 || blocks.back().first + blocks.back().rows != rows) {
+        document->reset(rows);
+    }
+    return document;
+}
+
+void TrigramIndex::post(const textBuffer& text, Document& document)
+{
+    const auto& lines = text.get_buffer();
+    Job job{text.getId(), document.epoch, {}, {}, {}, {}};
+    for (size_t b = document.next; b < document.blocks.size() && job.blocks.size() < JOB_BLOCKS; ++b) {
+        Block& block = document.blocks[b];
+        if (block.indexed || block.queued) {
+            if (job.blocks.empty()) document.next = b + 1;
+            continue;
+        }
+        block.queued = true;
+        job.blocks.push_back(b);
+        job.generations.push_back(block.generation);
+        job.rows.insert(job.rows.end(), lines.begin() + block.first, lines.begin() + block.first + block.rows);
+        job.ends.push_back(job.rows.size());
+    }
+    if (!job.blocks.empty()) {
+        document.next = job.blocks.back() + 1;
+        jobs.push_back(std::move(job));
+    }
+}
+
+bool TrigramIndex::schedule(const textBuffer& text)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    Document* document = sync(text);
+    if (!document) {
+        size_t rows = text.get_buffer().size();
+        if (search_index_rows == 0 || rows < search_index_rows) {
+            return false;
+        }
+        document = &documents.get(text.getId());
+        document->version = text.getVersion();
+        document->reset(rows);
+    }
+
+    EditorStats& stats = EditorStats::instance();
+    stats.index_bytes = memory(*document);
+    stats.index_build_ms = (unsigned long)document->build_ms;
+    if (document->pending == 0) {
+        return false;
+    }
+
+    while (jobs.size() < QUEUED_JOBS && document->next < document->blocks.size()) {
+        post(text, *document);
+    }
+    if (!worker.joinable()) {
+        worker = std::thread(&TrigramIndex::run, this);
+    }
+    wake.notify_one();
+    return true;
+}
+
+bool TrigramIndex::candidates(const textBuffer& text, const std::vector<std::string>& literals, std::vector<int>& rows)
+{
+    std::vector<uint32_t> keys;
+    for (const std::string& literal : literals) {
+        for (size_t i = 0; i + 2 < literal.size(); ++i) {
+            keys.push_back((uint32_t)(unsigned char)literal[i] << 16 | (uint32_t)(unsigned char)literal[i + 1] << 8 | (unsigned char)literal[i + 2]);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    if (keys.empty()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    Document* document = sync(text);
+    if (!document) {
+        return false;
+    }
+
+    // The blocks in the lists of every trigram, from the shortest list on
+    std::vector<const std::vector<uint32_t>*> lists;
+    bool missing = false;
+    for (uint32_t key : keys) {
+        auto list = document->postings.find(key);
+        if (list == document->postings.end()) {
+            missing = true;
+            break;
+        }
+        if (document->unsorted.erase(key)) {
+            std::vector<uint32_t>& blocks = list->second;
+            size_t before = blocks.size();
+            std::sort(blocks.begin(), blocks.end());
+            blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+            document->entries -= before - blocks.size();
+        }
+        lists.push_back(&list->second);
+    }
+    std::vector<uint32_t> matched, kept;
+    if (!missing) {
+        std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) { return a->size() < b->size(); });
+        matched = *lists.front();
+        for (size_t k = 1; k < lists.size() && !matched.empty(); ++k) {
+            const std::vector<uint32_t>& list = *lists[k];
+            kept.clear();
+            if (matched.size() * 16 < list.size()) {
+                // Few blocks left: look each one up
+                auto from = list.begin();
+                for (uint32_t block : matched) {
+                    from = std::lower_bound(from, list.end(), block);
+                    if (from != list.end() && *from == block) kept.push_back(block);
+                }
+            } else {
+                std::set_intersection(matched.begin(), matched.end(), list.begin(), list.end(), std::back_inserter(kept));
+            }
+            matched.swap(kept);
+        }
+    }
+
+    // Those, and the blocks not indexed yet
+    const std::vector<Block>& blocks = document->blocks;
+    std::vector<uint32_t> chosen;
+    size_t count = 0;
+    for (size_t b = 0, m = 0; b < blocks.size(); ++b) {
+        while (m < matched.size() && matched[m] < b) ++m;
+        if (!blocks[b].indexed || (m < matched.size() && matched[m] == b)) {
+            chosen.push_back(b);
+            count += blocks[b].rows;
+        }
+    }
+    if (count > text.get_buffer().size() / 4) {
+        return false;   // not worth a list of rows
+    }
+
+    rows.clear();
+    rows.reserve(count);
+    for (uint32_t b : chosen) {
+        for (uint32_t row = blocks[b].first; row < blocks[b].first + blocks[b].rows; ++row) rows.push_back(row);
+    }
+    return true;
+}
+
+void TrigramIndex::wait_idle()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    idle.wait(guard, [&]() { return jobs.empty() && !busy; });
+}
+
+size_t TrigramIndex::bytes(const textBuffer& text)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    Document* document = documents.find(text.getId());
+    return document ? memory(*document) : 0;
+}
+
+size_t TrigramIndex::memory(const Document& document)
+{
+    // The lists, a map node for each, and the blocks
+    const size_t per_list = sizeof(std::pair<const uint32_t, std::vector<uint32_t>>) + 2 * sizeof(void*);
+    return document.entries * sizeof(uint32_t) + document.postings.size() * per_list + document.blocks.size() * sizeof(Block);
+}
+
+void TrigramIndex::run()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    std::vector<uint64_t> seen((1 << 24) / 64);   // a bit per trigram, set while a block is read
+    std::vector<std::vector<uint32_t>> found;
+
+    while (true) {
+        wake.wait(guard, [&]() { return stopping || !jobs.empty(); });
+        if (stopping) {
+            return;
+        }
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        busy = true;
+        guard.unlock();
+
+        // The distinct trigrams of each block
+        found.resize(job.blocks.size());
+        size_t row = 0;
+        for (size_t i = 0; i < job.blocks.size(); ++i) {
+            std::vector<uint32_t>& keys = found[i];
+            keys.clear();
+            for (; row < job.ends[i]; ++row) {
+                const std::string& line = job.rows[row];
+                uint32_t key = 0;
+                for (size_t j = 0; j < line.size(); ++j) {
+                    key = (key << 8 | folded(line[j])) & 0xFFFFFF;
+                    if (j < 2 || (seen[key >> 6] >> (key & 63) & 1)) continue;
+                    seen[key >> 6] |= 1ull << (key & 63);
+                    keys.push_back(key);
+                }
+            }
+            for (uint32_t key : keys) seen[key >> 6] &= ~(1ull << (key & 63));
+        }
+
+        guard.lock();
+        Document* document = documents.find(job.document);
+        if (document && document->epoch == job.epoch) {
+            for (size_t i = 0; i < job.blocks.size(); ++i) {
+                uint32_t b = job.blocks[i];
+                for (uint32_t key : found[i]) {
+                    std::vector<uint32_t>& list = document->postings[key];
+                    if (!list.empty() && list.back() == b) continue;
+                    if (!list.empty() && list.back() > b) document->unsorted.insert(key);
+                    list.push_back(b);
+                    ++document->entries;
+                }
+
+                // Its rows changed while they were read: indexed again later
+                Block& block = document->blocks[b];
+                block.queued = false;
+                if (block.generation == job.generations[i]) {
+                    block.indexed = true;
+                    --document->pending;
+                } else {
+                    document->next = std::min<size_t>(document->next, b);
+                }
+            }
+            if (document->pending == 0 && document->build_ms == 0) {
+                document->build_ms = std::chrono::duration<double, std::milli>(clock::now() - document->started).count();
+            }
+        }
+        busy = false;
+        if (jobs.empty()) {
+            idle.notify_all();
+        }
+    }
+}
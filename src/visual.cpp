@@ -1,6 +1,10 @@
 #include "../include/editor.hpp"
 #include "../include/syntax.hpp"
 #include "../include/clipboardManager.hpp"
+#include "../include/screen.hpp"
+#include "../include/softWrap.hpp"
+#include "../include/bracketIndex.hpp"
+#include <algorithm>
 
 // Check if the character before the found position is a valid boundary (whitespace or delimiter)
 #define IS_LEFT_BOUNDARY_VALID(pos) \
@@ -11,11 +15,52 @@
   ((pos + len == buffer_row.size()) || isspace(buffer_row[pos + len]) || \
    strchr("(){}[]", buffer_row[pos + len]) || strchr("+-*/%=", buffer_row[pos + len]))
 
-#define IS_VISIBLE_HORIZONTALLY(c) (c >= starting_col && c < starting_col+max_col)
 
+// Wrapped rows: recolor the selection one screen line at a time.
+// Columns are window columns, as in highlight(), and both ends are included.
+static void highlight_wrapped(int start_row, int end_row, int start_col, int end_col, color highlight_color)
+{
+  if (start_row > end_row || (start_row == end_row && start_col > end_col))
+  {
+    std::swap(start_row, end_row);
+    std::swap(start_col, end_col);
+  }
+  start_col = std::max(start_col - (span + 1), 0);
+  end_col = std::max(end_col - (span + 1), 0);
+
+  SoftWrap& wrap = SoftWrap::instance();
+  Surface& surface = Screen::getScreen().surface();
+
+  for (int row = std::max(start_row, (int)starting_row); row <= end_row && row < buffer.getSize(); ++row)
+  {
+    size_t from = (row == start_row) ? start_col : 0;
+    size_t to = (row == end_row) ? end_col : buffer[row].length();
+
+    while (from <= to)
+    {
+      // The part of [from, to] on the screen line of `from`
+      size_t line_end = (from / max_col + 1) * max_col - 1;
+      size_t last = std::min(to, line_end);
+
+      int y, x;
+      if (!wrap.position(row, from, y, x))
+      {
+        return;   // below the window
+      }
+      surface.recolor(y, x, last - from + 1, A_NORMAL, highlight_color);
+      from = last + 1;
+    }
+  }
+}
 
 void editor::visual::highlight(int start_row, int end_row, int start_col, int end_col, color highlight_color)
 {
+  if (soft_wrap)
+  {
+    highlight_wrapped(start_row, end_row, start_col, end_col, highlight_color);
+    return;
+  }
+
   int curr_row, curr_start_col, curr_end_col;
 
   // Ensure the highlighting respects the visible range
@@ -61,9 +106,9 @@ void editor::visual::highlight(int start_row, int end_row, int start_col, int en
     int highlight_length = (curr_end_col != curr_start_col) ? abs(curr_end_col - curr_start_col) + 1 : 1;
 
     // Highlight the current row
-    mvwchgat(pointed_window,curr_row - starting_row,
+    Screen::getScreen().surface().recolor(curr_row - starting_row,
             std::min(curr_start_col, curr_end_col),
-            highlight_length, A_NORMAL, highlight_color, NULL);
+            highlight_length, A_NORMAL, highlight_color);
   }
 }
 
@@ -86,123 +131,264 @@ void editor::visual::highlight_row_portion(int row, int start_col, int end_col,
   highlight(row, row, start_col, end_col ,color_scheme);
 }
 
-void editor::visual::highlight_keywords()
+// One cell of the buffer, if it is in the window
+static void highlight_cell(size_t row, size_t col, color highlight_color)
+{
+  if (row < starting_row || row >= starting_row + max_row)
+  {
+    return;
+  }
+  if (!soft_wrap && (col < starting_col || col >= starting_col + max_col))
+  {
+    return;
+  }
+  editor::visual::highlight(row, row, col + span + 1, col + span + 1, highlight_color);
+}
+
+void editor::visual::highlight_matching_bracket()
+{
+  if (mode != Mode::normal && mode != Mode::insert)
+  {
+    return;
+  }
+
+  const Language* lang = SyntaxHighlighter::instance().getCurrentLanguage();
+  if (!lang || pointed_row >= (size_t)buffer.getSize())
+  {
+    return;
+  }
+
+  const std::string& row = buffer[pointed_row];
+  size_t col = pointed_col;
+  auto is_bracket = [&](size_t c) { return c < row.length() && lang->brackets.find(row[c]) != std::string::npos; };
+  if (!is_bracket(col))
+  {
+    // While typing, the bracket just written
+    if (mode != Mode::insert || col == 0 || !is_bracket(col - 1))
+    {
+      return;
+    }
+    col--;
+  }
+
+  BracketPair pair;
+  if (BracketIndex::instance().match(buffer, pointed_row, col, pair))
+  {
+    highlight_cell(pair.open_row, pair.open_col, highlightedTextColor);
+    highlight_cell(pair.close_row, pair.close_col, highlightedTextColor);
+  }
+}
+
+// Paint colors[from, to) with the given color, clipped to the row
+static void paint(std::vector<color>& colors, size_t from, size_t to, color c)
+{
+  to = std::min(to, colors.size());
+  for (size_t i = from; i < to; ++i)
+  {
+    colors[i] = c;
+  }
+}
+
+void editor::visual::style_keyword_groups(const Language& lang, const std::string& buffer_row, std::vector<color>& colors)
+{
+  struct Hit
+  {
+    size_t pos;
+    size_t len;
+    int group;
+  };
+  static thread_local std::vector<Hit> hits;
+  hits.clear();
+
+  lang.keywordMatcher.scan(buffer_row, [&](size_t found_pos, size_t keyword_len, int group)
+  {
+    // Use existing boundary checks
+    if (IS_LEFT_BOUNDARY_VALID(found_pos) && IS_RIGHT_BOUNDARY_VALID(found_pos, keyword_len))
+    {
+      hits.push_back({found_pos, keyword_len, group});
+    }
+  });
+
+  // Paint group by group, as the search below does
+  std::stable_sort(hits.begin(), hits.end(), [](const Hit& a, const Hit& b) { return a.group < b.group; });
+  for (const Hit& hit : hits)
+  {
+    paint(colors, hit.pos, hit.pos + hit.len, *lang.syntaxGroups[hit.group].color);
+  }
+}
+
+void editor::visual::style_keyword_groups_by_search(const Language& lang, const std::string& buffer_row, std::vector<color>& colors)
+{
+  for (const auto& group : lang.syntaxGroups)
+  {
+    for (const std::string& keyword : group.keywords)
+    {
+      size_t keyword_len = keyword.length();
+      size_t found_pos = buffer_row.find(keyword);
+
+      while (found_pos != std::string::npos)
+      {
+        // Use existing boundary checks
+        if (IS_LEFT_BOUNDARY_VALID(found_pos) && IS_RIGHT_BOUNDARY_VALID(found_pos, keyword_len))
+        {
+          paint(colors, found_pos, found_pos + keyword_len, *group.color);
+        }
+        found_pos = buffer_row.find(keyword, found_pos + keyword_len);
+      }
+    }
+  }
+}
+
+void editor::visual::style_tokens(const Language& lang, const std::string& buffer_row, std::vector<color>& colors, bool& in_comment,
+                                   size_t first, size_t last)
+{
+  if (lang.lexer.empty()) return;
+
+  in_comment = lang.lexer.scan(buffer_row, first, last, in_comment, [&](size_t from, size_t to, TokenLexer::Token token)
+  {
+    switch (token)
+    {
+      case TokenLexer::Token::COMMENT:
+        paint(colors, from, to, commentsColor);
+        break;
+      case TokenLexer::Token::STRING:
+        paint(colors, from, to, stringColor);
+        break;
+      case TokenLexer::Token::NUMBER:
+        paint(colors, from, to, numberColor);
+        break;
+      case TokenLexer::Token::TYPE:
+        // Keywords that look like types (True, None...) keep their color
+        if (colors[from] == textColor)
+        {
+          paint(colors, from, to, typeColor);
+        }
+        break;
+      default:
+        break;
+    }
+  });
+}
+
+void editor::visual::style_keywords(const std::string& buffer_row, std::vector<color>& colors, bool& in_comment, size_t from, size_t to)
 {
   // 1. Get the current language rules
   const Language* lang = SyntaxHighlighter::instance().getCurrentLanguage();
-  
+
   // If no language is detected (plain text), do nothing
   if (!lang) return;
 
-  int visible_start_row = starting_row;
-  int visible_end_row = std::min((int)(starting_row + max_row), buffer.getSize() - 1);
+  style_row(*lang, buffer_row, colors, in_comment, from, to);
+}
 
-  for (int row = visible_start_row; row <= visible_end_row; ++row)
+static void style_brackets(const Language& lang, const std::string& buffer_row, std::vector<color>& colors)
+{
+  for (char bracketChar : lang.brackets)
   {
-    std::string& buffer_row = buffer[row];
+    size_t found_pos = buffer_row.find(bracketChar);
 
-    /* 2. Highlight Keywords Groups */
-    for (const auto& group : lang->syntaxGroups)
+    while (found_pos != std::string::npos)
     {
-        for (const std::string& keyword : group.keywords)
-        {
-            size_t keyword_len = keyword.length();
-            size_t found_pos = buffer_row.find(keyword);
-
-            while (found_pos != std::string::npos)
-            {
-                // Use existing boundary checks
-                if (IS_LEFT_BOUNDARY_VALID(found_pos) && IS_RIGHT_BOUNDARY_VALID(found_pos, keyword_len))        
-                {
-                    editor::visual::highlight_row_portion(row,
-                                                          found_pos + span + 1,
-                                                          found_pos + keyword_len + span,
-                                                          group.color);
-                }
-                found_pos = buffer_row.find(keyword, found_pos + keyword_len);
-            }
-        }
+      colors[found_pos] = bracketsColor;
+      found_pos = buffer_row.find(bracketChar, found_pos + 1);
     }
+  }
+}
+
+void editor::visual::style_row(const Language& lang, const std::string& buffer_row, std::vector<color>& colors, bool& in_comment, size_t from, size_t to)
+{
+  to = std::min(to, buffer_row.size());
+  if (from == 0 && to == buffer_row.size())
+  {
+    /* 2. Highlight Keywords Groups */
+    style_keyword_groups(lang, buffer_row, colors);
 
     /* 3. Highlight Brackets */
-    if (!lang->brackets.empty()) {
-        for (char bracketChar : lang->brackets) {
-            // Convert char to string for find
-            std::string bracket(1, bracketChar); 
-            size_t found_pos = buffer_row.find(bracket);
-
-            while (found_pos != std::string::npos)
-            {
-                editor::visual::highlight_row_portion(row, 
-                                                      found_pos + span + 1,
-                                                      found_pos + span + 1, 
-                                                      bracketsColor);
-
-                found_pos = buffer_row.find(bracket, found_pos + 1);
-            }
-        }
+    style_brackets(lang, buffer_row, colors);
+  }
+  else if (from < to)
+  {
+    // Only part of the row is shown: keywords and brackets need no state,
+    // so they are looked for in that part alone
+    static thread_local std::string part;
+    static thread_local std::vector<color> part_colors;
+    part.assign(buffer_row, from, to - from);
+    part_colors.assign(part.size(), textColor);
+    style_keyword_groups(lang, part, part_colors);
+    style_brackets(lang, part, part_colors);
+    std::copy(part_colors.begin(), part_colors.end(), colors.begin() + from);
+  }
+
+  /* 4. Highlight Comments, Strings, Numbers and Types */
+  if (!lang.lexer.empty())
+  {
+    style_tokens(lang, buffer_row, colors, in_comment, from, to);
+    return;
+  }
+
+  /* 5. Without a lexer, Highlight Single Line Comments */
+  if (!lang.singleLineComment.empty())
+  {
+    size_t single_line_comment_pos = buffer_row.find(lang.singleLineComment);
+
+    if (single_line_comment_pos != std::string::npos)
+    {
+      paint(colors, single_line_comment_pos, buffer_row.size(), commentsColor);
     }
+  }
 
-    /* 4. Highlight Single Line Comments */
-    if (!lang->singleLineComment.empty()) {
-        size_t single_line_comment_pos = buffer_row.find(lang->singleLineComment);
+  /* 6. Highlight Multi-line Comments */
+  style_block_comments(lang, buffer_row, &colors, in_comment);
+}
 
-        if (single_line_comment_pos != std::string::npos)
-        {
-            // FIX: Check visibility >= 0. Also check if comment starts BEFORE screen ( < starting_col)
-            // If it starts before, it extends into view, so we highlight it.
-            if(IS_VISIBLE_HORIZONTALLY(single_line_comment_pos) || single_line_comment_pos < starting_col){ 
-                editor::visual::highlight_row_portion(row,
-                                                      single_line_comment_pos + span + 1,
-                                                      buffer_row.size() + span, 
-                                                      commentsColor);
-            }
-        }
+void editor::visual::style_block_comments(const Language& lang, const std::string& buffer_row, std::vector<color>* colors, bool& in_comment)
+{
+  // The lexer knows which delimiters are inside strings
+  if (!lang.lexer.empty())
+  {
+    if (!colors)
+    {
+      in_comment = lang.lexer.ends_in_comment(buffer_row, in_comment);
+      return;
     }
+    in_comment = lang.lexer.scan(buffer_row, 0, buffer_row.size(), in_comment, [&](size_t from, size_t to, TokenLexer::Token token)
+    {
+      if (token == TokenLexer::Token::COMMENT) paint(*colors, from, to, commentsColor);
+    });
+    return;
+  }
 
-    /* 5. Highlight Multi-line Comments */
-    if (!lang->multiLineCommentStart.empty() && !lang->multiLineCommentEnd.empty()) {
-        size_t multi_start = buffer_row.find(lang->multiLineCommentStart);
-        size_t multi_end = buffer_row.find(lang->multiLineCommentEnd, multi_start);
+  const std::string& open = lang.multiLineCommentStart;
+  const std::string& close = lang.multiLineCommentEnd;
+  if (open.empty() || close.empty()) return;
 
-        // Case A: Start and End on same line
-        if (multi_start != std::string::npos && multi_end != std::string::npos)
-        {
-            editor::visual::highlight_row_portion(row, 
-                                                  multi_start + span + 1,
-                                                  multi_end + lang->multiLineCommentEnd.length() + span,
-                                                  commentsColor);
-        }
-        // Case B: Starts on this line, ends later
-        else if (multi_start != std::string::npos)
-        {
-            // Highlight rest of this line
-            editor::visual::highlight_row_portion(row,
-                                                  multi_start + span + 1,
-                                                  buffer_row.size() + span, 
-                                                  commentsColor);
-
-            // Highlight subsequent lines until end token found
-            int next_row = row + 1;
-            while (next_row <= visible_end_row && buffer[next_row].find(lang->multiLineCommentEnd) == std::string::npos)
-            {
-                editor::visual::highlight_row_portion(next_row,
-                                                      span + 1,
-                                                      buffer[next_row].size() + span, 
-                                                      commentsColor);
-                next_row++;
-            }
-
-            // Highlight the closing line if visible
-            if (next_row <= visible_end_row)
-            {
-                size_t end_pos_next = buffer[next_row].find(lang->multiLineCommentEnd);
-                editor::visual::highlight_row_portion(next_row, 
-                                                      span + 1,
-                                                      end_pos_next + lang->multiLineCommentEnd.length() + span, 
-                                                      commentsColor);
-            }
-        }
+  size_t pos = 0;
+  while (pos <= buffer_row.size())
+  {
+    size_t comment_start = pos;
+
+    // The row does not start inside a comment: look for the next opening token
+    if (!in_comment)
+    {
+      comment_start = buffer_row.find(open, pos);
+      if (comment_start == std::string::npos) return;
+      pos = comment_start + open.length();
+    }
+
+    // Case A: the comment ends on this row
+    size_t comment_end = buffer_row.find(close, pos);
+    if (comment_end != std::string::npos)
+    {
+      if (colors) paint(*colors, comment_start, comment_end + close.length(), commentsColor);
+      in_comment = false;
+      pos = comment_end + close.length();
+    }
+    // Case B: the comment continues on the next rows
+    else
+    {
+      if (colors) paint(*colors, comment_start, buffer_row.size(), commentsColor);
+      in_comment = true;
+      return;
     }
   }
 }
@@ -0,0 +1,23 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <string>
+#include "../include/syntax.hpp"
+
+// The language files at the top of the repository, found from this file
+// rather than from the directory the tests are run in
+inline std::filesystem::path test_languages_dir() {
+    return std::filesystem::absolute(__FILE__).parent_path().parent_path() / "languages";
+}
+
+// Indexes the languages of the repository and sets the one of `file`;
+// a missing language fails the test, it is not skipped
+inline ::testing::AssertionResult use_test_language(const std::string& file) {
+    SyntaxHighlighter& syntax = SyntaxHighlighter::instance();
+    syntax.indexLanguages(test_languages_dir());
+    syntax.setLanguageFromFile(file);
+    if (!syntax.getCurrentLanguage()) {
+        return ::testing::AssertionFailure() << "no language for " << file << " in " << test_languages_dir();
+    }
+    return ::testing::AssertionSuccess();
+}
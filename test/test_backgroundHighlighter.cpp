@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include "../include/backgroundHighlighter.hpp"
+#include "../include/syntaxState.hpp"
+#include "../include/syntax.hpp"
+#include "../include/editor.hpp"
+#include "../include/editorStats.hpp"
+#include "testLanguages.hpp"
+
+class BackgroundHighlighterTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(use_test_language("background.c"));
+
+        textColor = 1;
+        keyWordColor = 2;
+        commentsColor = 3;
+        stringColor = 4;
+        numberColor = 5;
+
+        // A block comment across two jobs, so states must carry between them
+        buffer.clear();
+        for (int i = 0; i < 3000; ++i) {
+            buffer.push_back(i == 400 ? "/* opened" : i == 700 ? "closed */ int y;" : "int x = \"s\" + " + std::to_string(i) + ";");
+        }
+    }
+
+    void fill() {
+        BackgroundHighlighter& highlighter = BackgroundHighlighter::instance();
+        do {
+            highlighter.schedule(buffer, 1000);
+            highlighter.wait_idle();
+        } while (highlighter.missing_rows() > 0);
+    }
+
+    // Every cached row has the colors of a row styled in the frame
+    void expect_rows_match() {
+        for (size_t row = 0; row < (size_t)buffer.getSize(); ++row) {
+            bool start = SyntaxStateCache::instance().state_before(buffer, row);
+            std::vector<color> expected(buffer[row].length(), textColor);
+            bool expected_end = start;
+            editor::visual::style_keywords(buffer[row], expected, expected_end);
+
+            std::vector<color> cached;
+            bool cached_end;
+            ASSERT_TRUE(BackgroundHighlighter::instance().lookup(buffer, row, start, cached, cached_end)) << row;
+            ASSERT_EQ(cached, expected) << row;
+            ASSERT_EQ(cached_end, expected_end) << row;
+        }
+    }
+};
+
+TEST_F(BackgroundHighlighterTest, StylesTheWholeDocument) {
+    fill();
+    EXPECT_EQ(BackgroundHighlighter::instance().missing_rows(), 0u);
+    expect_rows_match();
+}
+
+TEST_F(BackgroundHighlighterTest, EditsDropOnlyTheirRows) {
+    BackgroundHighlighter& highlighter = BackgroundHighlighter::instance();
+    fill();
+
+    buffer.set_row(100, "return 0;");
+    buffer.new_row("char c;", 50);
+    buffer.del_row(2000);
+
+    std::vector<color> colors;
+    bool end;
+    EXPECT_EQ(highlighter.missing_rows(), 0u);  // not synced yet
+    EXPECT_FALSE(highlighter.lookup(buffer, 50, false, colors, end));
+    EXPECT_FALSE(highlighter.lookup(buffer, 101, false, colors, end));
+    EXPECT_EQ(highlighter.missing_rows(), 2u);
+    EXPECT_TRUE(highlighter.lookup(buffer, 2500, false, colors, end));
+
+    fill();
+    expect_rows_match();
+}
+
+TEST_F(BackgroundHighlighterTest, ResultsOfAnOlderVersionAreDropped) {
+    BackgroundHighlighter& highlighter = BackgroundHighlighter::instance();
+
+    // The worker styles rows that are edited before its results come back
+    highlighter.schedule(buffer, 0);
+    for (int i = 0; i < 50; ++i) buffer.set_row(i * 40, "/* comment */ long z;");
+    buffer.new_row("*/", 10);
+    highlighter.wait_idle();
+
+    fill();
+    expect_rows_match();
+}
+
+TEST_F(BackgroundHighlighterTest, SwitchingBuffersKeepsTheirCaches) {
+    BackgroundHighlighter& highlighter = BackgroundHighlighter::instance();
+    fill();
+    expect_rows_match();
+
+    // A second buffer with another language, as BufferManager swaps them in
+    textBuffer source = buffer;
+    const Language* c = pointed_language;
+    textBuffer script;
+    for (int i = 0; i < 2000; ++i) script.push_back("echo \"$x\" # " + std::to_string(i));
+    buffer = script;
+    SyntaxHighlighter::instance().setLanguageFromFile("background.sh");
+    ASSERT_NE(pointed_language, nullptr) << "no Bash language file";
+    fill();
+    expect_rows_match();
+    const Language* sh = pointed_language;
+    script = buffer;
+
+    // Back to the first one: nothing is lexed or styled again
+    EditorStats& stats = EditorStats::instance();
+    unsigned long lexed = stats.rows_lexed;
+    unsigned long highlighted = stats.rows_highlighted;
+    buffer = source;
+    pointed_language = c;
+    highlighter.schedule(buffer, 1000);
+    EXPECT_EQ(highlighter.missing_rows(), 0u);
+    expect_rows_match();
+
+    buffer = script;
+    pointed_language = sh;
+    highlighter.schedule(buffer, 0);
+    EXPECT_EQ(highlighter.missing_rows(), 0u);
+    expect_rows_match();
+
+    EXPECT_EQ(stats.rows_lexed, lexed);
+    EXPECT_EQ(stats.rows_highlighted, highlighted);
+}
+
+/*
+    g++ -std=c++17 -o test_background_highlighter test_backgroundHighlighter.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
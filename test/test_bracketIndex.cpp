@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../include/bracketIndex.hpp"
+#include "../include/syntax.hpp"
+#include "testLanguages.hpp"
+
+class BracketIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(use_test_language("brackets.c"));
+
+        commentsColor = 3;
+        buffer.clear();
+    }
+
+    void set_text(const std::vector<std::string>& rows) {
+        buffer.clear();
+        for (const std::string& row : rows) buffer.push_back(row);
+    }
+
+    // The pair of every bracket of a buffer without comments or strings, with a stack
+    std::map<std::pair<size_t, size_t>, BracketPair> pairs_by_stack() {
+        const std::string brackets = "()[]{}";
+        std::map<std::pair<size_t, size_t>, BracketPair> pairs;
+        std::vector<std::pair<size_t, size_t>> open;
+        for (size_t row = 0; row < (size_t)buffer.getSize(); ++row) {
+            const std::string& text = buffer[row];
+            for (size_t col = 0; col < text.size(); ++col) {
+                size_t k = brackets.find(text[col]);
+                if (k == std::string::npos) continue;
+                if (k % 2 == 0) {
+                    open.push_back({row, col});
+                } else if (!open.empty()) {
+                    auto from = open.back();
+                    open.pop_back();
+                    if (brackets.find(buffer[from.first][from.second]) + 1 == k) {
+                        BracketPair pair{from.first, from.second, row, col};
+                        pairs[from] = pair;
+                        pairs[{row, col}] = pair;
+                    }
+                }
+            }
+        }
+        return pairs;
+    }
+
+    void expect_matches_stack() {
+        auto expected = pairs_by_stack();
+        BracketIndex& index = BracketIndex::instance();
+        const std::string brackets = "()[]{}";
+        for (size_t row = 0; row < (size_t)buffer.getSize(); ++row) {
+            const std::string& text = buffer[row];
+            for (size_t col = 0; col < text.size(); ++col) {
+                if (brackets.find(text[col]) == std::string::npos) continue;
+                BracketPair pair;
+                bool found = index.match(buffer, row, col, pair);
+                auto it = expected.find({row, col});
+                ASSERT_EQ(found, it != expected.end()) << row << ":" << col;
+                if (found) {
+                    ASSERT_EQ(pair.open_row, it->second.open_row) << row << ":" << col;
+                    ASSERT_EQ(pair.open_col, it->second.open_col) << row << ":" << col;
+                    ASSERT_EQ(pair.close_row, it->second.close_row) << row << ":" << col;
+                    ASSERT_EQ(pair.close_col, it->second.close_col) << row << ":" << col;
+                }
+            }
+        }
+    }
+
+    // Every bracket matches as it does in an index built from scratch for the same rows
+    void expect_matches_fresh() {
+        textBuffer fresh;
+        fresh.clear();
+        for (const std::string& row : buffer.get_buffer()) fresh.push_back(row);
+        BracketIndex& index = BracketIndex::instance();
+        for (size_t row = 0; row < (size_t)buffer.getSize(); ++row) {
+            for (size_t col = 0; col < buffer[row].size(); ++col) {
+                BracketPair pair, expected;
+                bool found = index.match(buffer, row, col, pair);
+                ASSERT_EQ(found, index.match(fresh, row, col, expected)) << row << ":" << col;
+                if (found) {
+                    ASSERT_EQ(pair.open_row, expected.open_row) << row << ":" << col;
+                    ASSERT_EQ(pair.close_row, expected.close_row) << row << ":" << col;
+                    ASSERT_EQ(pair.close_col, expected.close_col) << row << ":" << col;
+                }
+            }
+        }
+    }
+};
+
+TEST_F(BracketIndexTest, MatchesAcrossRows) {
+    set_text({"int f(int a) {", "  if (a[0]) {", "    return 1;", "  }", "}"});
+
+    BracketPair pair;
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 13, pair));
+    EXPECT_EQ(pair.close_row, 4u);
+    EXPECT_EQ(pair.close_col, 0u);
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 3, 2, pair));
+    EXPECT_EQ(pair.open_row, 1u);
+    EXPECT_EQ(pair.open_col, 12u);
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 1, 7, pair));
+    EXPECT_EQ(pair.close_row, 1u);
+    EXPECT_EQ(pair.close_col, 9u);
+    EXPECT_FALSE(BracketIndex::instance().match(buffer, 2, 4, pair));  // not a bracket
+
+    ASSERT_TRUE(BracketIndex::instance().enclosing(buffer, 2, 4, pair));
+    EXPECT_EQ(pair.open_row, 1u);
+    EXPECT_EQ(pair.close_row, 3u);
+    ASSERT_TRUE(BracketIndex::instance().enclosing(buffer, 1, 12, pair));  // on an opening bracket: the outer block
+    EXPECT_EQ(pair.open_row, 0u);
+    EXPECT_EQ(pair.close_row, 4u);
+    EXPECT_FALSE(BracketIndex::instance().enclosing(buffer, 0, 0, pair));
+}
+
+TEST_F(BracketIndexTest, SkipsCommentsAndStrings) {
+    set_text({"{ s = \"}\"; // }", "/* {", "} */ (x]", "}"});
+
+    BracketPair pair;
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 0, pair));
+    EXPECT_EQ(pair.close_row, 3u);
+    EXPECT_FALSE(BracketIndex::instance().match(buffer, 0, 7, pair));   // in a string
+    EXPECT_FALSE(BracketIndex::instance().match(buffer, 1, 3, pair));   // in a comment
+    EXPECT_FALSE(BracketIndex::instance().match(buffer, 2, 5, pair));   // closed by another kind
+
+    // A quote inside a comment opens no string, on the row of the comment or below it
+    set_text({"/* don't */ if (x) { y = 5; }", "/* it's", "*/ f(\"//\");"});
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 15, pair));
+    EXPECT_EQ(pair.close_col, 17u);
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 2, 4, pair));
+    EXPECT_EQ(pair.close_col, 9u);
+
+    // A comment opened above hides the brackets below it until it is closed
+    set_text({"{", "x", "}"});
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 0, pair));
+    buffer.set_row(0, "{ /*");
+    EXPECT_FALSE(BracketIndex::instance().match(buffer, 0, 0, pair));
+    buffer.set_row(1, "x */");
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 0, pair));
+    EXPECT_EQ(pair.close_row, 2u);
+}
+
+TEST_F(BracketIndexTest, FollowsEditsAsAStack) {
+    std::mt19937 random(7);
+    auto random_row = [&]() {
+        const std::string chars = "(){}[]  ab";
+        std::string row;
+        size_t length = random() % 12;
+        for (size_t i = 0; i < length; ++i) row += chars[random() % chars.size()];
+        return row;
+    };
+
+    std::vector<std::string> rows;
+    for (int i = 0; i < 250; ++i) rows.push_back(random_row());  // grows past 256 rows
+    set_text(rows);
+    expect_matches_stack();
+
+    for (int step = 0; step < 200; ++step) {
+        int row = random() % buffer.getSize();
+        switch (random() % 4) {
+            case 0: buffer.set_row(row, random_row()); break;
+            case 1: case 3: buffer.new_row(random_row(), row); break;
+            case 2: if (buffer.getSize() > 1) buffer.del_row(row); break;
+        }
+        expect_matches_stack();
+    }
+}
+
+TEST_F(BracketIndexTest, DeepNesting) {
+    const size_t depth = 50000;
+    std::vector<std::string> rows;
+    for (size_t i = 0; i < depth; ++i) rows.push_back("f(x) {");
+    for (size_t i = 0; i < depth; ++i) rows.push_back("}");
+    set_text(rows);
+
+    BracketPair pair;
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 5, pair));
+    EXPECT_EQ(pair.close_row, 2 * depth - 1);
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, depth, 0, pair));
+    EXPECT_EQ(pair.open_row, depth - 1);
+
+    // One more opening bracket at the top shifts every pair by one
+    buffer.set_row(0, "f(x) { {");
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 7, pair));
+    EXPECT_EQ(pair.close_row, 2 * depth - 1);
+    EXPECT_FALSE(BracketIndex::instance().match(buffer, 0, 5, pair));
+}
+
+TEST_F(BracketIndexTest, ShrinksPastPowersOfTwo) {
+    set_text({"{", "}", "x;", "x;", "x;"});
+    BracketPair pair;
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 0, pair));
+    buffer.del_row(4);   // down to 4 rows, and a tree half the size
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 0, pair));
+    EXPECT_EQ(pair.close_row, 1u);
+    EXPECT_EQ(pair.close_col, 0u);
+
+    std::vector<std::string> rows;
+    for (int i = 0; i < 600; ++i) rows.push_back(i % 4 == 0 ? "f(x) {" : i % 4 == 3 ? "}" : "  [a];");
+    set_text(rows);
+    expect_matches_fresh();
+    while (buffer.getSize() > 100) {
+        buffer.del_row(buffer.getSize() / 2);
+        if ((buffer.getSize() & (buffer.getSize() - 1)) == 0 || buffer.getSize() % 37 == 0) expect_matches_fresh();
+    }
+
+    // Another content of fewer rows, as when a smaller file is read into the buffer
+    set_text({"{", "}", "x;"});
+    expect_matches_fresh();
+    ASSERT_TRUE(BracketIndex::instance().match(buffer, 0, 0, pair));
+    EXPECT_EQ(pair.close_row, 1u);
+}
+
+/*
+    g++ -std=c++17 -o test_bracket_index test_bracketIndex.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
@@ -0,0 +1,358 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../include/incrementalSearch.hpp"
+#include "../include/editorStats.hpp"
+
+class IncrementalSearchTest : public ::testing::Test {
+protected:
+    IncrementalSearch& search = IncrementalSearch::instance();
+
+    void SetUp() override {
+        search.clear();
+        buffer.clear();
+    }
+
+    void set_text(const std::vector<std::string>& rows) {
+        buffer.clear();
+        for (const std::string& row : rows) buffer.push_back(row);
+    }
+
+    // The matches of a whole search, as find_all_occurrence gives them
+    std::vector<std::pair<int, int>> expected(const std::string& term) {
+        editor::find::find_all_occurrence(term);
+        std::vector<std::pair<int, int>> positions;
+        for (const auto& match : editor::found_occurrences) positions.push_back({match.row, match.col});
+        editor::found_occurrences.clear();
+        return positions;
+    }
+
+    std::vector<std::pair<int, int>> found() {
+        std::vector<std::pair<int, int>> positions;
+        for (const auto& match : editor::found_occurrences) positions.push_back({match.row, match.col});
+        return positions;
+    }
+};
+
+TEST_F(IncrementalSearchTest, StartsFromTheCursorAndWraps) {
+    set_text({"foo one", "two", "foo three foo", "four", "foo"});
+    auto all = expected("foo");
+
+    search.start(buffer, "foo", 2, 5);
+    ASSERT_TRUE(search.run(buffer, IncrementalSearch::clock::time_point::max()));
+    editor::SearchMatch nearest_match;
+    ASSERT_TRUE(search.nearest(nearest_match));
+    EXPECT_EQ(nearest_match.row, 2);
+    EXPECT_EQ(nearest_match.col, 10);
+
+    int nearest = search.finish(buffer);
+    EXPECT_EQ(found(), all);
+    ASSERT_EQ(nearest, 2);
+
+    // On a match: the next one, as `n` goes
+    search.start(buffer, "foo", 2, 0);
+    ASSERT_TRUE(search.run(buffer, IncrementalSearch::clock::time_point::max()));
+    ASSERT_TRUE(search.nearest(nearest_match));
+    EXPECT_EQ(nearest_match.col, 10);
+    EXPECT_EQ(search.finish(buffer), 2);
+
+    // Past the last match: back to the first one
+    search.start(buffer, "foo", 4, 1);
+    EXPECT_EQ(search.finish(buffer), 0);
+    search.start(buffer, "bar", 0, 0);
+    EXPECT_EQ(search.finish(buffer), -1);
+}
+
+TEST_F(IncrementalSearchTest, NarrowingChecksOnlyTheRowsThatMatched) {
+    std::vector<std::string> rows;
+    for (int i = 0; i < 1000; ++i) {
+        rows.push_back(i % 10 == 0 ? "value_" + std::to_string(i) + " = 1;" : "nothing here " + std::to_string(i));
+    }
+    set_text(rows);
+    EditorStats& stats = EditorStats::instance();
+
+    search.start(buffer, "val", 0, 0);
+    search.finish(buffer);
+    unsigned long before = stats.rows_searched;
+    search.start(buffer, "value_1", 0, 0);
+    search.finish(buffer);
+    EXPECT_EQ(stats.rows_searched - before, 100u);
+    auto narrowed = found();
+    EXPECT_EQ(narrowed, expected("value_1"));
+
+    // Going back widens the search: every row again
+    before = stats.rows_searched;
+    search.start(buffer, "valu", 0, 0);
+    search.finish(buffer);
+    EXPECT_EQ(stats.rows_searched - before, 1000u);
+
+    // A regex that could match rows "valu" did not is not a narrowing
+    search.start(buffer, "valu|here", 0, 0);
+    search.finish(buffer);
+    auto alternatives = found();
+    EXPECT_EQ(alternatives, expected("valu|here"));
+}
+
+TEST_F(IncrementalSearchTest, AnInterruptedSearchGoesOnWhereItStopped) {
+    std::vector<std::string> rows;
+    for (int i = 0; i < 5000; ++i) rows.push_back("row " + std::to_string(i) + (i % 7 == 0 ? " key" : ""));
+    set_text(rows);
+
+    // A key is always waiting: one look every few rows, then it stops
+    search.start(buffer, "ke", 2500, 0);
+    EXPECT_FALSE(search.run(buffer, IncrementalSearch::clock::time_point::max(), []() { return true; }));
+    EXPECT_FALSE(search.complete());
+    editor::SearchMatch nearest;
+    ASSERT_TRUE(search.nearest(nearest));
+    EXPECT_EQ(nearest.row, 2506);
+
+    // Narrowed before the first search was done
+    search.start(buffer, "key", 2500, 0);
+    search.finish(buffer);
+    auto resumed = found();
+    EXPECT_EQ(resumed, expected("key"));
+}
+
+TEST_F(IncrementalSearchTest, ResultsFollowTheEdits) {
+    std::vector<std::string> rows;
+    for (int i = 0; i < 2000; ++i) rows.push_back(i % 4 == 0 ? "a match " + std::to_string(i) + " match" : "plain");
+    set_text(rows);
+    EditorStats& stats = EditorStats::instance();
+    search.start(buffer, "match", 0, 0);
+    search.finish(buffer);
+    auto check = [&](unsigned long rows_searched, const char* what) {
+        unsigned long before = stats.rows_searched;
+        EXPECT_TRUE(search.follow(buffer)) << what;
+        search.finish(buffer);   // what follow() left to run()
+        EXPECT_EQ(stats.rows_searched - before, rows_searched) << what;
+        auto followed = found();
+        EXPECT_EQ(followed, expected("match")) << what;
+        search.start(buffer, "match", 0, 0);
+        search.finish(buffer);
+    };
+
+    // In place: the columns move within the row
+    buffer.set_row(8, "xx a match");
+    buffer.set_row(9, "match");
+    check(2, "changed rows");
+
+    // Rows come and go: the rest keep their matches
+    buffer.new_row("match inserted", 100);
+    buffer.del_row(4);
+    buffer.del_row(500);
+    buffer.set_row(1000, "no more");
+    check(2, "inserted and deleted rows");
+
+    // Many rows changed in place
+    for (int row = 0; row < 200; ++row) buffer.set_row(row * 3, "match");
+    check(200, "many changed rows");
+
+    // More edits than the buffer remembers: everything again, in slices
+    for (int i = 0; i < 5000; ++i) buffer.set_row(7, "match " + std::to_string(i));
+    check(buffer.getSize(), "forgotten edits");
+
+    EXPECT_FALSE(search.follow(buffer));
+}
+
+TEST_F(IncrementalSearchTest, EditsMoveBlocksOfMatches) {
+    // Enough matches for many blocks, and edits that cross their edges
+    std::mt19937 random(3);
+    std::vector<std::string> rows;
+    for (int i = 0; i < 20000; ++i) rows.push_back(i % 3 ? std::string(i % 7, 'e') : "x");
+    set_text(rows);
+    search.start(buffer, "e", 0, 0);
+    search.finish(buffer);
+    for (int step = 0; step < 300; ++step) {
+        int row = random() % buffer.getSize();
+        switch (random() % 4) {
+            case 0: buffer.set_row(row, std::string(random() % 9, 'e')); break;
+            case 1: buffer.new_row(std::string(random() % 9, 'e'), row); break;
+            case 2: buffer.del_row(row); break;
+            case 3: for (int k = 0; k < 50; ++k) buffer.new_row("e e", row); break;
+        }
+        if (step % 10 == 0) {
+            search.follow(buffer);
+            std::vector<std::pair<int, int>> every_e;
+            for (int r = 0; r < (int)buffer.getSize(); ++r) {
+                for (int col = 0; col < (int)buffer[r].size(); ++col) {
+                    if (buffer[r][col] == 'e') every_e.push_back({r, col});
+                }
+            }
+            ASSERT_EQ(found(), every_e) << "step " << step;
+        }
+    }
+}
+
+TEST_F(IncrementalSearchTest, RowsAreFoundByBinarySearch) {
+    std::vector<std::string> rows;
+    for (int i = 0; i < 6000; ++i) rows.push_back(i % 3 ? "e" + std::string(i % 5, 'e') : "x");
+    set_text(rows);
+    auto expect_rows = [&](const char* when) {
+        const auto& found = editor::found_occurrences;
+        for (int row = 0; row < (int)rows.size(); ++row) {
+            std::pair<size_t, size_t> range = search.in_row(row);
+            size_t count = std::count_if(found.begin(), found.end(), [&](const editor::SearchMatch& m) { return m.row == row; });
+            ASSERT_EQ(range.second - range.first, count) << when << ", row " << row;
+            for (size_t i = range.first; i < range.second; ++i) ASSERT_EQ(found[i].row, row) << when;
+        }
+    };
+
+    // Part way through, in scan order: from row 1000 down, then from the top
+    search.start(buffer, "e", 1000, 0);
+    search.run(buffer, IncrementalSearch::clock::time_point::max(), []() { return true; });
+    expect_rows("from the origin down");
+    while (!search.run(buffer, IncrementalSearch::clock::time_point::max(), []() { return true; })) {
+        if (editor::found_occurrences.back().row < 1000) break;
+    }
+    expect_rows("past the end, from the top");
+    search.finish(buffer);
+    expect_rows("complete");
+
+    // The window only gets its own rows
+    Mode previous = mode;
+    mode = Mode::find;
+    auto visible = editor::find::visible_occurrences(2999, 3);
+    mode = previous;
+    ASSERT_EQ(visible.size(), 3u);
+    EXPECT_EQ(visible[0].size(), 5u);   // "eeeee"
+    EXPECT_EQ(visible[1].size(), 0u);   // "x"
+    ASSERT_EQ(visible[2].size(), 2u);   // "ee"
+    EXPECT_EQ(visible[2][1].row, 3001);
+    EXPECT_EQ(visible[2][1].col, 1);
+}
+
+TEST_F(IncrementalSearchTest, MovesFromTheCursorWhileCounting) {
+    std::vector<std::string> rows(30000, "nothing");
+    rows[10] = "hit hit";
+    rows[20000] = "hit";
+    set_text(rows);
+    Mode previous = mode;
+    mode = Mode::find;
+    auto at = [&]() { return std::make_pair((int)pointed_row, (int)pointed_col); };
+
+    // Part of the buffer searched, after the cursor
+    search.start(buffer, "hit", 15, 0);
+    search.run(buffer, IncrementalSearch::clock::time_point::max(), []() { return true; });
+    ASSERT_FALSE(search.complete());
+    pointed_row = 15;
+    pointed_col = 0;
+    editor::find::go_to_next_occurrence();
+    EXPECT_EQ(at(), std::make_pair(20000, 0));
+    editor::find::go_to_next_occurrence();   // around the end
+    EXPECT_EQ(at(), std::make_pair(10, 0));
+    editor::find::go_to_next_occurrence();
+    EXPECT_EQ(at(), std::make_pair(10, 4));
+    editor::find::go_to_previous_occurrence();
+    EXPECT_EQ(at(), std::make_pair(10, 0));
+    editor::find::go_to_previous_occurrence();   // around the start
+    EXPECT_EQ(at(), std::make_pair(20000, 0));
+    EXPECT_NE(editor::find::search_status().find("so far"), std::string::npos);
+
+    // Counted between keys, then told by position
+    while (editor::find::search_in_background()) {}
+    ASSERT_TRUE(search.complete());
+    EXPECT_EQ(editor::find::search_status(), "match 3 of 3");
+    editor::find::go_to_next_occurrence();
+    EXPECT_EQ(editor::find::search_status(), "match 1 of 3");
+    pointed_col = 2;
+    EXPECT_EQ(editor::find::search_status(), "3 matches");
+    editor::find::go_to_next_occurrence();
+    EXPECT_EQ(at(), std::make_pair(10, 4));
+    mode = previous;
+}
+
+TEST_F(IncrementalSearchTest, FindsMatchesThatSpanRows) {
+    auto spans = [&]() {
+        std::vector<std::vector<int>> positions;
+        for (const auto& match : editor::found_occurrences) positions.push_back({match.row, match.col, match.end_row, match.end_col, match.length});
+        return positions;
+    };
+
+    set_text({"int f(", "    int a,", "    int b)", "{", "f(", "  x)"});
+    editor::find::find_all_occurrence("f\\(\\n\\s*\\w+");
+    EXPECT_EQ(spans(), (std::vector<std::vector<int>>{{0, 4, 1, 7, 10}, {4, 0, 5, 3, 6}}));
+
+    // From a cursor in the middle: a match from above that runs past the cursor row wins over
+    // the one found from the cursor row down, as if the search had started at the top
+    set_text({"x", "y", "y", "z"});
+    search.start(buffer, "[xy]\\n([xy]\\n)*", 2, 0);
+    search.finish(buffer);
+    EXPECT_EQ(spans(), (std::vector<std::vector<int>>{{0, 0, 3, 0, 6}}));
+    Mode previous = mode;
+    mode = Mode::find;
+    auto visible = editor::find::visible_occurrences(1, 3);
+    ASSERT_EQ(visible.size(), 3u);
+    EXPECT_EQ(visible[0].size(), 1u);   // each row its part, its line break included
+    EXPECT_EQ(visible[0][0].col, 0);
+    EXPECT_EQ(visible[0][0].length, 2);
+    EXPECT_EQ(visible[2].size(), 0u);
+    mode = previous;
+
+    // Any cursor gives what a search from the top gives
+    std::mt19937 random(5);
+    for (const std::string& term : {"a\\nb", "b\\n+a?", "(a|b)\\n(ab\\n)*", "^\\n", "a*\\n"}) {
+        for (int round = 0; round < 30; ++round) {
+            std::vector<std::string> rows(1 + random() % 8);
+            for (std::string& row : rows) {
+                for (size_t i = random() % 3; i > 0; --i) row += "ab"[random() % 2];
+            }
+            set_text(rows);
+            editor::find::find_all_occurrence(term);
+            auto top = spans();
+            size_t row = random() % rows.size();
+            search.start(buffer, term, row, random() % (rows[row].size() + 1));
+            search.finish(buffer);
+            ASSERT_EQ(spans(), top) << term << " from row " << row;
+        }
+    }
+
+    // Edits keep the matches above them, and the rest is searched again from the last one
+    set_text({"a", "b", "a"});
+    editor::find::find_all_occurrence("a\\nb");
+    ASSERT_EQ(editor::found_occurrences.size(), 1u);
+    buffer.set_row(2, "a");
+    buffer.new_row("b", 3);
+    EXPECT_TRUE(search.follow(buffer));
+    EXPECT_FALSE(search.complete());
+    search.finish(buffer);
+    EXPECT_EQ(spans(), (std::vector<std::vector<int>>{{0, 0, 1, 1, 3}, {2, 0, 3, 1, 3}}));
+
+    // Next and previous, before the search is counted
+    editor::SearchMatch match;
+    ASSERT_TRUE(search.scan_from(buffer, 0, 0, true, match));
+    EXPECT_EQ(match.row, 2);
+    ASSERT_TRUE(search.scan_from(buffer, 2, 0, true, match));   // around the end
+    EXPECT_EQ(match.row, 0);
+    ASSERT_TRUE(search.scan_from(buffer, 2, 0, false, match));
+    EXPECT_EQ(match.row, 0);
+    ASSERT_TRUE(search.scan_from(buffer, 0, 0, false, match));   // around the start
+    EXPECT_EQ(match.row, 2);
+
+    // Far from the top, only the rows from the first edited one on are searched again
+    std::vector<std::string> pairs;
+    for (int i = 0; i < 5000; ++i) pairs.push_back(i % 2 ? "b" : "a");
+    set_text(pairs);
+    editor::find::find_all_occurrence("a\\nb");
+    ASSERT_EQ(editor::found_occurrences.size(), 2500u);
+    buffer.set_row(4001, "x");
+    buffer.del_row(4500);
+    EditorStats& stats = EditorStats::instance();
+    unsigned long before = stats.rows_searched;
+    EXPECT_TRUE(search.follow(buffer));
+    editor::find::complete_search();
+    EXPECT_LT(stats.rows_searched - before, 1100u);
+    auto followed = spans();
+    editor::find::find_all_occurrence("a\\nb");
+    EXPECT_EQ(followed, spans());
+}
+
+TEST_F(IncrementalSearchTest, TermsAreCompiledOnce) {
+    std::shared_ptr<SearchPattern> first = search.compiled("a+b");
+    EXPECT_EQ(search.compiled("a+b"), first);
+    EXPECT_EQ(first->kind, SearchPattern::Kind::REGEX);
+    EXPECT_EQ(search.compiled("(a)\\1")->kind, SearchPattern::Kind::BACKTRACKING);
+    EXPECT_EQ(search.compiled("[")->kind, SearchPattern::Kind::LITERAL);
+}
+
+/*
+    g++ -std=c++17 -o test_incremental_search test_incrementalSearch.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
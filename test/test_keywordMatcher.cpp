@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <tuple>
+#include "../include/keywordMatcher.hpp"
+#include "../include/syntax.hpp"
+#include "../include/editor.hpp"
+#include "testLanguages.hpp"
+
+using Occurrence = std::tuple<size_t, size_t, int>;
+
+static std::set<Occurrence> scan_all(const KeywordMatcher& matcher, const std::string& text) {
+    std::set<Occurrence> found;
+    matcher.scan(text, [&](size_t start, size_t length, int group) {
+        found.insert({start, length, group});
+    });
+    return found;
+}
+
+TEST(KeywordMatcherTest, FindsOverlappingAndNestedKeywords) {
+    KeywordMatcher matcher;
+    matcher.add("he", 0);
+    matcher.add("she", 0);
+    matcher.add("his", 1);
+    matcher.add("hers", 1);
+    matcher.build();
+
+    std::set<Occurrence> expected = {{1, 3, 0}, {2, 2, 0}, {2, 4, 1}};
+    EXPECT_EQ(scan_all(matcher, "ushers"), expected);
+    EXPECT_TRUE(scan_all(matcher, "nothing").empty());
+}
+
+TEST(KeywordMatcherTest, MatchesEveryFindOnRandomText) {
+    std::mt19937 rng(3);
+    KeywordMatcher matcher;
+    std::vector<std::string> words;
+    for (int i = 0; i < 200; ++i) {
+        std::string word;
+        for (size_t n = rng() % 4 + 1; n > 0; --n) word += (char)('a' + rng() % 4);
+        words.push_back(word);
+        matcher.add(word, i);
+    }
+    matcher.build();
+
+    for (int trial = 0; trial < 50; ++trial) {
+        std::string text;
+        for (int i = 0; i < 60; ++i) text += (char)('a' + rng() % 5);
+
+        std::set<Occurrence> expected;
+        for (int i = 0; i < (int)words.size(); ++i) {
+            for (size_t pos = text.find(words[i]); pos != std::string::npos; pos = text.find(words[i], pos + 1)) {
+                expected.insert({pos, words[i].size(), i});
+            }
+        }
+        ASSERT_EQ(scan_all(matcher, text), expected) << text;
+    }
+}
+
+TEST(KeywordMatcherTest, StylesLikeTheSearchOnEveryLanguage) {
+    keyWordColor = 5;
+    preprocessorColor = 6;
+    std::mt19937 rng(5);
+    const char* glue[] = {" ", "(", ")", "{", "x", "=", "_", "  ", "[", "-"};
+
+    for (const char* file : {"a.c", "a.cpp", "a.py", "a.sh", "a.go", "a.java", "a.js", "a.rs", "a.lua"}) {
+        ASSERT_TRUE(use_test_language(file));
+        const Language* lang = SyntaxHighlighter::instance().getCurrentLanguage();
+
+        for (int trial = 0; trial < 200; ++trial) {
+            std::string row;
+            for (int i = 0; i < 12; ++i) {
+                const auto& group = lang->syntaxGroups[rng() % lang->syntaxGroups.size()];
+                if (!group.keywords.empty()) row += group.keywords[rng() % group.keywords.size()];
+                row += glue[rng() % 10];
+            }
+
+            std::vector<color> by_search(row.size(), 0), by_automaton(row.size(), 0);
+            editor::visual::style_keyword_groups_by_search(*lang, row, by_search);
+            editor::visual::style_keyword_groups(*lang, row, by_automaton);
+            ASSERT_EQ(by_automaton, by_search) << lang->name << ": " << row;
+        }
+    }
+}
+
+/*
+    g++ -std=c++17 -o test_keyword_matcher test_keywordMatcher.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include "../include/syntax.hpp"
+
+namespace fs = std::filesystem;
+
+class LanguageIndexTest : public ::testing::Test {
+protected:
+    fs::path dir = fs::temp_directory_path() / "mvim-test-languages";
+
+    void SetUp() override {
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir);
+        SyntaxHighlighter::instance().loadLanguages();
+    }
+
+    void write(const std::string& file, const std::string& content) {
+        std::ofstream(dir / file) << content;
+    }
+};
+
+TEST_F(LanguageIndexTest, ParsesALanguageOnlyWhenAFileNeedsIt) {
+    write("a.mvimlang", "name=Alpha\nextensions=.a .aa\nkeywords=one two\n");
+    write("b.mvimlang", "extensions=.b\nname=Beta\nkeywords=three\n");
+    write("nameless.mvimlang", "extensions=.n\nkeywords=four\n");
+
+    SyntaxHighlighter& syntax = SyntaxHighlighter::instance();
+    syntax.indexLanguages(dir);
+    EXPECT_EQ(syntax.indexedLanguages(), 2u);
+
+    syntax.setLanguageFromFile("x.aa");
+    const Language* alpha = syntax.getCurrentLanguage();
+    ASSERT_NE(alpha, nullptr);
+    EXPECT_EQ(alpha->name, "Alpha");
+    EXPECT_EQ(alpha->syntaxGroups[0].keywords, (std::vector<std::string>{"one", "two"}));
+
+    syntax.setLanguageFromFile("x.b");
+    ASSERT_NE(syntax.getCurrentLanguage(), nullptr);
+    EXPECT_EQ(syntax.getCurrentLanguage()->name, "Beta");
+
+    // Compiled once, then reused
+    syntax.setLanguageFromFile("y.a");
+    EXPECT_EQ(syntax.getCurrentLanguage(), alpha);
+
+    syntax.setLanguageFromFile("x.n");
+    EXPECT_EQ(syntax.getCurrentLanguage(), nullptr);
+    syntax.setLanguageFromFile("noextension");
+    EXPECT_EQ(syntax.getCurrentLanguage(), nullptr);
+}
+
+TEST_F(LanguageIndexTest, ReparsesAChangedFile) {
+    write("a.mvimlang", "name=Alpha\nextensions=.a\nkeywords=one\n");
+    SyntaxHighlighter& syntax = SyntaxHighlighter::instance();
+    syntax.indexLanguages(dir);
+    syntax.setLanguageFromFile("x.a");
+    const Language* before = syntax.getCurrentLanguage();
+    ASSERT_NE(before, nullptr);
+
+    write("a.mvimlang", "name=Alpha\nextensions=.a\nkeywords=one uno\n");
+    fs::last_write_time(dir / "a.mvimlang", fs::last_write_time(dir / "a.mvimlang") + std::chrono::seconds(5));
+
+    syntax.setLanguageFromFile("x.a");
+    const Language* after = syntax.getCurrentLanguage();
+    ASSERT_NE(after, nullptr);
+    EXPECT_NE(after, before);
+    EXPECT_EQ(after->syntaxGroups[0].keywords.size(), 2u);
+    EXPECT_EQ(before->syntaxGroups[0].keywords.size(), 1u);   // still valid for its holders
+}
+
+/*
+    g++ -std=c++17 -o test_language_index test_languageIndex.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include "../include/literalFinder.hpp"
+
+static std::string lowered(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return text;
+}
+
+TEST(LiteralFinderTest, FindsLikeStdStringFind) {
+    std::mt19937 random(7);
+    const std::string alphabet = "abAB_ \xe9";
+    LiteralFinder finder;
+    for (int round = 0; round < 3000; ++round) {
+        std::string text, needle;
+        size_t size = random() % 120;
+        for (size_t i = 0; i < size; ++i) text += alphabet[random() % alphabet.size()];
+        size_t length = random() % 6;
+        for (size_t i = 0; i < length; ++i) needle += alphabet[random() % alphabet.size()];
+
+        finder.assign(needle);
+        for (size_t from = 0; from <= text.size() + 1; ++from) {
+            ASSERT_EQ(finder.find(text, from), text.find(needle, from)) << '"' << needle << "\" in \"" << text << "\" from " << from;
+        }
+    }
+}
+
+TEST(LiteralFinderTest, IgnoresTheCaseOfLetters) {
+    std::mt19937 random(5);
+    const std::string alphabet = "abAB_@`[{";   // the bytes next to the letters must not match them
+    LiteralFinder finder;
+    for (int round = 0; round < 3000; ++round) {
+        std::string text, needle;
+        size_t size = random() % 120;
+        for (size_t i = 0; i < size; ++i) text += alphabet[random() % alphabet.size()];
+        size_t length = 1 + random() % 5;
+        for (size_t i = 0; i < length; ++i) needle += alphabet[random() % alphabet.size()];
+
+        finder.assign(needle, true);
+        std::string folded = lowered(text);
+        for (size_t from = 0; from <= text.size(); ++from) {
+            ASSERT_EQ(finder.find(text, from), folded.find(lowered(needle), from)) << '"' << needle << "\" in \"" << text << "\" from " << from;
+        }
+    }
+}
+
+TEST(LiteralFinderTest, NeverReadsPastTheText) {
+    // The needle is at the very end of blocks of every size, right before unmapped bytes would be
+    LiteralFinder finder;
+    finder.assign("needle_x");
+    for (size_t size = 8; size < 200; ++size) {
+        std::vector<char> bytes(size, 'n');
+        std::copy_n("needle_x", 8, bytes.end() - 8);
+        EXPECT_EQ(finder.find(bytes.data(), bytes.size(), 0), size - 8);
+        bytes.back() = 'y';
+        EXPECT_EQ(finder.find(bytes.data(), bytes.size(), 0), std::string::npos);
+    }
+}
+
+/*
+    g++ -std=c++17 -march=native -o test_literal_finder test_literalFinder.cpp ../src/literalFinder.cpp -lgtest -lgtest_main -lpthread
+*/
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "../include/screen.hpp"
+#include "../include/editor.hpp"
+#include "../include/editorStats.hpp"
+#include "../include/syntax.hpp"
+#include "../include/incrementalSearch.hpp"
+#include "testLanguages.hpp"
+
+class LongRowsTest : public ::testing::Test {
+protected:
+    CellGrid grid{6, 30};
+    size_t saved_length = max_highlight_length;
+    size_t saved_budget = highlight_budget_ms;
+
+    void SetUp() override {
+        Screen::getScreen().set_surface(&grid);
+        Screen::getScreen().invalidate_render_cache();
+
+        ASSERT_TRUE(use_test_language("long.c"));
+        Screen::getScreen().set_status_message("");
+
+        mode = Mode::normal;
+        pointed_file = "long.c";
+        pointed_row = 0;
+        pointed_col = 0;
+        starting_row = 0;
+        starting_col = 0;
+        max_row = grid.rows() - 1;
+        max_col = grid.cols() - span - 1;
+
+        textColor = 1;
+        keyWordColor = 2;
+        commentsColor = 3;
+        bracketsColor = 4;
+        stringColor = 5;
+        numberColor = 6;
+        typeColor = 7;
+        preprocessorColor = 8;
+        highlightedTextColor = 9;
+    }
+
+    void TearDown() override {
+        max_highlight_length = saved_length;
+        highlight_budget_ms = saved_budget;
+        IncrementalSearch::instance().clear();
+        mode = Mode::normal;
+        Screen::getScreen().set_surface(nullptr);
+    }
+
+    void set_text(const std::vector<std::string>& rows) {
+        buffer.clear();
+        for (const std::string& row : rows) buffer.push_back(row);
+    }
+
+    // Color of a buffer column drawn on a screen row
+    color pair_at(int y, size_t col) {
+        return grid.pair_at(y, span + 1 + (col - starting_col));
+    }
+};
+
+TEST_F(LongRowsTest, LongRowsAreDrawnPlain) {
+    max_highlight_length = 40;
+    set_text({"int x; /* opened in a row too long to highlight", "int y; */ int z;", "int w;"});
+
+    Screen::getScreen().update();
+
+    EXPECT_EQ(pair_at(0, 0), textColor);
+    EXPECT_EQ(pair_at(0, 10), textColor);
+    EXPECT_EQ(pair_at(1, 0), commentsColor);   // the comment state goes on past it
+    EXPECT_EQ(pair_at(1, 10), keyWordColor);
+    EXPECT_EQ(pair_at(2, 0), keyWordColor);
+    EXPECT_NE(grid.row_text(5).find("[INFO] Rows over 40"), std::string::npos);
+}
+
+TEST_F(LongRowsTest, SearchMatchesShowOnLongRows) {
+    max_highlight_length = 40;
+    set_text({"int x; /* a row too long to highlight, with x */", "int x;"});
+    IncrementalSearch::instance().start(buffer, "x", 0, 0);
+    IncrementalSearch::instance().finish(buffer);
+    mode = Mode::find;
+
+    Screen::getScreen().update();
+
+    EXPECT_EQ(pair_at(0, 0), textColor);
+    EXPECT_EQ(pair_at(0, 4), highlightedTextColor);
+    EXPECT_EQ(pair_at(0, 5), textColor);
+    EXPECT_EQ(pair_at(0, 7), textColor);
+    EXPECT_EQ(pair_at(1, 0), keyWordColor);
+    EXPECT_EQ(pair_at(1, 4), highlightedTextColor);
+}
+
+TEST_F(LongRowsTest, WideRowsAreStyledAroundTheWindow) {
+    std::string wide;
+    while (wide.size() < 3000) wide += "if (x[1] == \"a\") { return 0x1F; } ";
+    set_text({wide, "/* " + wide, wide + " */ int x;"});
+
+    starting_col = 1500;
+    Screen::getScreen().update();
+
+    // Same colors as the whole rows styled
+    bool in_comment = false;
+    for (int y = 0; y < 3; ++y) {
+        std::vector<color> colors(buffer[y].length(), textColor);
+        editor::visual::style_keywords(buffer[y], colors, in_comment);
+        for (size_t col = starting_col; col < starting_col + max_col; ++col) {
+            ASSERT_EQ(pair_at(y, col), colors[col]) << y << ":" << col;
+        }
+    }
+}
+
+TEST_F(LongRowsTest, RowsPastTheBudgetAreStyledByTheNextFrames) {
+    highlight_budget_ms = 0;
+    set_text({"int a;", "int b;", "int c;", "int d;"});
+    unsigned long deferred = EditorStats::instance().rows_deferred;
+
+    // Each frame styles one more row once the budget is spent
+    Screen::getScreen().update();
+    EXPECT_EQ(pair_at(0, 0), keyWordColor);
+    EXPECT_EQ(pair_at(1, 0), textColor);
+    EXPECT_EQ(EditorStats::instance().rows_deferred - deferred, 3u);
+
+    for (int frame = 0; frame < 3; ++frame) Screen::getScreen().update();
+    for (int y = 0; y < 4; ++y) {
+        EXPECT_EQ(pair_at(y, 0), keyWordColor) << y;
+    }
+}
+
+/*
+    g++ -std=c++17 -o test_long_rows test_longRows.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
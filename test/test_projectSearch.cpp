@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include "../include/projectSearch.hpp"
+#include "../include/incrementalSearch.hpp"
+
+namespace fs = std::filesystem;
+
+TEST(GitIgnoreTest, MatchesLikeGit) {
+    GitIgnore root("# comment\n*.log\n!keep.log\nbuild/\n/top.txt\ndoc/*.html\n**/cache\nlogs/**\nname?.c\n[abc]x.h\n\\#hash\nspace \n",
+                   "", nullptr);
+    EXPECT_TRUE(root.ignores("a.log", false));
+    EXPECT_TRUE(root.ignores("src/deep/a.log", false));
+    EXPECT_FALSE(root.ignores("src/keep.log", false));
+    EXPECT_TRUE(root.ignores("build", true));
+    EXPECT_TRUE(root.ignores("src/build", true));
+    EXPECT_FALSE(root.ignores("build", false));            // only directories
+    EXPECT_TRUE(root.ignores("top.txt", false));
+    EXPECT_FALSE(root.ignores("src/top.txt", false));      // anchored to the root
+    EXPECT_TRUE(root.ignores("doc/index.html", false));
+    EXPECT_FALSE(root.ignores("doc/api/index.html", false));   // `*` stops at slashes
+    EXPECT_FALSE(root.ignores("src/doc/index.html", false));
+    EXPECT_TRUE(root.ignores("cache", true));
+    EXPECT_TRUE(root.ignores("a/b/cache", true));
+    EXPECT_TRUE(root.ignores("logs/a/b.txt", false));
+    EXPECT_FALSE(root.ignores("logs", true));
+    EXPECT_TRUE(root.ignores("name1.c", false));
+    EXPECT_FALSE(root.ignores("name10.c", false));
+    EXPECT_TRUE(root.ignores("bx.h", false));
+    EXPECT_FALSE(root.ignores("dx.h", false));
+    EXPECT_TRUE(root.ignores("#hash", false));
+    EXPECT_TRUE(root.ignores("space", false));
+    EXPECT_FALSE(root.ignores("comment", false));
+
+    // A deeper file overrides the one above, for its own directory only
+    auto parent = std::make_shared<GitIgnore>("*.tmp\n", "", nullptr);
+    GitIgnore child("!*.tmp\n[!a]*.o\n", "src", parent);
+    EXPECT_FALSE(child.ignores("src/x.tmp", false));
+    EXPECT_TRUE(child.ignores("x.tmp", false));
+    EXPECT_TRUE(child.ignores("src/b.o", false));
+    EXPECT_FALSE(child.ignores("src/a.o", false));
+}
+
+class ProjectSearchTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / ("mvim_project_" + std::to_string(::getpid()));
+        fs::remove_all(root);
+        fs::create_directories(root);
+    }
+
+    void TearDown() override {
+        ProjectSearch::instance().resize(std::thread::hardware_concurrency());
+        fs::remove_all(root);
+    }
+
+    void write(const std::string& path, const std::string& text) {
+        fs::create_directories((root / path).parent_path());
+        std::ofstream(root / path, std::ios::binary) << text;
+    }
+
+    std::set<std::string> search(const std::string& term) {
+        ProjectSearch& search = ProjectSearch::instance();
+        search.start(term, root.string());
+        std::vector<ProjectSearch::Result> results;
+        while (!search.take(results)) search.wait();
+        std::set<std::string> lines;
+        for (const auto& result : results) {
+            EXPECT_EQ(result.text.rfind(*result.path + ":" + std::to_string(result.line + 1) + ":" + std::to_string(result.col + 1) + ": ", 0), 0u);
+            lines.insert(result.text);
+        }
+        return lines;
+    }
+};
+
+TEST_F(ProjectSearchTest, SkipsIgnoredAndBinaryFiles) {
+    write(".gitignore", "*.log\nbuild/\n");
+    write("a.txt", "one needle\ntwo\nthree needle here\n");
+    write("app.log", "needle in a log\n");
+    write("build/out.txt", "needle in build\n");
+    write("src/b.cpp", "int needle = 0;");
+    write("src/.gitignore", "gen/\n!*.log\n");
+    write("src/kept.log", "needle kept\n");
+    write("src/gen/c.cpp", "needle generated\n");
+    write(".git/config", "needle in git\n");
+    write("image.bin", std::string("needle\0\x01\x02", 9));
+    fs::create_symlink(root / "a.txt", root / "link.txt");
+
+    std::set<std::string> expected = {"a.txt:1:5: one needle", "a.txt:3:7: three needle here", "src/b.cpp:1:5: int needle = 0;",
+                                      "src/kept.log:1:1: needle kept"};
+    for (size_t threads : {1, 4}) {
+        ProjectSearch::instance().resize(threads);
+        EXPECT_EQ(search("needle"), expected);
+        EXPECT_EQ(ProjectSearch::instance().files(), 5u);   // the .gitignore files too
+        EXPECT_EQ(ProjectSearch::instance().matched_files(), 3u);
+        EXPECT_EQ(ProjectSearch::instance().binary_files(), 1u);
+    }
+    EXPECT_EQ(search("NEEDLE"), std::set<std::string>());
+    EXPECT_EQ(search("[Nn]eedle h\\w+"), std::set<std::string>{"a.txt:3:7: three needle here"});
+    EXPECT_EQ(search("^t\\w+"), (std::set<std::string>{"a.txt:2:1: two", "a.txt:3:1: three needle here"}));
+    EXPECT_EQ(search("one needle\\ntwo"), std::set<std::string>{"a.txt:1:1: one needle"});
+}
+
+TEST_F(ProjectSearchTest, FindsWhatASearchOfEachLineFinds) {
+    // Small files are read and large ones mapped: both must give the lines a row by row search gives
+    std::mt19937 random(11);
+    const char* words[] = {"alpha", "Beta", "gamma", "id_42", "x", "", "rare_token"};
+    std::vector<std::pair<std::string, std::vector<std::string>>> files;
+    for (int f = 0; f < 40; ++f) {
+        std::vector<std::string> lines(f % 10 == 0 ? 6000 : random() % 50);
+        std::string text;
+        for (auto& line : lines) {
+            for (int w = random() % 5; w > 0; --w) line += std::string(words[random() % (f % 3 ? 6 : 7)]) + " ";
+            text += line + "\n";
+        }
+        if (f % 4 == 1 && !text.empty()) text.pop_back();   // no line break at the end
+        std::string path = "dir" + std::to_string(f % 7) + "/f" + std::to_string(f) + ".txt";
+        write(path, text);
+        files.push_back({path, lines});
+    }
+
+    for (const std::string& term : {"rare_token", "Beta gamma", "ID_\\d+", "^x", "a $", "be(ta|x)"}) {
+        SearchPattern pattern;
+        pattern.compile(term);
+        std::set<std::string> expected;
+        for (const auto& file : files) {
+            for (size_t row = 0; row < file.second.size(); ++row) {
+                std::vector<editor::SearchMatch> matches;
+                pattern.matches(file.second[row], row, matches);
+                if (!matches.empty()) {
+                    expected.insert(file.first + ":" + std::to_string(row + 1) + ":" + std::to_string(matches[0].col + 1) + ": " +
+                                    file.second[row].substr(0, ProjectSearch::MAX_TEXT));
+                }
+            }
+        }
+        EXPECT_EQ(search(term), expected) << term;
+    }
+}
+
+/*
+    g++ -std=c++17 -o test_project_search test_projectSearch.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <regex>
+#include "../include/regexMatcher.hpp"
+
+// The leftmost match at or after every position of the text, against std::regex
+static void expect_same_as_std(const std::string& pattern, const std::string& text)
+{
+    RegexMatcher matcher;
+    ASSERT_EQ(matcher.compile(pattern), RegexMatcher::Status::COMPILED) << pattern << ": " << matcher.error();
+    std::regex reference(pattern);
+
+    for (size_t from = 0; from <= text.size(); ++from) {
+        std::smatch match;
+        auto flags = from > 0 ? std::regex_constants::match_prev_avail : std::regex_constants::match_default;
+        bool expected = std::regex_search(text.begin() + from, text.end(), match, reference, flags);
+
+        size_t start, end;
+        bool found = matcher.search(text, from, start, end);
+        ASSERT_EQ(found, expected) << pattern << " in \"" << text << "\" from " << from;
+        if (found) {
+            ASSERT_EQ(start, from + match.position()) << pattern << " in \"" << text << "\" from " << from;
+            ASSERT_EQ(end, start + match.length()) << pattern << " in \"" << text << "\" from " << from;
+        }
+    }
+}
+
+TEST(RegexMatcherTest, MatchesLikeStdRegex) {
+    const std::vector<std::string> patterns = {
+        "abc", "a|ab", "ab|a", "x*", "a+?", "a*?b", "(a|b)*c", "[a-c]+", "[^ab]", "a.c",
+        "\\bab\\b", "\\Bb", "^ab", "b$", "^$", "a{2}", "a{1,3}", "(ab){2,}", "a{2,3}?",
+        "(?:a|bc)+d", "\\d+", "\\w+\\s", "[\\d.]+", "(a*)*b", "(a|aa)+$", "c(a|b)*?c", "[]a]",
+        "a\\.b", "\\x61", "(|a)b", "((a|b)c|d)*", "[Aa][Bb]", "[aA]\\.?[bB]c", "[Aa]b",
+    };
+    std::mt19937 random(11);
+    const std::string alphabet = "abcAB d.1_";
+    for (const std::string& pattern : patterns) {
+        for (int round = 0; round < 60; ++round) {
+            std::string text;
+            size_t length = random() % 16;
+            for (size_t i = 0; i < length; ++i) text += alphabet[random() % alphabet.size()];
+            expect_same_as_std(pattern, text);
+        }
+    }
+}
+
+TEST(RegexMatcherTest, ReportsErrorsAndUnsupportedPatterns) {
+    RegexMatcher matcher;
+    EXPECT_EQ(matcher.compile("a("), RegexMatcher::Status::SYNTAX_ERROR);
+    EXPECT_EQ(matcher.compile("a)"), RegexMatcher::Status::SYNTAX_ERROR);
+    EXPECT_EQ(matcher.compile("[ab"), RegexMatcher::Status::SYNTAX_ERROR);
+    EXPECT_EQ(matcher.compile("*a"), RegexMatcher::Status::SYNTAX_ERROR);
+    EXPECT_EQ(matcher.compile("[z-a]"), RegexMatcher::Status::SYNTAX_ERROR);
+    EXPECT_EQ(matcher.compile("a{3,2}"), RegexMatcher::Status::SYNTAX_ERROR);
+    EXPECT_EQ(matcher.compile("(a)\\1"), RegexMatcher::Status::UNSUPPORTED);
+    EXPECT_EQ(matcher.compile("a(?=b)"), RegexMatcher::Status::UNSUPPORTED);
+    EXPECT_EQ(matcher.compile("(a{1000}){1000}"), RegexMatcher::Status::UNSUPPORTED);
+    EXPECT_FALSE(matcher.error().empty());
+}
+
+TEST(RegexMatcherTest, PathologicalPatternsStayLinear) {
+    RegexMatcher matcher;
+    ASSERT_EQ(matcher.compile("(a*)*b"), RegexMatcher::Status::COMPILED);
+    std::string row(1 << 20, 'a');
+
+    auto begin = std::chrono::steady_clock::now();
+    size_t start, end;
+    EXPECT_FALSE(matcher.search(row, 0, start, end));
+    row += 'b';
+    ASSERT_TRUE(matcher.search(row, 0, start, end));
+    EXPECT_EQ(start, 0u);
+    EXPECT_EQ(end, row.size());
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(1));
+}
+
+TEST(RegexMatcherTest, StateCacheStartsOverWhenFull) {
+    // The 13th byte from the end: 2^13 DFA states, more than the cache keeps
+    const std::string pattern = "a[ab]{12}$";
+    std::mt19937 random(3);
+    std::string text;
+    for (int i = 0; i < 20000; ++i) text += "ab"[random() % 2];
+
+    RegexMatcher matcher;
+    ASSERT_EQ(matcher.compile(pattern), RegexMatcher::Status::COMPILED);
+    std::regex reference(pattern);
+    std::smatch match;
+    for (size_t length : {14u, 100u, 5000u, 20000u}) {
+        std::string row = text.substr(0, length);
+        size_t start, end;
+        bool found = matcher.search(row, 0, start, end);
+        ASSERT_EQ(found, std::regex_search(row, match, reference)) << length;
+        if (found) {
+            EXPECT_EQ(start, (size_t)match.position()) << length;
+        }
+    }
+    EXPECT_LE(matcher.dfa_states(), 2 * 4096u);
+}
+
+TEST(RegexMatcherTest, FindsLettersOfEitherCaseAsLiterals) {
+    RegexMatcher matcher;
+    ASSERT_EQ(matcher.compile("[Ii][Dd]_[Xx]"), RegexMatcher::Status::COMPILED);
+    EXPECT_TRUE(matcher.is_folded_literal());
+    EXPECT_FALSE(matcher.is_literal());
+    EXPECT_EQ(matcher.required_prefix(), "");
+    size_t start, end;
+    ASSERT_TRUE(matcher.search("an iD_x and ID_X", 0, start, end));
+    EXPECT_EQ(start, 3u);
+    ASSERT_TRUE(matcher.search("an iD_x and ID_X", 4, start, end));
+    EXPECT_EQ(start, 12u);
+
+    // A letter in its own case after one in both: the rest goes to the automaton
+    ASSERT_EQ(matcher.compile("[Ii]d"), RegexMatcher::Status::COMPILED);
+    EXPECT_FALSE(matcher.is_folded_literal());
+    EXPECT_FALSE(matcher.search("ID", 0, start, end));
+    EXPECT_TRUE(matcher.search("Id", 0, start, end));
+
+    ASSERT_EQ(matcher.compile("update_row"), RegexMatcher::Status::COMPILED);
+    EXPECT_TRUE(matcher.is_literal());
+    EXPECT_EQ(matcher.required_prefix(), "update_row");
+}
+
+TEST(RegexMatcherTest, ForEachSkipsPastEmptyMatches) {
+    RegexMatcher matcher;
+    ASSERT_EQ(matcher.compile("a*"), RegexMatcher::Status::COMPILED);
+    std::vector<std::pair<size_t, size_t>> matches;
+    matcher.for_each("baab", [&](size_t start, size_t end) { matches.push_back({start, end}); });
+    std::vector<std::pair<size_t, size_t>> expected = {{0, 0}, {1, 3}, {3, 3}, {4, 4}};
+    EXPECT_EQ(matches, expected);
+
+    ASSERT_EQ(matcher.compile("ab"), RegexMatcher::Status::COMPILED);   // a literal
+    matches.clear();
+    matcher.for_each("abxab", [&](size_t start, size_t end) { matches.push_back({start, end}); });
+    expected = {{0, 2}, {3, 5}};
+    EXPECT_EQ(matches, expected);
+}
+
+TEST(RegexMatcherTest, ListsTheTextsEveryMatchContains) {
+    RegexMatcher matcher;
+    auto literals = [&](const std::string& pattern) {
+        EXPECT_EQ(matcher.compile(pattern), RegexMatcher::Status::COMPILED) << pattern;
+        return matcher.required_literals();
+    };
+    using texts = std::vector<std::string>;
+
+    EXPECT_EQ(literals("update_row"), texts{"update_row"});
+    EXPECT_EQ(literals("Error: \\d+ rows\\b"), (texts{"error: ", " rows"}));
+    EXPECT_EQ(literals("[Ii][Dd]_x"), texts{"id_x"});
+    EXPECT_EQ(literals("(abc)+d?ef"), (texts{"abc", "ef"}));
+    EXPECT_EQ(literals("^log(ged)*$"), texts{"log"});
+    EXPECT_EQ(literals("foo|bar"), texts{});
+    EXPECT_EQ(literals("x(foo|bar)y"), (texts{"x", "y"}));
+    EXPECT_EQ(literals("a\\nb"), (texts{"a", "b"}));
+}
+
+TEST(RegexMatcherTest, SearchesRowsAsOneText) {
+    // Against std::regex on the rows joined, with ^ and $ at every line
+    const std::vector<std::string> patterns = {
+        "a\\n", "\\nb", "a\\n\\s*b", "b$\\n^a", "[^c]+\\n", "(a|\\n)+", "\\n\\n", "a.*\\n.*c", "^\\w*\\n",
+        "c\\b\\n", "ab\\nA", "[Aa][Bb]\\n", "\\n$", "x?\\n",
+    };
+    std::mt19937 random(17);
+    const std::string alphabet = "abcA _";
+    RegexMatcher matcher;
+    for (const std::string& pattern : patterns) {
+        ASSERT_EQ(matcher.compile(pattern), RegexMatcher::Status::COMPILED) << pattern;
+        EXPECT_TRUE(matcher.is_multiline()) << pattern;
+        std::regex reference(pattern, std::regex::ECMAScript | std::regex::multiline);
+        for (int round = 0; round < 40; ++round) {
+            std::deque<std::string> rows(1 + random() % 5);
+            std::string joined;
+            std::vector<size_t> offsets;
+            for (std::string& row : rows) {
+                for (size_t i = random() % 6; i > 0; --i) row += alphabet[random() % alphabet.size()];
+                offsets.push_back(joined.size());
+                joined += row + "\n";
+            }
+            joined.pop_back();
+
+            for (size_t row = 0; row < rows.size(); ++row) {
+                for (size_t col = 0; col <= rows[row].size(); ++col) {
+                    size_t offset = offsets[row] + col;
+                    std::smatch match;
+                    auto flags = offset > 0 ? std::regex_constants::match_prev_avail : std::regex_constants::match_default;
+                    bool expected = std::regex_search(joined.cbegin() + offset, joined.cend(), match, reference, flags);
+
+                    RegexMatcher::Position from{row, col}, start, end;
+                    bool found = matcher.search_rows(rows, from, rows.size(), start, end);
+                    ASSERT_EQ(found, expected) << pattern << " in \"" << joined << "\" from " << offset;
+                    if (found) {
+                        ASSERT_EQ(offsets[start.row] + start.col, offset + match.position()) << pattern << " in \"" << joined << "\" from " << offset;
+                        ASSERT_EQ(offsets[end.row] + end.col, offset + match.position() + match.length()) << pattern << " in \"" << joined << "\"";
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(RegexMatcherTest, StopsAtTheLastRowAsked) {
+    RegexMatcher matcher;
+    ASSERT_EQ(matcher.compile("a\\nb"), RegexMatcher::Status::COMPILED);
+    std::deque<std::string> rows = {"x", "xa", "b", "a", "b"};
+
+    // Nothing starts before row 1: the next search goes on from there
+    RegexMatcher::Position from{0, 0}, start, end;
+    EXPECT_FALSE(matcher.search_rows(rows, from, 1, start, end));
+    EXPECT_EQ(from.row, 1u);
+    EXPECT_EQ(from.col, 0u);
+
+    // A match that starts before the last row asked ends past it
+    ASSERT_TRUE(matcher.search_rows(rows, from, 2, start, end));
+    EXPECT_EQ(start.row, 1u);
+    EXPECT_EQ(start.col, 1u);
+    EXPECT_EQ(end.row, 2u);
+    EXPECT_EQ(end.col, 1u);
+    ASSERT_TRUE(matcher.search_rows(rows, from, rows.size(), start, end));
+    EXPECT_EQ(start.row, 3u);
+    EXPECT_FALSE(matcher.search_rows(rows, from, rows.size(), start, end));
+    EXPECT_EQ(from.row, rows.size());
+
+    // A per-row search never sees a line break
+    size_t begin, finish;
+    EXPECT_FALSE(matcher.search("xa", 0, begin, finish));
+    ASSERT_EQ(matcher.compile("a\\s*b"), RegexMatcher::Status::COMPILED);
+    EXPECT_FALSE(matcher.is_multiline());
+}
+
+/*
+    g++ -std=c++17 -o test_regex_matcher test_regexMatcher.cpp ../src/regexMatcher.cpp ../src/literalFinder.cpp -lgtest -lgtest_main -lpthread
+*/
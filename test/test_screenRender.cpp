@@ -0,0 +1,107 @@
+#include <gtest/gtest.h>
+#include "../include/screen.hpp"
+#include "../include/editor.hpp"
+#include "../include/syntax.hpp"
+
+// Renders on an in-memory CellGrid: no terminal involved
+class ScreenRenderTest : public ::testing::Test {
+protected:
+    CellGrid grid{6, 30};
+
+    void SetUp() override {
+        Screen::getScreen().set_surface(&grid);
+        Screen::getScreen().invalidate_render_cache();
+
+        // Load the languages now, then drop any warning it left in the status bar
+        SyntaxHighlighter::instance();
+        Screen::getScreen().set_status_message("");
+
+        buffer.clear();
+        buffer.push_back("first row");
+        buffer.push_back("second row");
+        buffer.push_back("third row");
+
+        mode = Mode::normal;
+        pointed_file = "notes.txt";
+        pointed_row = 0;
+        pointed_col = 0;
+        starting_row = 0;
+        starting_col = 0;
+        max_row = grid.rows() - 1;
+        max_col = grid.cols() - span - 1;
+
+        // Distinct color pairs, no color scheme is loaded without a terminal
+        textColor = 1;
+        numberRowsColor = 2;
+        highlightedTextColor = 3;
+    }
+
+    void TearDown() override {
+        Screen::getScreen().set_surface(nullptr);
+    }
+};
+
+TEST_F(ScreenRenderTest, DrawsGutterTextAndStatusBar) {
+    Screen::getScreen().update();
+
+    EXPECT_EQ(grid.row_text(0), "1    first row");
+    EXPECT_EQ(grid.row_text(1), "2    second row");
+    EXPECT_EQ(grid.row_text(2), "3    third row");
+    EXPECT_EQ(grid.row_text(3), "");
+    EXPECT_EQ(grid.row_text(4), "");
+    EXPECT_EQ(grid.row_text(5), " NORMAL  | notes.txt | 1:1");
+
+    EXPECT_EQ(grid.pair_at(0, 0), numberRowsColor);
+    EXPECT_TRUE(grid.at(5, 0) & A_REVERSE);
+}
+
+TEST_F(ScreenRenderTest, ScrollAndHorizontalOffset) {
+    Screen::getScreen().update();
+
+    starting_row = 1;
+    starting_col = 3;
+    Screen::getScreen().update();
+
+    EXPECT_EQ(grid.row_text(0), "2    ond row");
+    EXPECT_EQ(grid.row_text(1), "3    rd row");
+    EXPECT_EQ(grid.row_text(2), "");
+}
+
+TEST_F(ScreenRenderTest, ShorterBufferClearsOldRows) {
+    Screen::getScreen().update();
+
+    buffer.del_row(2);
+    buffer.del_row(1);
+    Screen::getScreen().update();
+
+    EXPECT_EQ(grid.row_text(0), "1    first row");
+    EXPECT_EQ(grid.row_text(1), "");
+    EXPECT_EQ(grid.row_text(2), "");
+}
+
+TEST_F(ScreenRenderTest, VisualSelectionIsRecolored) {
+    mode = Mode::visual;
+    visual_start_row = 0;
+    visual_start_col = 0;
+    pointed_row = 0;
+    pointed_col = 4;
+
+    Screen::getScreen().update();
+    editor::visual::highlight_selected();
+
+    // "first" is selected, the rest of the row keeps the text color
+    for (int x = span + 1; x < span + 1 + 5; ++x) {
+        EXPECT_EQ(grid.pair_at(0, x), highlightedTextColor) << "column " << x;
+    }
+    EXPECT_EQ(grid.pair_at(0, span + 1 + 6), textColor);
+    EXPECT_EQ(grid.row_text(0), "1    first row");
+
+    // The next frame draws the row again without the selection
+    mode = Mode::normal;
+    Screen::getScreen().update();
+    EXPECT_EQ(grid.pair_at(0, span + 1), textColor);
+}
+
+/*
+    g++ -std=c++17 -o test_screen_render test_screenRender.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <pty.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <iostream>
+#include "../include/screen.hpp"
+#include "../include/editor.hpp"
+#include "../include/editorStats.hpp"
+
+// Draws the buffer on a pseudo terminal and counts the bytes ncurses writes
+// to it, to check that one-line scrolls are not repainted in full.
+class ScreenScrollTest : public ::testing::Test {
+protected:
+    int master = -1;
+    int slave = -1;
+    FILE* term_out = nullptr;
+    FILE* term_in = nullptr;
+    SCREEN* term = nullptr;
+
+    void SetUp() override {
+        struct winsize size = {24, 80, 0, 0};
+        ASSERT_EQ(openpty(&master, &slave, nullptr, nullptr, &size), 0);
+        fcntl(master, F_SETFL, O_NONBLOCK);
+
+        term_out = fdopen(dup(slave), "w");
+        term_in = fdopen(dup(slave), "r");
+        term = newterm("xterm", term_out, term_in);
+        ASSERT_NE(term, nullptr);
+        set_term(term);
+
+        buffer.clear();
+        for (int i = 0; i < 1000; ++i) {
+            buffer.push_back("int line_" + std::to_string(i) + " = " + std::to_string(i * 7) + "; // some text");
+        }
+        mode = Mode::normal;
+        starting_row = 0;
+        starting_col = 0;
+        max_row = 23;
+        max_col = 80 - span - 1;
+        pointed_window = newwin(max_row, 80, 0, 0);
+    }
+
+    void TearDown() override {
+        delwin(pointed_window);
+        pointed_window = nullptr;
+        endwin();
+        delscreen(term);
+        fclose(term_out);
+        fclose(term_in);
+        close(slave);
+        close(master);
+    }
+
+    // Bytes written to the terminal since the last call
+    size_t drain() {
+        fflush(term_out);
+        size_t total = 0;
+        char chunk[4096];
+        pollfd pending = {master, POLLIN, 0};
+        while (poll(&pending, 1, 20) > 0) {
+            ssize_t n = read(master, chunk, sizeof(chunk));
+            if (n <= 0) break;
+            total += n;
+        }
+        return total;
+    }
+
+    size_t frame() {
+        Screen::getScreen().print_buffer();
+        wnoutrefresh(pointed_window);
+        doupdate();
+        return drain();
+    }
+
+    // Bytes of a frame drawn from scratch, as after a resize
+    size_t full_repaint() {
+        clearok(curscr, TRUE);
+        return frame();
+    }
+
+    // Average bytes per step while scrolling down one line at a time
+    size_t bytes_per_scroll() {
+        frame();
+        size_t total = 0;
+        const int steps = 50;
+        for (int i = 0; i < steps; ++i) {
+            starting_row++;
+            total += frame();
+        }
+        return total / steps;
+    }
+};
+
+TEST_F(ScreenScrollTest, ScrollShowsTheRightRows) {
+    frame();
+    starting_row = 10;
+    frame();
+
+    // The window now starts with row 10
+    chtype cells[64];
+    mvwinchnstr(pointed_window, 0, span + 1, cells, buffer[10].size());
+    std::string shown;
+    for (size_t i = 0; i < buffer[10].size(); ++i) shown += (char)(cells[i] & A_CHARTEXT);
+    EXPECT_EQ(shown, buffer[10]);
+
+    starting_row = 9;
+    frame();
+    mvwinchnstr(pointed_window, 1, span + 1, cells, buffer[10].size());
+    shown.clear();
+    for (size_t i = 0; i < buffer[10].size(); ++i) shown += (char)(cells[i] & A_CHARTEXT);
+    EXPECT_EQ(shown, buffer[10]);
+}
+
+TEST_F(ScreenScrollTest, OneLineScrollSendsLessThanARepaint) {
+    idlok(pointed_window, TRUE);
+    frame();
+    size_t repaint = full_repaint();
+    size_t scrolled = bytes_per_scroll();
+
+    std::cout << "bytes per one-line scroll: " << scrolled
+              << " (full repaint " << repaint << ")" << std::endl;
+    EXPECT_LT(scrolled * 4, repaint);
+}
+
+TEST_F(ScreenScrollTest, ScrollReusesTheCachedRows) {
+    frame();
+    unsigned long built = EditorStats::instance().rows_built;
+    starting_row = 1;
+    frame();
+
+    // Only the row exposed at the bottom had to be built
+    EXPECT_EQ(EditorStats::instance().rows_built - built, 1u);
+}
+
+/*
+    g++ -std=c++17 -o test_screen_scroll test_screenScroll.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses -lutil
+*/
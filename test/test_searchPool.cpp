@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "../include/searchPool.hpp"
+#include "../include/incrementalSearch.hpp"
+
+class SearchPoolTest : public ::testing::Test {
+protected:
+    SearchPool& pool = SearchPool::instance();
+
+    void SetUp() override {
+        pool.resize(4);
+        IncrementalSearch::instance().clear();
+        buffer.clear();
+        for (int i = 0; i < 20000; ++i) {
+            buffer.push_back(i % 3 == 0 ? "log " + std::to_string(i) + " error: code " + std::to_string(i % 97)
+                                        : "log " + std::to_string(i) + " ok [" + std::to_string(i % 5) + "]");
+        }
+    }
+
+    void TearDown() override {
+        pool.resize(std::thread::hardware_concurrency());
+    }
+
+    // One row after the other on this thread
+    std::vector<std::pair<int, int>> serial(const std::string& term) {
+        SearchPattern pattern;
+        pattern.compile(term);
+        std::vector<editor::SearchMatch> matches;
+        for (int row = 0; row < buffer.getSize(); ++row) pattern.matches(buffer[row], row, matches);
+        std::vector<std::pair<int, int>> positions;
+        for (const auto& match : matches) positions.push_back({match.row, match.col});
+        return positions;
+    }
+
+    std::vector<std::pair<int, int>> parallel(const std::string& term) {
+        editor::find::find_all_occurrence(term);
+        std::vector<std::pair<int, int>> positions;
+        for (const auto& match : editor::found_occurrences) positions.push_back({match.row, match.col});
+        return positions;
+    }
+};
+
+TEST_F(SearchPoolTest, MatchesComeInRowOrder) {
+    for (const std::string& term : {"error", "code 9\\d\\b", "(\\d)\\1", "[", "ok \\[4]$"}) {
+        auto expected = serial(term);
+        EXPECT_FALSE(expected.empty()) << term;
+        EXPECT_EQ(parallel(term), expected) << term;
+    }
+}
+
+TEST_F(SearchPoolTest, EachChunkKeepsItsOwnOrder) {
+    std::shared_ptr<SearchPattern> pattern = IncrementalSearch::instance().compiled("error");
+    std::vector<SearchPool::Chunk> chunks(16);
+    for (int row = 0; row < 1600; ++row) {
+        // Rows searched backwards within each chunk
+        chunks[row / 100].rows.insert(chunks[row / 100].rows.begin(), row);
+    }
+    pool.search(buffer.get_buffer(), pattern, chunks);
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        std::vector<int> rows;
+        for (const auto& match : chunks[i].matches) rows.push_back(match.row);
+        std::vector<int> expected;
+        for (int row = (int)i * 100 + 99; row >= (int)i * 100; --row) {
+            if (row % 3 == 0) expected.push_back(row);
+        }
+        EXPECT_EQ(rows, expected) << "chunk " << i;
+    }
+}
+
+TEST_F(SearchPoolTest, SearchesFromAnyNumberOfThreads) {
+    auto expected = serial("code [1-3]");
+    for (size_t threads : {1u, 2u, 7u}) {
+        pool.resize(threads);
+        EXPECT_EQ(parallel("code [1-3]"), expected) << threads;
+    }
+}
+
+/*
+    g++ -std=c++17 -o test_search_pool test_searchPool.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
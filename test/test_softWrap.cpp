@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../include/lineIndex.hpp"
+#include "../include/softWrap.hpp"
+#include "../include/screen.hpp"
+#include "../include/editor.hpp"
+
+// --- LineIndex ---
+
+TEST(LineIndexTest, PrefixAndFind) {
+    LineIndex<uint32_t> index;
+    index.assign({1, 3, 2, 1});
+
+    EXPECT_EQ(index.size(), 4u);
+    EXPECT_EQ(index.total(), 7u);
+    EXPECT_EQ(index.prefix(0), 0u);
+    EXPECT_EQ(index.prefix(2), 4u);
+    EXPECT_EQ(index.prefix(4), 7u);
+
+    EXPECT_EQ(index.find(0), 0u);
+    EXPECT_EQ(index.find(1), 1u);
+    EXPECT_EQ(index.find(3), 1u);
+    EXPECT_EQ(index.find(4), 2u);
+    EXPECT_EQ(index.find(6), 3u);
+    EXPECT_EQ(index.find(7), 4u);
+}
+
+TEST(LineIndexTest, MatchesAVectorUnderRandomEdits) {
+    std::mt19937 rng(7);
+    std::vector<uint32_t> model(1000);
+    for (auto& w : model) w = rng() % 5 + 1;
+
+    LineIndex<uint32_t> index;
+    index.assign(model);
+
+    for (int step = 0; step < 3000; ++step) {
+        size_t row = rng() % (model.size() + 1);
+        switch (rng() % 3) {
+            case 0:
+                if (row < model.size()) {
+                    model[row] = rng() % 5 + 1;
+                    index.set(row, model[row]);
+                }
+                break;
+            case 1:
+                model.insert(model.begin() + row, 2, 3);
+                index.insert(row, 2, 3);
+                break;
+            case 2:
+                if (row < model.size()) {
+                    model.erase(model.begin() + row);
+                    index.erase(row, 1);
+                }
+                break;
+        }
+    }
+
+    ASSERT_EQ(index.size(), model.size());
+    uint64_t acc = 0;
+    for (size_t r = 0; r < model.size(); ++r) {
+        ASSERT_EQ(index.at(r), model[r]);
+        ASSERT_EQ(index.prefix(r), acc);
+        ASSERT_EQ(index.find(acc), r);
+        acc += model[r];
+    }
+    EXPECT_EQ(index.total(), acc);
+}
+
+// --- SoftWrap ---
+
+class SoftWrapTest : public ::testing::Test {
+protected:
+    CellGrid grid{6, 15};  // 10 text columns
+
+    void SetUp() override {
+        Screen::getScreen().set_surface(&grid);
+        Screen::getScreen().invalidate_render_cache();
+
+        buffer.clear();
+        buffer.push_back("short");
+        buffer.push_back("a row that wraps twice");
+        buffer.push_back("end");
+
+        soft_wrap = true;
+        mode = Mode::normal;
+        pointed_row = 0;
+        pointed_col = 0;
+        starting_row = 0;
+        starting_col = 0;
+        max_row = grid.rows() - 1;
+        max_col = grid.cols() - span - 1;
+    }
+
+    void TearDown() override {
+        soft_wrap = false;
+        Screen::getScreen().set_surface(nullptr);
+    }
+};
+
+TEST_F(SoftWrapTest, LongRowsTakeSeveralLines) {
+    Screen::getScreen().print_buffer();
+
+    EXPECT_EQ(grid.row_text(0), "1    short");
+    EXPECT_EQ(grid.row_text(1), "2    a row that");
+    EXPECT_EQ(grid.row_text(2), "      wraps twi");
+    EXPECT_EQ(grid.row_text(3), "     ce");
+    EXPECT_EQ(grid.row_text(4), "3    end");
+}
+
+TEST_F(SoftWrapTest, IndexFollowsEdits) {
+    SoftWrap& wrap = SoftWrap::instance();
+    wrap.sync(buffer, max_col);
+    EXPECT_EQ(wrap.line_of(2), 4u);
+
+    buffer.set_row(0, std::string(25, 'x'));   // 3 lines
+    buffer.new_row("", 1);                     // 1 line
+    buffer.del_row(3);                         // the end row goes
+    wrap.sync(buffer, max_col);
+
+    EXPECT_EQ(wrap.line_of(1), 3u);
+    EXPECT_EQ(wrap.line_of(2), 4u);
+    EXPECT_EQ(wrap.total_lines(), 7u);
+    EXPECT_EQ(wrap.row_at(5), 2u);
+}
+
+TEST_F(SoftWrapTest, CursorOnWrappedLineAndMouseHit) {
+    pointed_row = 1;
+    pointed_col = 13;   // the 'a' of "wraps"... on the second screen line
+    SoftWrap::instance().follow_cursor();
+
+    EXPECT_EQ(cursor.getY(), 2);
+    EXPECT_EQ(cursor.getX(), 3);
+
+    int row, col;
+    SoftWrap::instance().hit(3, span + 1 + 1, row, col);
+    EXPECT_EQ(row, 1);
+    EXPECT_EQ(col, 21);
+}
+
+TEST_F(SoftWrapTest, ScrollKeepsTheCursorVisible) {
+    buffer.clear();
+    for (int i = 0; i < 100; ++i) buffer.push_back(std::string(i % 3 == 0 ? 25 : 4, 'y'));
+
+    for (pointed_row = 0; pointed_row < 100; ++pointed_row) {
+        SoftWrap::instance().follow_cursor();
+        ASSERT_GE(cursor.getY(), 0);
+        ASSERT_LT(cursor.getY(), (int)max_row);
+        ASSERT_LE(starting_row, pointed_row);
+    }
+}
+
+/*
+    g++ -std=c++17 -o test_soft_wrap test_softWrap.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
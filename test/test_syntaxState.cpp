@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "../include/syntaxState.hpp"
+#include "../include/syntax.hpp"
+#include "../include/screen.hpp"
+#include "../include/editor.hpp"
+#include "../include/editorStats.hpp"
+#include "testLanguages.hpp"
+
+class SyntaxStateTest : public ::testing::Test {
+protected:
+    CellGrid grid{6, 30};
+
+    void SetUp() override {
+        Screen::getScreen().set_surface(&grid);
+        Screen::getScreen().invalidate_render_cache();
+
+        ASSERT_TRUE(use_test_language("state.c"));
+        Screen::getScreen().set_status_message("");
+
+        buffer.clear();
+        for (int i = 0; i < 1000; ++i) buffer.push_back("int x;");
+
+        mode = Mode::normal;
+        pointed_file = "state.c";
+        pointed_row = 0;
+        pointed_col = 0;
+        starting_row = 0;
+        starting_col = 0;
+        max_row = grid.rows() - 1;
+        max_col = grid.cols() - span - 1;
+
+        textColor = 1;
+        commentsColor = 4;
+    }
+
+    void TearDown() override {
+        Screen::getScreen().set_surface(nullptr);
+    }
+
+    // Rows lexed to know the state at the end of the file
+    unsigned long lexed_to_end(bool& state) {
+        unsigned long before = EditorStats::instance().rows_lexed;
+        state = SyntaxStateCache::instance().state_before(buffer, buffer.getSize());
+        return EditorStats::instance().rows_lexed - before;
+    }
+};
+
+TEST_F(SyntaxStateTest, CommentOpenedAboveTheWindow) {
+    buffer.set_row(1, "/* opened here");
+    starting_row = 3;
+    Screen::getScreen().print_buffer();
+
+    EXPECT_EQ(grid.row_text(0), "4    int x;");
+    EXPECT_EQ(grid.pair_at(0, span + 1), commentsColor);
+}
+
+TEST_F(SyntaxStateTest, EditsRelexOnlyUntilTheStateMatches) {
+    bool state;
+    lexed_to_end(state);
+    EXPECT_FALSE(state);
+
+    // A row that leaves the state alone costs one row
+    buffer.set_row(500, "int y; // changed");
+    EXPECT_EQ(lexed_to_end(state), 1u);
+    EXPECT_FALSE(state);
+
+    // Opening a comment spreads to the end of the file
+    buffer.set_row(30, "/* opened");
+    EXPECT_EQ(lexed_to_end(state), 970u);
+    EXPECT_TRUE(state);
+
+    // Closing it a few rows below brings the rest of the file back out
+    buffer.new_row("*/", 40);
+    EXPECT_EQ(lexed_to_end(state), 961u);
+    EXPECT_FALSE(state);
+
+    // An edit inside the comment, and one that closes it earlier, stop at the old close
+    buffer.set_row(35, "still a comment");
+    EXPECT_EQ(lexed_to_end(state), 1u);
+    buffer.set_row(33, "*/ closed early");
+    EXPECT_EQ(lexed_to_end(state), 8u);
+    EXPECT_FALSE(state);
+
+    buffer.del_row(30);
+    EXPECT_EQ(lexed_to_end(state), 3u);
+    EXPECT_FALSE(state);
+}
+
+/*
+    g++ -std=c++17 -o test_syntax_state test_syntaxState.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
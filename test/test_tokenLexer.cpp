@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include "../include/tokenLexer.hpp"
+#include "../include/syntax.hpp"
+#include "../include/editor.hpp"
+#include "testLanguages.hpp"
+
+// One letter per byte: t(ext), i(dentifier), T(ype), n(umber), s(tring), c(omment)
+static std::string kinds(const TokenLexer& lexer, const std::string& text, bool& in_comment) {
+    std::string out(text.size(), '?');
+    in_comment = lexer.scan(text, 0, text.size(), in_comment, [&](size_t from, size_t to, TokenLexer::Token token) {
+        static const char letters[] = "tiTnsc";
+        for (size_t i = from; i < to; ++i) out[i] = letters[(int)token];
+    });
+    return out;
+}
+
+static std::string kinds(const TokenLexer& lexer, const std::string& text) {
+    bool in_comment = false;
+    return kinds(lexer, text, in_comment);
+}
+
+static TokenLexer c_like() {
+    TokenRules rules;
+    rules.stringDelimiters = "\"'";
+    rules.numberStart = TokenLexer::expand_set("0-9");
+    rules.numberChars = "0-9a-zA-Z_.";
+    rules.identifierStart = "a-zA-Z_";
+    rules.identifierChars = "a-zA-Z0-9_";
+    rules.typeStart = "A-Z";
+    rules.lineComment = "//";
+    rules.blockStart = "/*";
+    rules.blockEnd = "*/";
+    TokenLexer lexer;
+    lexer.build(rules);
+    return lexer;
+}
+
+TEST(TokenLexerTest, ExpandsCharacterSets) {
+    EXPECT_EQ(TokenLexer::expand_set("a-d_"), "abcd_");
+    EXPECT_EQ(TokenLexer::expand_set("-x-"), "-x-");
+}
+
+TEST(TokenLexerTest, SplitsStringsNumbersAndIdentifiers) {
+    TokenLexer lexer = c_like();
+    EXPECT_EQ(kinds(lexer, "x1 = 0x1Fu + 2.5;"),
+                           "iitttnnnnntttnnnt");
+    EXPECT_EQ(kinds(lexer, "s = \"a\\\"b\" + 'c';"),
+                           "itttsssssstttssst");
+    EXPECT_EQ(kinds(lexer, "Point p"),
+                           "TTTTTti");
+}
+
+TEST(TokenLexerTest, UnterminatedStringRunsToTheEnd) {
+    TokenLexer lexer = c_like();
+    EXPECT_EQ(kinds(lexer, "x \"open"), "itsssss");
+}
+
+TEST(TokenLexerTest, QuotesInCommentsOpenNoString) {
+    TokenLexer lexer = c_like();
+    bool in_comment = false;
+    EXPECT_EQ(kinds(lexer, "/* don't */ if (x) { y = 5; }", in_comment),
+                           "ccccccccccctiittittttitttnttt");
+    EXPECT_FALSE(in_comment);
+
+    // A row that starts inside a comment
+    in_comment = true;
+    EXPECT_EQ(kinds(lexer, "it's */ x = 1;", in_comment),
+                           "ccccccctitttnt");
+    EXPECT_FALSE(in_comment);
+
+    // Delimiters inside strings, and a comment left open
+    EXPECT_EQ(kinds(lexer, "s = \"/*\"; // it's", in_comment),
+                           "itttssssttccccccc");
+    EXPECT_FALSE(in_comment);
+    EXPECT_EQ(kinds(lexer, "a/*/ \"b", in_comment),
+                           "icccccc");
+    EXPECT_TRUE(in_comment);
+    EXPECT_FALSE(lexer.ends_in_comment("no end \"*/", true));
+    EXPECT_FALSE(lexer.ends_in_comment("x = \"/*\";", false));
+    EXPECT_TRUE(lexer.ends_in_comment("x = 1; /* open", false));
+}
+
+TEST(TokenLexerTest, CommentDelimitersThatStartLikeOtherTokens) {
+    // Python: """ opens a comment though " opens a string
+    TokenRules python;
+    python.stringDelimiters = "\"'";
+    python.identifierStart = "a-z";
+    python.lineComment = "#";
+    python.blockStart = "\"\"\"";
+    python.blockEnd = "\"\"\"";
+    TokenLexer lexer;
+    lexer.build(python);
+    bool in_comment = false;
+    EXPECT_EQ(kinds(lexer, "x = \"\" + \"\"\"doc \"\" # \"\"\" y", in_comment),
+                           "itttsstttcccccccccccccccti");
+    EXPECT_FALSE(in_comment);
+    EXPECT_EQ(kinds(lexer, "\"\"\"open", in_comment), "ccccccc");
+    EXPECT_TRUE(in_comment);
+
+    // Lua: --[[ opens a multi-line comment though -- opens a line comment
+    TokenRules lua;
+    lua.identifierStart = "a-z";
+    lua.lineComment = "--";
+    lua.blockStart = "--[[";
+    lua.blockEnd = "]]";
+    lexer.build(lua);
+    in_comment = false;
+    EXPECT_EQ(kinds(lexer, "a - b -- c", in_comment), "itttitcccc");
+    EXPECT_FALSE(in_comment);
+    EXPECT_EQ(kinds(lexer, "a --[[ b ]] c --[", in_comment), "itccccccccctitccc");
+    EXPECT_FALSE(in_comment);
+    EXPECT_EQ(kinds(lexer, "--[[", in_comment), "cccc");
+    EXPECT_TRUE(in_comment);
+}
+
+TEST(TokenLexerTest, EmptyRulesGiveAnEmptyLexer) {
+    TokenLexer lexer;
+    lexer.build(TokenRules());
+    EXPECT_TRUE(lexer.empty());
+    EXPECT_EQ(kinds(lexer, "abc"), "???");
+}
+
+TEST(TokenLexerTest, StringsCoverKeywordsWhenStyling) {
+    ASSERT_TRUE(use_test_language("tokens.c"));
+
+    textColor = 1;
+    keyWordColor = 2;
+    stringColor = 3;
+    numberColor = 4;
+
+    std::string row = "int n = 42; s = \"if\";";
+    std::vector<color> colors(row.size(), textColor);
+    bool in_comment = false;
+    editor::visual::style_keywords(row, colors, in_comment);
+
+    EXPECT_EQ(colors[0], keyWordColor);      // int
+    EXPECT_EQ(colors[4], textColor);         // n
+    EXPECT_EQ(colors[8], numberColor);       // 42
+    EXPECT_EQ(colors[16], stringColor);      // "
+    EXPECT_EQ(colors[17], stringColor);      // if, inside the string
+
+    // A quote inside a comment opens no string
+    commentsColor = 5;
+    row = "/* don't */ if (x) { y = 5; }";
+    colors.assign(row.size(), textColor);
+    editor::visual::style_keywords(row, colors, in_comment);
+    EXPECT_EQ(colors[4], commentsColor);     // don't
+    EXPECT_EQ(colors[12], keyWordColor);     // if
+    EXPECT_EQ(colors[25], numberColor);      // 5
+    EXPECT_FALSE(in_comment);
+}
+
+/*
+    g++ -std=c++17 -o test_token_lexer test_tokenLexer.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
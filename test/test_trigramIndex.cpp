@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "../include/trigramIndex.hpp"
+#include "../include/incrementalSearch.hpp"
+
+class TrigramIndexTest : public ::testing::Test {
+protected:
+    TrigramIndex& index = TrigramIndex::instance();
+    size_t saved_rows = search_index_rows;
+
+    void SetUp() override {
+        search_index_rows = 1000;
+        IncrementalSearch::instance().clear();
+        buffer = textBuffer();
+        std::mt19937 random(3);
+        const char* words[] = {"alpha", "Beta", "gamma", "delta", "error", "ok", "[x]", "Id_42"};
+        buffer.set_row(0, "start");
+        for (int i = 1; i < 20000; ++i) {
+            std::string row;
+            for (int w = 0; w < 4; ++w) row += std::string(words[random() % 6]) + " ";
+            if (i % 997 == 0) row += "rare_token " + std::to_string(i);
+            if (i % 3001 == 0) row += words[6 + i % 2];
+            buffer.push_back(row);
+        }
+    }
+
+    void TearDown() override {
+        search_index_rows = saved_rows;
+    }
+
+    void build() {
+        while (index.schedule(buffer)) index.wait_idle();
+    }
+
+    // One row after the other, without the index
+    std::vector<std::pair<int, int>> serial(const std::string& term) {
+        SearchPattern pattern;
+        pattern.compile(term);
+        std::vector<editor::SearchMatch> matches;
+        for (int row = 0; row < buffer.getSize(); ++row) pattern.matches(buffer[row], row, matches);
+        std::vector<std::pair<int, int>> positions;
+        for (const auto& match : matches) positions.push_back({match.row, match.col});
+        return positions;
+    }
+
+    std::vector<std::pair<int, int>> indexed(const std::string& term) {
+        editor::find::find_all_occurrence(term);
+        std::vector<std::pair<int, int>> positions;
+        for (const auto& match : editor::found_occurrences) positions.push_back({match.row, match.col});
+        return positions;
+    }
+
+    size_t candidate_rows(const std::string& term) {
+        std::vector<int> rows;
+        return index.candidates(buffer, IncrementalSearch::instance().compiled(term)->literals(), rows) ? rows.size() : buffer.getSize();
+    }
+};
+
+TEST_F(TrigramIndexTest, FindsWhatAFullScanFinds) {
+    build();
+    EXPECT_GT(index.bytes(buffer), 0u);
+    for (const std::string& term : {"rare_token", "RARE_TOKEN 9\\d7", "rare_\\w+ 1\\d{4}$", "[Ii]d_42", "\\[x]", "beta", "Beta gamma",
+                                    "(rare|err)or", "ok", "nothing_like_this"}) {
+        EXPECT_EQ(indexed(term), serial(term)) << term;
+    }
+
+    // Only the blocks holding the rare texts are searched
+    EXPECT_LE(candidate_rows("rare_token"), 20u * 128);   // a block for each
+    EXPECT_LT(candidate_rows("Id_42"), 7u * 128);
+    EXPECT_EQ(candidate_rows("nothing_like_this"), 0u);
+    EXPECT_EQ(candidate_rows("gamma"), (size_t)buffer.getSize());   // everywhere: not worth it
+    EXPECT_EQ(candidate_rows("ok"), (size_t)buffer.getSize());      // too short
+}
+
+TEST_F(TrigramIndexTest, FollowsTheEdits) {
+    build();
+    buffer.set_row(5, "a rare_token in a new place");
+    buffer.new_row("rare_token inserted", 10000);
+    buffer.del_row(2000);
+    for (int i = 0; i < 300; ++i) buffer.new_row("more rare_token rows", 15000);
+    buffer.new_row("the last rare_token", buffer.getSize());
+
+    // Before the edited blocks are indexed again, and after
+    EXPECT_EQ(indexed("rare_token"), serial("rare_token"));
+    EXPECT_LT(candidate_rows("rare_token"), 30u * 128);
+    build();
+    EXPECT_EQ(indexed("rare_token"), serial("rare_token"));
+    EXPECT_LT(candidate_rows("rare_token"), 30u * 128);
+
+    // Rows taken away across several blocks
+    buffer.set_row(3, "rare_token");
+    for (int i = 0; i < 400; ++i) buffer.del_row(100);
+    EXPECT_EQ(indexed("rare_token"), serial("rare_token"));
+    build();
+    EXPECT_EQ(indexed("rare_token"), serial("rare_token"));
+}
+
+TEST_F(TrigramIndexTest, NarrowsWhileBuilding) {
+    // Nothing indexed yet: every row is a candidate
+    EXPECT_EQ(candidate_rows("rare_token"), (size_t)buffer.getSize());
+    index.schedule(buffer);
+    index.wait_idle();
+    EXPECT_EQ(indexed("rare_token"), serial("rare_token"));
+    build();
+    EXPECT_LE(candidate_rows("rare_token"), 20u * 128);   // a block for each
+}
+
+/*
+    g++ -std=c++17 -o test_trigram_index test_trigramIndex.cpp $(ls ../src/*.cpp | grep -v main.cpp) -lgtest -lgtest_main -lpthread -lncurses
+*/
@@ -2,6 +2,7 @@
 #include "../include/editor.hpp"
 #include "../include/textBuffer.hpp"
 #include "../include/cursor.hpp"
+#include <regex>
 
 // Define a Test Fixture to reset global state before each test
 class UndoTest : public ::testing::Test {
@@ -139,4 +140,94 @@ TEST_F(UndoTest, UndoDeleteRow) {
     // Assert State
     EXPECT_EQ(buffer.getSize(), 2);
     EXPECT_EQ(buffer[1], "Row2"); // Row2 restored
-}
\ No newline at end of file
+}
+
+TEST_F(UndoTest, UndoReplaceAllInOneStep) {
+    // Setup: matches of different lengths, several in a row, rows without any
+    buffer[0] = "a1 b22 a333";
+    buffer.new_row("none", 1);
+    buffer.new_row("a4a55", 2);
+    buffer.new_row("a1234 a1 a1 a1 a1", 3);
+    for (int i = 4; i < 20000; ++i) buffer.new_row(i % 2 ? "x a" + std::to_string(i) + " a" + std::to_string(i % 10) : "y", i);
+    std::deque<std::string> original = buffer.get_buffer();
+
+    // Shorter, as long as or longer than the matches, or some of each
+    for (const std::string term : {"#", "<>", "[a match]", "<->", ""}) {
+        editor::find::find_all_occurrence("a\\d+");
+
+        // Action: Replace every match
+        editor::modify::replace_all(term);
+
+        // Assert State
+        for (size_t row = 0; row < original.size(); ++row) {
+            ASSERT_EQ(buffer[row], std::regex_replace(original[row], std::regex("a\\d+"), term)) << '"' << term << "\", row " << row;
+        }
+        EXPECT_EQ(editor::action_history.size(), 1u);
+
+        // Undo
+        editor::modify::undo();
+
+        // Assert State
+        EXPECT_EQ(buffer.get_buffer(), original) << term;
+        EXPECT_TRUE(editor::action_history.empty());
+    }
+}
+
+TEST_F(UndoTest, UndoReplaceAcrossRowsInOneStep) {
+    // Setup: calls broken over several rows, a match joining two others, rows without any
+    buffer[0] = "f(";
+    buffer.new_row("  a, b)", 1);
+    for (int i = 2; i < 20000; ++i) buffer.new_row(i % 3 == 0 ? "g(" : i % 3 == 1 ? "  x(" : "y)", i);
+    buffer.new_row("end", 20000);
+    std::deque<std::string> original = buffer.get_buffer();
+    std::string joined;
+    for (const std::string& row : original) joined += row + "\n";
+    joined.pop_back();
+
+    for (const std::string term : {"(", "", "( "}) {
+        editor::find::find_all_occurrence("\\(\\n\\s*");
+
+        // Action: Replace every match
+        editor::modify::replace_all(term);
+
+        // Assert State: the rows std::regex gives on the whole text
+        std::string replaced = std::regex_replace(joined, std::regex("\\(\\n\\s*", std::regex::ECMAScript | std::regex::multiline), term);
+        std::deque<std::string> expected;
+        for (size_t from = 0, end = 0; end != std::string::npos; from = end + 1) {
+            end = replaced.find('\n', from);
+            expected.push_back(replaced.substr(from, end == std::string::npos ? end : end - from));
+        }
+        ASSERT_EQ(buffer.get_buffer(), expected) << '"' << term << '"';
+        EXPECT_EQ(editor::action_history.size(), 1u);
+
+        // Undo
+        editor::modify::undo();
+
+        // Assert State
+        EXPECT_EQ(buffer.get_buffer(), original) << term;
+        EXPECT_TRUE(editor::action_history.empty());
+    }
+}
+
+
+TEST_F(UndoTest, UndoReplaceAcrossRowsBelowTheTop) {
+    // Setup: rows above the first match and after the last, which stay as they are
+    buffer[0] = "keep me";
+    buffer.new_row("foo(", 1);
+    buffer.new_row("  bar)", 2);
+    buffer.new_row("also kept", 3);
+    std::deque<std::string> original = buffer.get_buffer();
+    editor::find::find_all_occurrence("\\(\\n\\s*");
+
+    // Action: Replace every match
+    editor::modify::replace_all("(");
+
+    // Assert State
+    EXPECT_EQ(buffer.get_buffer(), (std::deque<std::string>{"keep me", "foo(bar)", "also kept"}));
+
+    // Undo
+    editor::modify::undo();
+
+    // Assert State
+    EXPECT_EQ(buffer.get_buffer(), original);
+}